@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+# control_load.py - measure command-to-effect latency of the control socket
+#
+#   ./build/gui-player --single-instance ~/fixtures/sample.mp4 &
+#   ./control_load.py --seeks 200 --pollers 4 --poll-rate 100
+#
+# While --pollers connections send "status" at --poll-rate requests per
+# second each, a driver connection times:
+#   reply   - request sent -> "ok" received (command handled on the main loop)
+#   seek    - "seek T" sent -> status position within --tolerance of T
+#   pause   - "pause" sent -> status state=PAUSED
+#   play    - "play" sent -> status state=PLAYING
+
+import argparse
+import json
+import os
+import random
+import socket
+import threading
+import time
+
+
+def default_socket():
+    # g_get_user_runtime_dir() falls back to the cache dir
+    runtime = (os.environ.get("XDG_RUNTIME_DIR") or os.environ.get("XDG_CACHE_HOME")
+               or os.path.expanduser("~/.cache"))
+    return os.path.join(runtime, "vidc", "control.sock")
+
+
+class Connection:
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.reader = self.sock.makefile("r", encoding="utf-8")
+
+    def request(self, line):
+        self.sock.sendall((line + "\n").encode("utf-8"))
+        reply = self.reader.readline()
+        if not reply:
+            raise ConnectionError("player closed the connection")
+        return reply.rstrip("\n")
+
+    def status(self):
+        fields = {}
+        for item in self.request("status").split(" ")[1:]:
+            key, _, value = item.partition("=")
+            fields[key] = value
+        return fields
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    rank = max(1, int(round(p * len(values) + 0.4999)))
+    return values[min(rank, len(values)) - 1]
+
+
+def wait_until(conn, predicate, timeout):
+    start = time.monotonic()
+    while time.monotonic() - start < timeout:
+        if predicate(conn.status()):
+            return True
+        time.sleep(0.002)
+    return False
+
+
+def poller(path, rate, stop, latencies):
+    conn = Connection(path)
+    interval = 1.0 / rate if rate > 0 else 0
+    while not stop.is_set():
+        start = time.monotonic()
+        conn.request("status")
+        latencies.append((time.monotonic() - start) * 1000)
+        if interval:
+            time.sleep(max(0.0, interval - (time.monotonic() - start)))
+
+
+def timed(conn, command, predicate, timeout, reply_ms, effect_ms):
+    start = time.monotonic()
+    reply = conn.request(command)
+    reply_ms.append((time.monotonic() - start) * 1000)
+    if not reply.startswith("ok"):
+        raise RuntimeError("%s: %s" % (command, reply))
+    if wait_until(conn, predicate, timeout):
+        effect_ms.append((time.monotonic() - start) * 1000)
+        return True
+    return False
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Load-test the player's control socket")
+    parser.add_argument("--socket", default=default_socket())
+    parser.add_argument("--seeks", type=int, default=100, help="timed seeks")
+    parser.add_argument("--toggles", type=int, default=20, help="timed pause/play pairs")
+    parser.add_argument("--pollers", type=int, default=4, help="background status connections")
+    parser.add_argument("--poll-rate", type=float, default=100, help="status requests/s per poller")
+    parser.add_argument("--tolerance", type=float, default=0.5, help="seek landed within this many seconds")
+    parser.add_argument("--timeout", type=float, default=5, help="give up on one effect after this long")
+    parser.add_argument("--json", help="write the results to this file")
+    args = parser.parse_args()
+
+    conn = Connection(args.socket)
+    status = conn.status()
+    duration = float(status.get("duration", "-1"))
+    if duration <= 0:
+        parser.error("the player has no seekable file loaded")
+    conn.request("play")
+    wait_until(conn, lambda s: s.get("state") == "PLAYING", args.timeout)
+
+    stop = threading.Event()
+    poll_ms = []
+    threads = [threading.Thread(target=poller, args=(args.socket, args.poll_rate, stop, poll_ms), daemon=True)
+               for _ in range(args.pollers)]
+    for thread in threads:
+        thread.start()
+
+    reply_ms, seek_ms, pause_ms, play_ms = [], [], [], []
+    missed = 0
+    for _ in range(args.seeks):
+        target = random.uniform(0, duration * 0.9)
+        landed = lambda s, t=target: abs(float(s.get("position", "-1")) - t) <= args.tolerance
+        if not timed(conn, "seek %.3f" % target, landed, args.timeout, reply_ms, seek_ms):
+            missed += 1
+    for _ in range(args.toggles):
+        if not timed(conn, "pause", lambda s: s.get("state") == "PAUSED", args.timeout, reply_ms, pause_ms):
+            missed += 1
+        if not timed(conn, "play", lambda s: s.get("state") == "PLAYING", args.timeout, reply_ms, play_ms):
+            missed += 1
+
+    stop.set()
+    for thread in threads:
+        thread.join()
+
+    results = {"pollers": args.pollers, "poll_rate": args.poll_rate, "missed": missed}
+    for name, values in (("reply", reply_ms), ("status", poll_ms), ("seek", seek_ms),
+                         ("pause", pause_ms), ("play", play_ms)):
+        results[name] = {"count": len(values), "p50_ms": percentile(values, 0.5),
+                         "p99_ms": percentile(values, 0.99), "max_ms": max(values, default=0.0)}
+        print("%-7s n=%-5d p50 %7.2f ms  p99 %7.2f ms  max %7.2f ms" % (
+            name, len(values), results[name]["p50_ms"], results[name]["p99_ms"], results[name]["max_ms"]))
+    if missed:
+        print("%d effects not seen within %.1f s" % (missed, args.timeout))
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+# serve_throttled.py - serve fixture media over HTTP at a limited bandwidth
+#
+#   ./serve_throttled.py --dir ~/fixtures --rate 500 --port 8000
+#   ./build/gui-player http://localhost:8000/sample.mp4
+#
+# Supports Range requests, so seeking and queue2's range downloads work.
+
+import argparse
+import http.server
+import os
+import re
+import time
+
+
+class ThrottledHandler(http.server.SimpleHTTPRequestHandler):
+    rate = 0  # Bytes per second, 0 = unlimited
+
+    def send_head(self):
+        path = self.translate_path(self.path)
+        if not os.path.isfile(path):
+            return super().send_head()
+
+        size = os.path.getsize(path)
+        start, end = 0, size - 1
+        match = re.match(r"bytes=(\d*)-(\d*)$", self.headers.get("Range", ""))
+        if match and (match.group(1) or match.group(2)):
+            if match.group(1):
+                start = int(match.group(1))
+                if match.group(2):
+                    end = min(int(match.group(2)), size - 1)
+            else:
+                start = max(0, size - int(match.group(2)))
+            if start >= size:
+                self.send_error(416, "Requested Range Not Satisfiable")
+                return None
+            self.send_response(206)
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, end, size))
+        else:
+            self.send_response(200)
+
+        self.send_header("Content-Type", self.guess_type(path))
+        self.send_header("Content-Length", str(end - start + 1))
+        self.send_header("Accept-Ranges", "bytes")
+        self.end_headers()
+
+        f = open(path, "rb")
+        f.seek(start)
+        self.remaining = end - start + 1
+        return f
+
+    def copyfile(self, source, outputfile):
+        chunk = 16 * 1024
+        remaining = getattr(self, "remaining", None)
+        started = time.monotonic()
+        sent = 0
+        while remaining is None or remaining > 0:
+            data = source.read(chunk if remaining is None else min(chunk, remaining))
+            if not data:
+                break
+            try:
+                outputfile.write(data)
+            except (BrokenPipeError, ConnectionResetError):
+                break  # Player seeked and dropped the connection
+            sent += len(data)
+            if remaining is not None:
+                remaining -= len(data)
+            if self.rate:
+                ahead = sent / self.rate - (time.monotonic() - started)
+                if ahead > 0:
+                    time.sleep(ahead)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serve files over HTTP with throttled bandwidth")
+    parser.add_argument("--dir", default=".", help="directory to serve")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--rate", type=int, default=0, help="KB/s per connection, 0 = unlimited")
+    args = parser.parse_args()
+
+    ThrottledHandler.rate = args.rate * 1024
+    os.chdir(args.dir)
+    server = http.server.ThreadingHTTPServer(("", args.port), ThrottledHandler)
+    print("Serving %s on port %d at %s" % (os.getcwd(), args.port,
+                                            "%d KB/s" % args.rate if args.rate else "full speed"))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
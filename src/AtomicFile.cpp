@@ -0,0 +1,30 @@
+#include "AtomicFile.hpp"
+#include <fstream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+bool write_file_atomically(const std::string& path, const std::function<void(std::ostream&)>& write) {
+    std::error_code ec;
+    fs::path parent = fs::path(path).parent_path();
+    if (!parent.empty()) {
+        fs::create_directories(parent, ec);
+    }
+
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        write(out);
+        out.flush();
+        if (!out) {
+            out.close();
+            fs::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    fs::rename(tmp_path, path, ec);
+    return !ec;
+}
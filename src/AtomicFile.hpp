@@ -0,0 +1,14 @@
+#ifndef ATOMIC_FILE_HPP
+#define ATOMIC_FILE_HPP
+
+#include <string>
+#include <ostream>
+#include <functional>
+
+// Replace path with what write() puts in the stream. The data goes to
+// path + ".tmp" and is renamed over path once complete, so a crash never
+// leaves a torn file and readers only ever see a whole one. Creates the
+// parent directory; false if the file could not be written.
+bool write_file_atomically(const std::string& path, const std::function<void(std::ostream&)>& write);
+
+#endif // ATOMIC_FILE_HPP
@@ -0,0 +1,197 @@
+#include "AudioTap.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Frames converted per step, on the streaming thread's stack
+static const size_t CHUNK_FRAMES = 512;
+static const int MAX_CHANNELS = 8;
+
+// Readers stay out of the part of the ring the writer may be refilling
+static const size_t READABLE = AudioTap::RING_SIZE / 2;
+
+AudioTap::AudioTap()
+    : pad(nullptr), probe_id(0), kernels(SpectrumKernels::best()), ring(new float[RING_SIZE]()),
+      written(0), end_time(-1), rate(0), format(Format::None), channels(0) {
+    gst_segment_init(&segment, GST_FORMAT_TIME);
+}
+
+AudioTap::~AudioTap() {
+    detach();
+}
+
+bool AudioTap::attach(GstElement* pipeline) {
+    detach();
+    if (!g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "audio-sink")) {
+        return false;
+    }
+    GstElement* sink = nullptr;
+    g_object_get(pipeline, "audio-sink", &sink, nullptr);
+    if (!sink) {
+        return false;
+    }
+    pad = gst_element_get_static_pad(sink, "sink");
+    gst_object_unref(sink);
+    if (!pad) {
+        return false;
+    }
+
+    written = 0;
+    end_time = -1;
+    format = Format::None;
+    gst_segment_init(&segment, GST_FORMAT_TIME);
+    GstCaps* caps = gst_pad_get_current_caps(pad);
+    if (caps) {
+        set_caps(caps);
+        gst_caps_unref(caps);
+    }
+    probe_id = gst_pad_add_probe(pad,
+        GstPadProbeType(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+        on_probe, this, nullptr);
+    return true;
+}
+
+void AudioTap::detach() {
+    if (pad) {
+        if (probe_id) {
+            gst_pad_remove_probe(pad, probe_id);
+            probe_id = 0;
+        }
+        gst_object_unref(pad);
+        pad = nullptr;
+    }
+    rate = 0;
+}
+
+void AudioTap::set_caps(GstCaps* caps) {
+    format = Format::None;
+    const GstStructure* s = gst_caps_get_structure(caps, 0);
+    const gchar* name = gst_structure_get_string(s, "format");
+    const gchar* layout = gst_structure_get_string(s, "layout");
+    gint new_rate = 0;
+    gst_structure_get_int(s, "rate", &new_rate);
+    gst_structure_get_int(s, "channels", &channels);
+    if (!name || (layout && strcmp(layout, "interleaved") != 0) ||
+        new_rate <= 0 || channels < 1 || channels > MAX_CHANNELS) {
+        rate = 0;
+        return;
+    }
+
+    bool little_endian = G_BYTE_ORDER == G_LITTLE_ENDIAN;
+    if (strcmp(name, little_endian ? "F32LE" : "F32BE") == 0) {
+        format = Format::F32;
+    } else if (strcmp(name, little_endian ? "S16LE" : "S16BE") == 0) {
+        format = Format::S16;
+    }
+    rate = format != Format::None ? new_rate : 0;
+}
+
+// Mix down to mono and append to the ring
+void AudioTap::write(const guint8* data, size_t frames) {
+    float converted[CHUNK_FRAMES * MAX_CHANNELS];
+    float mono[CHUNK_FRAMES];
+    guint64 position = written.load(std::memory_order_relaxed);
+
+    for (size_t done = 0; done < frames;) {
+        size_t count = std::min(CHUNK_FRAMES, frames - done);
+        size_t samples = count * channels;
+        const float* in;
+        if (format == Format::F32) {
+            in = reinterpret_cast<const float*>(data) + done * channels;
+        } else {
+            const gint16* s16 = reinterpret_cast<const gint16*>(data) + done * channels;
+            for (size_t i = 0; i < samples; i++) {
+                converted[i] = s16[i] * (1.0f / 32768.0f);
+            }
+            in = converted;
+        }
+
+        if (channels == 2) {
+            kernels.mix_stereo(in, mono, count);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                float sum = 0;
+                for (int c = 0; c < channels; c++) {
+                    sum += in[i * channels + c];
+                }
+                mono[i] = sum / channels;
+            }
+        }
+
+        size_t start = position % RING_SIZE;
+        size_t first = std::min(count, RING_SIZE - start);
+        memcpy(&ring[start], mono, first * sizeof(float));
+        memcpy(&ring[0], mono + first, (count - first) * sizeof(float));
+        position += count;
+        done += count;
+    }
+    written.store(position, std::memory_order_release);
+}
+
+bool AudioTap::read(gint64 position, float* out, size_t n, int& sample_rate) const {
+    int current_rate = rate;
+    gint64 end = end_time;
+    guint64 total = written.load(std::memory_order_acquire);
+    guint64 available = std::min<guint64>(total, READABLE);
+    if (current_rate <= 0 || available < n) {
+        return false;
+    }
+
+    // The sink is still playing what arrived a while ago
+    guint64 last = total;
+    if (position >= 0 && end > position) {
+        guint64 lag = gst_util_uint64_scale(end - position, current_rate, GST_SECOND);
+        if (lag + n <= available) {
+            last = total - lag;
+        }
+    }
+
+    size_t start = (last - n) % RING_SIZE;
+    size_t first = std::min(n, RING_SIZE - start);
+    memcpy(out, &ring[start], first * sizeof(float));
+    memcpy(out + first, &ring[0], (n - first) * sizeof(float));
+    sample_rate = current_rate;
+    return true;
+}
+
+GstPadProbeReturn AudioTap::on_probe(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    AudioTap* tap = static_cast<AudioTap*>(data);
+
+    if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+            GstCaps* caps;
+            gst_event_parse_caps(event, &caps);
+            tap->set_caps(caps);
+        } else if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+            const GstSegment* new_segment;
+            gst_event_parse_segment(event, &new_segment);
+            gst_segment_copy_into(new_segment, &tap->segment);
+        } else if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP) {
+            tap->end_time = -1;
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    int current_rate = tap->rate;
+    if (current_rate <= 0) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstMapInfo map;
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        return GST_PAD_PROBE_OK;
+    }
+    size_t frame_size = (tap->format == Format::F32 ? sizeof(float) : sizeof(gint16)) * tap->channels;
+    size_t frames = map.size / frame_size;
+    tap->write(map.data, frames);
+    gst_buffer_unmap(buffer, &map);
+
+    guint64 stream_time = GST_BUFFER_PTS_IS_VALID(buffer)
+        ? gst_segment_to_stream_time(&tap->segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer))
+        : GST_CLOCK_TIME_NONE;
+    tap->end_time = GST_CLOCK_TIME_IS_VALID(stream_time)
+        ? (gint64)(stream_time + gst_util_uint64_scale(frames, GST_SECOND, current_rate))
+        : -1;
+    return GST_PAD_PROBE_OK;
+}
@@ -0,0 +1,52 @@
+#ifndef AUDIO_TAP_HPP
+#define AUDIO_TAP_HPP
+
+#include <gst/gst.h>
+#include <atomic>
+#include <memory>
+#include "Spectrum.hpp"
+
+// Copies the PCM reaching playbin's audio sink into a ring of mono
+// samples for the visualiser. The streaming thread only mixes down and
+// copies (interleaved F32 or S16, other formats are skipped); it never
+// takes a lock or waits for the reader, so a slow UI cannot hold up the
+// audio. Readers get the samples playing at a given position, which
+// compensates for the audio sink's own buffering.
+class AudioTap {
+public:
+    static const size_t RING_SIZE = 1 << 17;  // Mono samples, ~2.7 s at 48 kHz
+
+    AudioTap();
+    ~AudioTap();
+
+    // False if the pipeline has no audio-sink to tap
+    bool attach(GstElement* pipeline);
+    void detach();
+    bool attached() const { return pad != nullptr; }
+
+    // n samples ending at position (stream time, -1 = newest); any thread
+    bool read(gint64 position, float* out, size_t n, int& sample_rate) const;
+
+private:
+    enum class Format { None, F32, S16 };
+
+    GstPad* pad;
+    gulong probe_id;
+    const SpectrumKernels& kernels;
+    std::unique_ptr<float[]> ring;
+    std::atomic<guint64> written;   // Samples ever written; ring index is written % RING_SIZE
+    std::atomic<gint64> end_time;   // Stream time just past the newest sample, -1 if unknown
+    std::atomic<int> rate;
+
+    // Streaming thread only
+    Format format;
+    int channels;
+    GstSegment segment;
+
+    void set_caps(GstCaps* caps);
+    void write(const guint8* data, size_t frames);
+
+    static GstPadProbeReturn on_probe(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+};
+
+#endif // AUDIO_TAP_HPP
@@ -0,0 +1,1010 @@
+#include "Benchmark.hpp"
+#include "VideoRenderer.hpp"
+#include "GapMeter.hpp"
+#include "JsonEscape.hpp"
+#include <gtk/gtk.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <sys/resource.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+// Give up on a single seek or first frame after this long
+static const gint64 STEP_TIMEOUT_US = 5 * G_USEC_PER_SEC;
+
+// Cap for building a keyframe index of a multi-GB file
+static const gint64 INDEX_TIMEOUT_US = 600 * G_USEC_PER_SEC;
+
+// Playback before each switch of bench_switch(); audio-only files have
+// no first frame to wait for
+static const gint64 SWITCH_PLAY_US = G_USEC_PER_SEC / 2;
+
+// Speeds compared by bench_rates(); trick mode at 8x may cost at most
+// this many times the CPU per second of 1x playback
+static const double BENCH_RATES[] = {1.0, 2.0, 8.0};
+static const double TRICKMODE_CPU_BUDGET = 1.5;
+
+// Synthetic clip of bench_soak(): 4K noise coded as MJPEG, so every
+// frame is a large keyframe (roughly 100 MB/s), with a PCM track. Looped
+// for the soak; SOAK_CLIP_FRAMES keeps the temp file to a few hundred MB.
+static const int SOAK_WIDTH = 3840;
+static const int SOAK_HEIGHT = 2160;
+static const int SOAK_FPS = 30;
+static const int SOAK_CLIP_FRAMES = 60;
+
+// Encoding a synthetic clip gives up after this long
+static const gint64 CLIP_ENCODE_TIMEOUT_US = 300 * G_USEC_PER_SEC;
+
+// RSS and queue levels are sampled this often during the soak
+static const gint64 SOAK_SAMPLE_US = G_USEC_PER_SEC / 10;
+
+// Synthetic clip of bench_loops(): 2 s of small MJPEG video and PCM, with
+// audio buffers one frame long. The A-B loop cuts it in the middle.
+static const int LOOP_WIDTH = 320;
+static const int LOOP_HEIGHT = 240;
+static const int LOOP_FPS = 30;
+static const int LOOP_CLIP_FRAMES = 60;
+static const gint64 LOOP_A = GST_SECOND / 2;
+static const gint64 LOOP_B = 3 * GST_SECOND / 2;
+
+// Largest loop-boundary gap (or overlap) in running time a segment loop
+// may show. Matroska stores timestamps in whole milliseconds, so up to
+// 1 ms is rounding in the fixture.
+static const double LOOP_GAP_BUDGET_MS = 2.0;
+
+// User + system CPU time of this process, in microseconds
+static gint64 cpu_time_us() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (gint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * G_USEC_PER_SEC +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+Benchmark::Benchmark(const BenchOptions& options)
+    : options(options), loop(g_main_loop_new(nullptr, FALSE)), pipeline(nullptr),
+      video_sink(nullptr), use_policy(false), duration(0), frames_rendered(0), first_frame_time(0),
+      last_frame_time(0), max_frame_interval(0) {
+}
+
+Benchmark::~Benchmark() {
+    close();
+    g_main_loop_unref(loop);
+}
+
+// Unsynchronised sinks decode as fast as possible; synced ones play in real time
+std::vector<PipelineConfig> Benchmark::headless_configs(const std::string& filename, bool synced) {
+    std::string sync = synced ? "sync=true" : "sync=false";
+    return {
+        PipelineLoader::playbin_config("fakesink", filename,
+                                       "fakesink name=benchvideo " + sync + " signal-handoffs=true",
+                                       "fakesink " + sync)
+    };
+}
+
+bool Benchmark::open(gint64& preroll_ns, bool synced, const std::string& file) {
+    close();
+
+    PipelineLoadResult loaded;
+    PipelineLoader loader;
+    loader.set_setup([this, synced](GstElement* new_pipeline) {
+        if (use_policy) {
+            decoder_policy.attach(new_pipeline);
+        }
+        if (memory_budget.enabled()) {
+            memory_budget.configure(new_pipeline);
+        }
+        if (synced) {
+            PlaybackRate::configure(new_pipeline);  // scaletempo, as in the player
+        }
+    });
+    const std::string& location = file.empty() ? options.file : file;
+    loader.load(headless_configs(location, synced), [&](PipelineLoadResult& result) {
+        loaded = result;
+        result.pipeline = nullptr;
+        result.video_sink = nullptr;
+        g_main_loop_quit(loop);
+    });
+    g_main_loop_run(loop);
+
+    if (!loaded.pipeline) {
+        std::cerr << "❌ Could not open " << location << ": " << loaded.error << std::endl;
+        return false;
+    }
+
+    // playbin hands back the wrapping bin; we want the fakesink itself
+    if (loaded.video_sink) {
+        gst_object_unref(loaded.video_sink);
+    }
+    pipeline = loaded.pipeline;
+    video_sink = gst_bin_get_by_name(GST_BIN(pipeline), "benchvideo");
+    if (video_sink) {
+        g_signal_connect(video_sink, "handoff", G_CALLBACK(on_handoff), this);
+    }
+
+    duration = 0;
+    gst_element_query_duration(pipeline, GST_FORMAT_TIME, &duration);
+    preroll_ns = loaded.preroll_time_ns;
+    return true;
+}
+
+// Switch the open pipeline to file the way the player does (READY, new
+// uri, PAUSED); the fakesinks and their handoff handler stay
+bool Benchmark::reuse(const std::string& file, gint64& preroll_ns) {
+    PipelineLoadResult loaded;
+    PipelineLoader loader;
+    GstElement* warm = pipeline;
+    pipeline = nullptr;
+    loader.reuse(warm, "fakesink", file, [&](PipelineLoadResult& result) {
+        loaded = result;
+        result.pipeline = nullptr;
+        result.video_sink = nullptr;
+        g_main_loop_quit(loop);
+    });
+    g_main_loop_run(loop);
+
+    if (!loaded.pipeline) {
+        std::cerr << "❌ Could not switch to " << file << ": " << loaded.error << std::endl;
+        return false;
+    }
+    if (loaded.video_sink) {
+        gst_object_unref(loaded.video_sink);
+    }
+    pipeline = loaded.pipeline;
+
+    duration = 0;
+    gst_element_query_duration(pipeline, GST_FORMAT_TIME, &duration);
+    preroll_ns = loaded.preroll_time_ns;
+    return true;
+}
+
+void Benchmark::close() {
+    if (video_sink) {
+        g_signal_handlers_disconnect_by_data(video_sink, this);
+        gst_object_unref(video_sink);
+        video_sink = nullptr;
+    }
+    if (pipeline) {
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+        pipeline = nullptr;
+    }
+}
+
+bool Benchmark::wait_for(GstMessageType types, gint64 timeout_us) {
+    GstBus* bus = gst_element_get_bus(pipeline);
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, timeout_us * GST_USECOND,
+                                                 GstMessageType(types | GST_MESSAGE_ERROR));
+    gst_object_unref(bus);
+
+    if (!msg) {
+        return false;
+    }
+
+    bool ok = GST_MESSAGE_TYPE(msg) != GST_MESSAGE_ERROR;
+    if (!ok) {
+        GError* err = nullptr;
+        gst_message_parse_error(msg, &err, nullptr);
+        std::cerr << "❌ Error: " << err->message << std::endl;
+        g_error_free(err);
+    }
+    gst_message_unref(msg);
+    return ok;
+}
+
+void Benchmark::on_handoff(GstElement* sink, GstBuffer* buffer, GstPad* pad, gpointer data) {
+    Benchmark* bench = static_cast<Benchmark*>(data);
+    gint64 now = g_get_monotonic_time();
+    if (bench->frames_rendered++ == 0) {
+        bench->first_frame_time = now;
+    }
+    // Only this streaming thread writes these
+    gint64 last = bench->last_frame_time.exchange(now);
+    if (last > 0 && now - last > bench->max_frame_interval) {
+        bench->max_frame_interval = now - last;
+    }
+}
+
+Benchmark::Scenario& Benchmark::add_scenario(const std::string& name) {
+    scenarios.push_back({name, {}});
+    return scenarios.back();
+}
+
+double Benchmark::percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t rank = (size_t)std::ceil(p * values.size());
+    return values[rank > 0 ? rank - 1 : 0];
+}
+
+bool Benchmark::run() {
+    if (!bench_open()) {
+        return false;
+    }
+
+    bench_first_frame();
+    bench_decode();
+
+    if (duration > 0) {
+        bench_seek("seek_key_unit", GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT));
+        bench_seek("seek_accurate", GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE));
+        bench_scrub();
+        if (KeyframeIndex::needs_index(options.file)) {
+            bench_seek_indexed();
+        }
+    } else {
+        std::cerr << "Warning: Unknown duration, skipping seek scenarios" << std::endl;
+    }
+    close();
+
+    bench_decode_threads();
+
+    bool within_budget = true;
+    if (options.rate_seconds > 0 && duration > 0) {
+        within_budget = bench_rates();
+    }
+
+    if (options.switch_runs > 0) {
+        bench_switch();
+    }
+
+    if (options.soak_seconds > 0) {
+        within_budget = bench_soak() && within_budget;
+    }
+
+    if (options.loop_runs > 0) {
+        within_budget = bench_loops() && within_budget;
+    }
+
+    if (options.render_seconds > 0 && options.has_display) {
+        bench_render("render_appsink", VideoFrameSink::SINK_DESCRIPTION);
+        bench_render("render_gtksink", "gtksink");
+        // A large source in a small window: converted at window size, then at source size
+        bench_render("render_appsink_small", VideoFrameSink::SINK_DESCRIPTION, 640, 360);
+        bench_render("render_appsink_small_fullres", VideoFrameSink::SINK_DESCRIPTION, 640, 360, false);
+    } else if (options.render_seconds > 0) {
+        std::cerr << "Warning: No display, skipping render scenarios" << std::endl;
+    }
+    return within_budget;
+}
+
+// Cold open to preroll, then warm re-opens of the same file
+bool Benchmark::bench_open() {
+    std::vector<double> warm;
+    double cold_ms = 0;
+
+    for (int i = 0; i < std::max(1, options.open_runs); i++) {
+        gint64 preroll_ns = 0;
+        if (!open(preroll_ns)) {
+            return false;
+        }
+        double ms = (double)preroll_ns / GST_MSECOND;
+        if (i == 0) {
+            cold_ms = ms;
+        } else {
+            warm.push_back(ms);
+        }
+    }
+
+    Scenario& scenario = add_scenario("open");
+    scenario.metrics.push_back({"cold_preroll_ms", cold_ms});
+    if (!warm.empty()) {
+        scenario.metrics.push_back({"warm_preroll_p50_ms", percentile(warm, 0.5)});
+        scenario.metrics.push_back({"warm_preroll_max_ms", percentile(warm, 1.0)});
+    }
+    return true;
+}
+
+// PAUSED (prerolled) -> PLAYING until the first rendered buffer
+bool Benchmark::bench_first_frame() {
+    frames_rendered = 0;
+    first_frame_time = 0;
+
+    gint64 start = g_get_monotonic_time();
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    while (first_frame_time == 0 && g_get_monotonic_time() - start < STEP_TIMEOUT_US) {
+        if (wait_for(GST_MESSAGE_EOS, 1000)) {
+            break;
+        }
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    gst_element_get_state(pipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
+
+    if (first_frame_time == 0) {
+        std::cerr << "Warning: No video frame rendered" << std::endl;
+        return false;
+    }
+
+    Scenario& scenario = add_scenario("first_frame");
+    scenario.metrics.push_back({"ms", (first_frame_time - start) / 1000.0});
+    return true;
+}
+
+// Unsynchronised playback from the start, capped at decode_seconds
+bool Benchmark::bench_decode(const std::string& name) {
+    gst_element_seek_simple(pipeline, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH, 0);
+    wait_for(GST_MESSAGE_ASYNC_DONE, STEP_TIMEOUT_US);
+
+    frames_rendered = 0;
+    gint64 cpu_start = cpu_time_us();
+    gint64 start = g_get_monotonic_time();
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    bool reached_eos = wait_for(GST_MESSAGE_EOS, (gint64)(options.decode_seconds * G_USEC_PER_SEC));
+
+    double seconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    double cpu_ms = (cpu_time_us() - cpu_start) / 1000.0;
+    guint64 frames = frames_rendered;
+
+    gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    gst_element_get_state(pipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
+
+    Scenario& scenario = add_scenario(name);
+    scenario.metrics.push_back({"frames", (double)frames});
+    scenario.metrics.push_back({"seconds", seconds});
+    scenario.metrics.push_back({"fps", seconds > 0 ? frames / seconds : 0});
+    scenario.metrics.push_back({"cpu_ms_per_frame", frames > 0 ? cpu_ms / frames : 0});
+    scenario.metrics.push_back({"reached_eos", reached_eos ? 1 : 0});
+    return frames > 0;
+}
+
+// The decode run again for each decoder thread setting, on a fresh
+// pipeline each time since decoders only read their threads when opening
+void Benchmark::bench_decode_threads() {
+    int cores = std::max(1, (int)g_get_num_processors());
+    std::vector<int> done;
+
+    use_policy = true;
+    for (int setting : options.thread_settings) {
+        int threads = setting < 0 ? cores : setting;
+        if (std::find(done.begin(), done.end(), threads) != done.end()) {
+            continue;
+        }
+        done.push_back(threads);
+
+        // 0 lets the policy scale with resolution
+        decoder_policy.set_override(threads, threads == 0 ? "auto" : "");
+        gint64 preroll_ns = 0;
+        if (!open(preroll_ns)) {
+            break;
+        }
+        bench_decode(threads == 0 ? "decode_threads_policy" : "decode_threads_" + std::to_string(threads));
+        close();
+    }
+    use_policy = false;
+}
+
+// Random flushing seeks from PAUSED, timed until the new preroll
+bool Benchmark::bench_seek(const std::string& name, GstSeekFlags flags) {
+    // Fixed seed so runs are comparable between releases
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> position(0.0, 1.0);
+    std::vector<double> latencies;
+    int failures = 0;
+
+    for (int i = 0; i < options.seeks; i++) {
+        gint64 target = (gint64)(position(rng) * duration);
+        gint64 start = g_get_monotonic_time();
+
+        if (!gst_element_seek_simple(pipeline, GST_FORMAT_TIME, flags, target) ||
+            !wait_for(GST_MESSAGE_ASYNC_DONE, STEP_TIMEOUT_US)) {
+            failures++;
+            continue;
+        }
+        latencies.push_back((g_get_monotonic_time() - start) / 1000.0);
+    }
+
+    Scenario& scenario = add_scenario(name);
+    scenario.metrics.push_back({"count", (double)latencies.size()});
+    scenario.metrics.push_back({"failures", (double)failures});
+    scenario.metrics.push_back({"p50_ms", percentile(latencies, 0.5)});
+    scenario.metrics.push_back({"p99_ms", percentile(latencies, 0.99)});
+    scenario.metrics.push_back({"max_ms", percentile(latencies, 1.0)});
+    return failures == 0;
+}
+
+// Simulated slider drag through SeekScheduler: one request per 60 Hz
+// frame, then a final accurate seek on "release"
+bool Benchmark::bench_scrub() {
+    const int steps = std::max(1, options.seeks);
+    const gint64 frame_us = G_USEC_PER_SEC / 60;
+
+    SeekScheduler scheduler;
+    scheduler.set_pipeline(pipeline);
+    GstBus* bus = gst_element_get_bus(pipeline);
+
+    // Deliver ASYNC_DONE to the scheduler until the deadline passes
+    auto pump = [&](gint64 until) {
+        gint64 remaining;
+        while ((remaining = until - g_get_monotonic_time()) > 0) {
+            GstMessage* msg = gst_bus_timed_pop_filtered(bus, remaining * GST_USECOND,
+                                                         GST_MESSAGE_ASYNC_DONE);
+            if (!msg) break;
+            scheduler.on_async_done(msg);
+            gst_message_unref(msg);
+        }
+    };
+
+    gint64 start = g_get_monotonic_time();
+    for (int i = 0; i < steps; i++) {
+        scheduler.request(duration * i / steps, SeekScheduler::Mode::Scrub);
+        pump(g_get_monotonic_time() + frame_us);
+    }
+
+    gint64 release = g_get_monotonic_time();
+    scheduler.request(duration / 2, SeekScheduler::Mode::Accurate);
+    while (scheduler.busy() && g_get_monotonic_time() - release < STEP_TIMEOUT_US) {
+        pump(g_get_monotonic_time() + frame_us);
+    }
+    gst_object_unref(bus);
+
+    Scenario& scenario = add_scenario("scrub");
+    scenario.metrics.push_back({"requests", (double)scheduler.requested_count()});
+    scenario.metrics.push_back({"seeks_issued", (double)scheduler.issued_count()});
+    scenario.metrics.push_back({"drag_ms", (release - start) / 1000.0});
+    scenario.metrics.push_back({"release_to_display_ms", scheduler.last_latency_ms()});
+    scenario.metrics.push_back({"latency_p50_ms", scheduler.latency_percentile(0.5)});
+    scenario.metrics.push_back({"latency_p99_ms", scheduler.latency_percentile(0.99)});
+    return !scheduler.busy();
+}
+
+// Real-time playback into a width x height window for render_seconds,
+// with the given video output; audio goes to a synchronised fakesink.
+// downscale applies to the appsink renderer only.
+bool Benchmark::bench_render(const std::string& name, const std::string& video_sink_description,
+                             int width, int height, bool downscale) {
+    PipelineLoadResult loaded;
+    PipelineLoader loader;
+    loader.load({PipelineLoader::playbin_config(name, options.file, video_sink_description, "fakesink sync=true")},
+                [&](PipelineLoadResult& result) {
+        loaded = result;
+        result.pipeline = nullptr;
+        result.video_sink = nullptr;
+        g_main_loop_quit(loop);
+    });
+    g_main_loop_run(loop);
+
+    if (!loaded.pipeline) {
+        std::cerr << "Warning: " << name << " unavailable: " << loaded.error << std::endl;
+        return false;
+    }
+
+    GtkWidget* window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_default_size(GTK_WINDOW(window), width, height);
+
+    // Same widgets the player uses for each output
+    VideoRenderer renderer;
+    GtkWidget* area = nullptr;
+    if (loaded.video_sink && g_object_class_find_property(G_OBJECT_GET_CLASS(loaded.video_sink), "widget")) {
+        g_object_get(loaded.video_sink, "widget", &area, nullptr);
+    } else {
+        area = GTK_WIDGET(g_object_ref_sink(gtk_drawing_area_new()));
+        renderer.set_widget(area);
+        renderer.set_downscale(downscale);
+        renderer.attach(loaded.pipeline);
+    }
+    if (area) {
+        gtk_container_add(GTK_CONTAINER(window), area);
+        g_object_unref(area);
+    }
+    gtk_widget_show_all(window);
+
+    // Frames reaching the video sink, counted the same way for both outputs
+    std::atomic<guint64> frames(0);
+    GstPad* pad = loaded.video_sink ? gst_element_get_static_pad(loaded.video_sink, "sink") : nullptr;
+    if (pad) {
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, +[](GstPad*, GstPadProbeInfo*, gpointer data) {
+            (*static_cast<std::atomic<guint64>*>(data))++;
+            return GST_PAD_PROBE_OK;
+        }, &frames, nullptr);
+        gst_object_unref(pad);
+    }
+
+    // Stop at EOS, an error, or after render_seconds
+    GstBus* bus = gst_element_get_bus(loaded.pipeline);
+    guint bus_watch = gst_bus_add_watch(bus, +[](GstBus*, GstMessage* msg, gpointer data) -> gboolean {
+        if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS || GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+            g_main_loop_quit(static_cast<GMainLoop*>(data));
+        }
+        return G_SOURCE_CONTINUE;
+    }, loop);
+    guint timeout = g_timeout_add((guint)(options.render_seconds * 1000), +[](gpointer data) -> gboolean {
+        g_main_loop_quit(static_cast<GMainLoop*>(data));
+        return G_SOURCE_REMOVE;
+    }, loop);
+
+    gint64 cpu_start = cpu_time_us();
+    gint64 start = g_get_monotonic_time();
+    gst_element_set_state(loaded.pipeline, GST_STATE_PLAYING);
+    g_main_loop_run(loop);
+
+    double seconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    double cpu_ms = (cpu_time_us() - cpu_start) / 1000.0;
+    guint64 frame_count = frames;
+
+    g_source_remove(timeout);
+    g_source_remove(bus_watch);
+    gst_object_unref(bus);
+    renderer.detach();
+    gst_element_set_state(loaded.pipeline, GST_STATE_NULL);
+    gst_object_unref(loaded.pipeline);
+    if (loaded.video_sink) {
+        gst_object_unref(loaded.video_sink);
+    }
+    gtk_widget_destroy(window);
+
+    Scenario& scenario = add_scenario(name);
+    scenario.metrics.push_back({"frames", (double)frame_count});
+    scenario.metrics.push_back({"seconds", seconds});
+    scenario.metrics.push_back({"cpu_ms_per_frame", frame_count > 0 ? cpu_ms / frame_count : 0});
+    if (renderer.painted_count() > 0) {
+        scenario.metrics.push_back({"painted", (double)renderer.painted_count()});
+        scenario.metrics.push_back({"late_dropped", (double)renderer.late_count()});
+        scenario.metrics.push_back({"replaced", (double)renderer.dropped_count()});
+    }
+    return frame_count > 0;
+}
+
+// Real-time playback from the start at each speed in BENCH_RATES, the
+// way the player switches speed. Above 2x the demuxer only sends
+// keyframes, so CPU per second should stay near 1x (files coded
+// all-intra are the exception: every frame is a keyframe).
+bool Benchmark::bench_rates() {
+    gint64 preroll_ns = 0;
+    if (!open(preroll_ns, true)) {
+        return false;
+    }
+
+    double cpu_1x = 0, cpu_8x = 0;
+    for (double rate : BENCH_RATES) {
+        if (!PlaybackRate::apply(pipeline, rate, 0) || !wait_for(GST_MESSAGE_ASYNC_DONE, STEP_TIMEOUT_US)) {
+            std::cerr << "Warning: Could not play at " << rate << "x" << std::endl;
+            continue;
+        }
+
+        frames_rendered = 0;
+        gint64 cpu_start = cpu_time_us();
+        gint64 start = g_get_monotonic_time();
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+        bool reached_eos = wait_for(GST_MESSAGE_EOS, (gint64)(options.rate_seconds * G_USEC_PER_SEC));
+
+        double seconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+        double cpu_ms_per_second = seconds > 0 ? (cpu_time_us() - cpu_start) / 1000.0 / seconds : 0;
+        guint64 frames = frames_rendered;
+        gint64 position = 0;
+        gst_element_query_position(pipeline, GST_FORMAT_TIME, &position);
+
+        gst_element_set_state(pipeline, GST_STATE_PAUSED);
+        gst_element_get_state(pipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
+
+        char name[32];
+        snprintf(name, sizeof(name), "rate_%gx", rate);
+        Scenario& scenario = add_scenario(name);
+        scenario.metrics.push_back({"frames", (double)frames});
+        scenario.metrics.push_back({"seconds", seconds});
+        scenario.metrics.push_back({"media_seconds", (double)position / GST_SECOND});
+        scenario.metrics.push_back({"cpu_ms_per_second", cpu_ms_per_second});
+        scenario.metrics.push_back({"trickmode", PlaybackRate::trickmode(rate) ? 1 : 0});
+        scenario.metrics.push_back({"reached_eos", reached_eos ? 1 : 0});
+
+        if (rate == 1.0) {
+            cpu_1x = cpu_ms_per_second;
+        } else if (rate == 8.0) {
+            cpu_8x = cpu_ms_per_second;
+        }
+    }
+    close();
+
+    if (cpu_1x <= 0 || cpu_8x <= 0) {
+        return true;  // Nothing to compare
+    }
+    double ratio = cpu_8x / cpu_1x;
+    Scenario& scenario = add_scenario("rate_cost");
+    scenario.metrics.push_back({"cpu_8x_vs_1x", ratio});
+    scenario.metrics.push_back({"budget", TRICKMODE_CPU_BUDGET});
+    scenario.metrics.push_back({"within_budget", ratio <= TRICKMODE_CPU_BUDGET ? 1 : 0});
+    if (ratio > TRICKMODE_CPU_BUDGET) {
+        std::cerr << "❌ 8x playback uses " << ratio << "x the CPU of 1x (budget "
+                  << TRICKMODE_CPU_BUDGET << "x)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Scripted switches between two files, each played to its first frame:
+// a full teardown and rebuild per switch, then the same switches on one
+// reused playbin. Times run from the switch request to preroll.
+bool Benchmark::bench_switch() {
+    const std::string files[2] = {options.switch_file.empty() ? options.file : options.switch_file,
+                                  options.file};
+    std::vector<double> rebuild, reused;
+
+    for (int mode = 0; mode < 2; mode++) {
+        gint64 preroll_ns = 0;
+        if (!open(preroll_ns)) {
+            return false;
+        }
+        std::vector<double>& times = mode == 0 ? rebuild : reused;
+        for (int i = 0; i < options.switch_runs; i++) {
+            // Switch away from a pipeline that played, not just one that prerolled
+            frames_rendered = 0;
+            first_frame_time = 0;
+            gint64 play_start = g_get_monotonic_time();
+            gst_element_set_state(pipeline, GST_STATE_PLAYING);
+            while (first_frame_time == 0 && g_get_monotonic_time() - play_start < SWITCH_PLAY_US) {
+                if (wait_for(GST_MESSAGE_EOS, 1000)) {
+                    break;
+                }
+            }
+
+            const std::string& file = files[i % 2];
+            gint64 start = g_get_monotonic_time();
+            bool switched = mode == 0 ? open(preroll_ns, false, file) : reuse(file, preroll_ns);
+            if (!switched) {
+                close();
+                return false;
+            }
+            times.push_back((g_get_monotonic_time() - start) / 1000.0);
+        }
+        close();
+    }
+
+    Scenario& scenario = add_scenario("switch");
+    scenario.metrics.push_back({"runs", (double)options.switch_runs});
+    scenario.metrics.push_back({"rebuild_p50_ms", percentile(rebuild, 0.5)});
+    scenario.metrics.push_back({"rebuild_max_ms", percentile(rebuild, 1.0)});
+    scenario.metrics.push_back({"reuse_p50_ms", percentile(reused, 0.5)});
+    scenario.metrics.push_back({"reuse_max_ms", percentile(reused, 1.0)});
+    return true;
+}
+
+// Encode a synthetic MJPEG + PCM clip to a new temp file; empty on failure.
+// Audio comes in one buffer per video frame.
+static std::string make_clip(const char* pattern, int width, int height, int fps, int frames) {
+    gchar* clip = nullptr;
+    gint fd = g_file_open_tmp("vidc-bench-XXXXXX.mkv", &clip, nullptr);
+    if (fd < 0) {
+        std::cerr << "❌ Could not create a temp file for the test clip" << std::endl;
+        return "";
+    }
+    ::close(fd);
+    std::string path = clip;
+    g_free(clip);
+
+    gchar* description = g_strdup_printf(
+        "videotestsrc pattern=%s num-buffers=%d ! video/x-raw,width=%d,height=%d,framerate=%d/1 "
+        "! jpegenc quality=90 ! queue ! matroskamux name=mux ! filesink location=\"%s\" "
+        "audiotestsrc num-buffers=%d samplesperbuffer=%d ! audio/x-raw,format=S16LE,rate=48000,channels=2 "
+        "! queue ! mux.",
+        pattern, frames, width, height, fps, path.c_str(), frames, 48000 / fps);
+    GError* error = nullptr;
+    GstElement* encoder = gst_parse_launch(description, &error);
+    g_free(description);
+    if (!encoder) {
+        std::cerr << "❌ Could not build the test clip encoder: " << error->message << std::endl;
+        g_error_free(error);
+        g_unlink(path.c_str());
+        return "";
+    }
+
+    gst_element_set_state(encoder, GST_STATE_PLAYING);
+    GstBus* bus = gst_element_get_bus(encoder);
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, CLIP_ENCODE_TIMEOUT_US * GST_USECOND,
+                                                 GstMessageType(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    bool ok = msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+    if (msg) {
+        gst_message_unref(msg);
+    }
+    gst_object_unref(bus);
+    gst_element_set_state(encoder, GST_STATE_NULL);
+    gst_object_unref(encoder);
+    if (!ok) {
+        std::cerr << "❌ Could not encode the test clip" << std::endl;
+        g_unlink(path.c_str());
+        return "";
+    }
+    return path;
+}
+
+// Real-time playback of the synthetic high-bitrate clip, looped for
+// soak_seconds, with the memory budget applied. Peak RSS (VmHWM, reset
+// when the soak starts) must stay under the cap; frame_ratio near 1
+// means the budgeted queues did not stall playback.
+bool Benchmark::bench_soak() {
+    std::string path = make_clip("snow", SOAK_WIDTH, SOAK_HEIGHT, SOAK_FPS, SOAK_CLIP_FRAMES);
+    if (path.empty()) {
+        return false;
+    }
+
+    gint64 preroll_ns = 0;
+    guint64 cap = (guint64)options.memory_budget_mb * 1024 * 1024;
+    memory_budget.set_cap(cap);
+    if (!open(preroll_ns, true, path)) {
+        memory_budget.set_cap(0);
+        g_unlink(path.c_str());
+        return false;
+    }
+
+    guint64 baseline = MemoryBudget::rss_bytes();
+    bool peak_reset = MemoryBudget::reset_peak();
+    guint64 sampled_peak = baseline;
+    guint64 peak_queued = 0;
+    int loops = 0;
+
+    frames_rendered = 0;
+    gint64 start = g_get_monotonic_time();
+    gint64 end = start + (gint64)(options.soak_seconds * G_USEC_PER_SEC);
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    while (g_get_monotonic_time() < end) {
+        if (wait_for(GST_MESSAGE_EOS, SOAK_SAMPLE_US)) {
+            gst_element_seek_simple(pipeline, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH, 0);
+            loops++;
+        }
+        sampled_peak = std::max(sampled_peak, MemoryBudget::rss_bytes());
+        guint64 queued = 0;
+        for (const MemoryBudget::QueueLevel& level : memory_budget.levels(pipeline)) {
+            queued += level.bytes;
+        }
+        peak_queued = std::max(peak_queued, queued);
+    }
+    double seconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    guint64 frames = frames_rendered;
+    // VmHWM also catches spikes between samples
+    guint64 peak = peak_reset ? std::max(sampled_peak, MemoryBudget::peak_rss_bytes()) : sampled_peak;
+
+    close();
+    memory_budget.set_cap(0);
+    g_unlink(path.c_str());
+
+    const double mb = 1024.0 * 1024.0;
+    Scenario& scenario = add_scenario("soak");
+    scenario.metrics.push_back({"seconds", seconds});
+    scenario.metrics.push_back({"cap_mb", cap / mb});
+    scenario.metrics.push_back({"baseline_mb", baseline / mb});
+    scenario.metrics.push_back({"peak_rss_mb", peak / mb});
+    scenario.metrics.push_back({"peak_queued_mb", peak_queued / mb});
+    scenario.metrics.push_back({"frames", (double)frames});
+    scenario.metrics.push_back({"frame_ratio", seconds > 0 ? frames / (seconds * SOAK_FPS) : 0});
+    scenario.metrics.push_back({"loops", (double)loops});
+    scenario.metrics.push_back({"within_cap", peak <= cap ? 1 : 0});
+    if (peak > cap) {
+        std::cerr << "Warning: Soak peak RSS " << peak / mb << " MB is over the "
+                  << options.memory_budget_mb << " MB budget" << std::endl;
+    }
+    return peak <= cap;
+}
+
+// Loops over a generated clip, the player's way: restarting at EOS with
+// READY -> PLAYING (the old exhibit setup), then segment loops over the
+// whole file and over A-B. Gaps are measured in running time at the
+// sinks, stalls as the longest wall-clock wait between two frames.
+bool Benchmark::bench_loops() {
+    std::string path = make_clip("ball", LOOP_WIDTH, LOOP_HEIGHT, LOOP_FPS, LOOP_CLIP_FRAMES);
+    if (path.empty()) {
+        std::cerr << "Warning: No test clip, skipping loop scenarios" << std::endl;
+        return true;
+    }
+    bool ok = bench_loop("loop_restart", path, LoopController::Mode::Off);
+    ok = bench_loop("loop_file", path, LoopController::Mode::File) && ok;
+    ok = bench_loop("loop_ab", path, LoopController::Mode::Range) && ok;
+    g_unlink(path.c_str());
+    return ok;
+}
+
+bool Benchmark::bench_loop(const std::string& name, const std::string& clip, LoopController::Mode mode) {
+    gint64 preroll_ns = 0;
+    if (!open(preroll_ns, true, clip)) {
+        return false;
+    }
+
+    LoopController controller;
+    if (mode == LoopController::Mode::File) {
+        controller.set_file();
+    } else if (mode == LoopController::Mode::Range) {
+        controller.set_range(LOOP_A, LOOP_B);
+    }
+    if (!controller.seek(pipeline, 1.0, GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
+                         controller.start()) ||
+        !wait_for(GST_MESSAGE_ASYNC_DONE, STEP_TIMEOUT_US)) {
+        std::cerr << "Warning: Could not start " << name << std::endl;
+        close();
+        return false;
+    }
+
+    GapMeter video_gap("video");
+    GapMeter audio_gap("audio");
+    GstElement* audio_sink = nullptr;
+    g_object_get(pipeline, "audio-sink", &audio_sink, nullptr);
+    video_gap.attach(video_sink);
+    audio_gap.attach(audio_sink);
+    if (audio_sink) {
+        gst_object_unref(audio_sink);
+    }
+
+    std::vector<double> video_gaps, audio_gaps;
+    int loops = 0, eos = 0;
+    frames_rendered = 0;
+    last_frame_time = 0;
+    max_frame_interval = 0;
+    gint64 start = g_get_monotonic_time();
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    // Each pass is at most the clip's length plus a restart
+    gint64 pass_timeout = (gint64)LOOP_CLIP_FRAMES * G_USEC_PER_SEC / LOOP_FPS + STEP_TIMEOUT_US;
+    GstBus* bus = gst_element_get_bus(pipeline);
+    bool failed = false;
+    while (loops < options.loop_runs && !failed) {
+        GstMessage* msg = gst_bus_timed_pop_filtered(bus, pass_timeout * GST_USECOND,
+            GstMessageType(GST_MESSAGE_SEGMENT_DONE | GST_MESSAGE_EOS | GST_MESSAGE_APPLICATION |
+                           GST_MESSAGE_ERROR));
+        if (!msg) {
+            std::cerr << "Warning: " << name << " stopped after " << loops << " loops" << std::endl;
+            break;
+        }
+        switch (GST_MESSAGE_TYPE(msg)) {
+            case GST_MESSAGE_SEGMENT_DONE:
+                failed = !controller.restart(pipeline, 1.0, GST_SEEK_FLAG_NONE);
+                loops++;
+                break;
+            case GST_MESSAGE_EOS:
+                // Back to READY and up again, as the exhibit script did
+                gst_element_set_state(pipeline, GST_STATE_READY);
+                gst_element_set_state(pipeline, GST_STATE_PLAYING);
+                loops++;
+                eos++;
+                break;
+            case GST_MESSAGE_APPLICATION: {
+                const GstStructure* s = gst_message_get_structure(msg);
+                const gchar* transition = gst_structure_get_string(s, "transition");
+                double gap_ms = 0;
+                if (gst_structure_has_name(s, GapMeter::MESSAGE_NAME) && transition &&
+                    strcmp(transition, "segment") == 0 && gst_structure_get_double(s, "gap-ms", &gap_ms)) {
+                    bool video = strcmp(gst_structure_get_string(s, "stream"), "video") == 0;
+                    (video ? video_gaps : audio_gaps).push_back(std::fabs(gap_ms));
+                }
+                break;
+            }
+            default: {
+                GError* err = nullptr;
+                gst_message_parse_error(msg, &err, nullptr);
+                std::cerr << "❌ Error: " << err->message << std::endl;
+                g_error_free(err);
+                failed = true;
+                break;
+            }
+        }
+        gst_message_unref(msg);
+    }
+    gst_object_unref(bus);
+    double seconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    guint64 frames = frames_rendered;
+    double stall_ms = max_frame_interval / 1000.0;
+
+    video_gap.detach();
+    audio_gap.detach();
+    close();
+
+    Scenario& scenario = add_scenario(name);
+    scenario.metrics.push_back({"loops", (double)loops});
+    scenario.metrics.push_back({"eos", (double)eos});
+    scenario.metrics.push_back({"seconds", seconds});
+    scenario.metrics.push_back({"frames", (double)frames});
+    scenario.metrics.push_back({"max_frame_interval_ms", stall_ms});
+    if (mode == LoopController::Mode::Off) {
+        return !failed;  // Flushed by the state change: no running-time gap to measure
+    }
+
+    double video_max = percentile(video_gaps, 1.0);
+    double audio_max = percentile(audio_gaps, 1.0);
+    bool within = eos == 0 && video_max <= LOOP_GAP_BUDGET_MS && audio_max <= LOOP_GAP_BUDGET_MS;
+    scenario.metrics.push_back({"video_gap_max_ms", video_max});
+    scenario.metrics.push_back({"audio_gap_max_ms", audio_max});
+    scenario.metrics.push_back({"gaps_measured", (double)(video_gaps.size() + audio_gaps.size())});
+    scenario.metrics.push_back({"within_budget", within ? 1 : 0});
+    if (!within) {
+        std::cerr << "❌ " << name << ": loop gap video " << video_max << " ms, audio " << audio_max
+                  << " ms, " << eos << " EOS (budget " << LOOP_GAP_BUDGET_MS << " ms, no EOS)" << std::endl;
+    }
+    return within && !failed;
+}
+
+// The same random scrub seeks through SeekScheduler without and then with
+// the keyframe sidecar (built here if needed; the build time is reported
+// separately)
+bool Benchmark::bench_seek_indexed() {
+    KeyframeIndex keyframes;
+    gint64 build_start = g_get_monotonic_time();
+    keyframes.open(options.file);
+    while (!keyframes.ready() && g_get_monotonic_time() - build_start < INDEX_TIMEOUT_US) {
+        g_main_context_iteration(nullptr, FALSE);
+        g_usleep(10 * 1000);
+    }
+    double build_ms = (g_get_monotonic_time() - build_start) / 1000.0;
+
+    if (!keyframes.ready()) {
+        std::cerr << "Warning: No keyframe index, skipping indexed seeks" << std::endl;
+        return false;
+    }
+
+    GstBus* bus = gst_element_get_bus(pipeline);
+    int failures = 0;
+
+    // One pass over the seek set; index may be null
+    auto run_set = [&](SeekScheduler& scheduler, const KeyframeIndex* index) {
+        scheduler.set_pipeline(pipeline);
+        scheduler.set_keyframe_index(index);
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> position(0.0, 1.0);
+
+        for (int i = 0; i < options.seeks; i++) {
+            guint64 skipped = scheduler.skipped_count();
+            scheduler.request((gint64)(position(rng) * duration), SeekScheduler::Mode::Scrub);
+            if (!scheduler.busy()) {
+                // Nothing sent: either the keyframe already showing, or a failure
+                failures += scheduler.skipped_count() == skipped ? 1 : 0;
+                continue;
+            }
+            GstMessage* msg = gst_bus_timed_pop_filtered(bus, STEP_TIMEOUT_US * GST_USECOND,
+                                                         GST_MESSAGE_ASYNC_DONE);
+            if (!msg) {
+                failures++;
+                scheduler.reset();
+                continue;
+            }
+            scheduler.on_async_done(msg);
+            gst_message_unref(msg);
+        }
+    };
+
+    SeekScheduler unindexed;
+    run_set(unindexed, nullptr);
+    SeekScheduler indexed;
+    run_set(indexed, &keyframes);
+    gst_object_unref(bus);
+
+    Scenario& scenario = add_scenario("seek_indexed");
+    scenario.metrics.push_back({"keyframes", (double)keyframes.size()});
+    scenario.metrics.push_back({"index_ready_ms", build_ms});
+    scenario.metrics.push_back({"indexed_seeks", (double)indexed.indexed_count()});
+    scenario.metrics.push_back({"skipped_seeks", (double)indexed.skipped_count()});
+    scenario.metrics.push_back({"failures", (double)failures});
+    scenario.metrics.push_back({"p50_ms", indexed.latency_percentile(0.5)});
+    scenario.metrics.push_back({"p99_ms", indexed.latency_percentile(0.99)});
+    scenario.metrics.push_back({"unindexed_p50_ms", unindexed.latency_percentile(0.5)});
+    scenario.metrics.push_back({"unindexed_p99_ms", unindexed.latency_percentile(0.99)});
+    if (indexed.indexed_count() == 0) {
+        std::cerr << "❌ seek_indexed: no seek went through the keyframe index" << std::endl;
+        return false;
+    }
+    return failures == 0;
+}
+
+std::string Benchmark::to_json() const {
+    std::ostringstream out;
+    gchar* version = gst_version_string();
+
+    out << "{\n";
+    out << "  \"file\": \"" << json_escape(options.file) << "\",\n";
+    out << "  \"gstreamer\": \"" << json_escape(version) << "\",\n";
+    out << "  \"duration_s\": " << (double)duration / GST_SECOND << ",\n";
+    out << "  \"scenarios\": {";
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        out << (i ? ",\n" : "\n") << "    \"" << scenarios[i].name << "\": {";
+        const auto& metrics = scenarios[i].metrics;
+        for (size_t j = 0; j < metrics.size(); j++) {
+            out << (j ? ", " : "") << "\"" << metrics[j].first << "\": " << metrics[j].second;
+        }
+        out << "}";
+    }
+    out << "\n  }\n}\n";
+
+    g_free(version);
+    return out.str();
+}
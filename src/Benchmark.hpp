@@ -0,0 +1,94 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <atomic>
+#include "PipelineLoader.hpp"
+#include "SeekScheduler.hpp"
+#include "DecoderPolicy.hpp"
+#include "PlaybackRate.hpp"
+#include "MemoryBudget.hpp"
+#include "LoopController.hpp"
+
+struct BenchOptions {
+    std::string file;
+    std::string output;          // JSON path, stdout when empty
+    int open_runs = 5;           // Cold open + (open_runs - 1) warm opens
+    int seeks = 50;              // Random seeks per seek mode
+    double decode_seconds = 10;  // Cap for the sustained decode run
+    double render_seconds = 10;  // Real-time playback per on-screen sink, 0 to skip
+    double rate_seconds = 10;    // Real-time playback per speed, 0 to skip
+    int switch_runs = 10;        // File switches per mode (rebuild, reuse), 0 to skip
+    std::string switch_file;     // Switched to and from file; file itself when empty
+    double soak_seconds = 0;     // Budgeted playback of a synthetic 4K stream, 0 to skip
+    int memory_budget_mb = 512;  // Cap the soak's peak RSS must stay under
+    int loop_runs = 5;           // Loop restarts per loop mode over a generated clip, 0 to skip
+    bool has_display = false;    // GTK initialised; the render scenarios need a window
+    std::vector<int> thread_settings = {1, 2, 4, -1, 0};  // Decode runs; -1 = all cores, 0 = policy
+};
+
+// Headless benchmark: runs the player's pipeline-building path with
+// fakesink outputs and records open, first-frame, decode and seek timings.
+// With a display it also compares CPU per frame of the on-screen outputs.
+class Benchmark {
+public:
+    explicit Benchmark(const BenchOptions& options);
+    ~Benchmark();
+
+    // Run every scenario; false if the file could not be opened or fast
+    // playback went over its CPU budget
+    bool run();
+    std::string to_json() const;
+
+private:
+    struct Scenario {
+        std::string name;
+        std::vector<std::pair<std::string, double>> metrics;
+    };
+
+    BenchOptions options;
+    GMainLoop* loop;
+    GstElement* pipeline;
+    GstElement* video_sink;  // The fakesink that counts frames
+    DecoderPolicy decoder_policy;
+    bool use_policy;         // Apply decoder_policy to pipelines opened from now on
+    MemoryBudget memory_budget;  // Applied to pipelines opened while enabled
+    gint64 duration;
+    std::vector<Scenario> scenarios;
+
+    // Written from the streaming thread by the handoff callback
+    std::atomic<guint64> frames_rendered;
+    std::atomic<gint64> first_frame_time;
+    std::atomic<gint64> last_frame_time;
+    std::atomic<gint64> max_frame_interval;  // Longest wait between two frames (us)
+
+    bool open(gint64& preroll_ns, bool synced = false, const std::string& file = "");
+    bool reuse(const std::string& file, gint64& preroll_ns);
+    void close();
+    bool wait_for(GstMessageType types, gint64 timeout_us);
+
+    bool bench_open();
+    bool bench_first_frame();
+    bool bench_decode(const std::string& name = "decode");
+    void bench_decode_threads();
+    bool bench_seek(const std::string& name, GstSeekFlags flags);
+    bool bench_scrub();
+    bool bench_seek_indexed();
+    bool bench_render(const std::string& name, const std::string& video_sink,
+                      int width = 1280, int height = 720, bool downscale = true);
+    bool bench_rates();
+    bool bench_switch();
+    bool bench_soak();
+    bool bench_loops();
+    bool bench_loop(const std::string& name, const std::string& clip, LoopController::Mode mode);
+
+    Scenario& add_scenario(const std::string& name);
+    static std::vector<PipelineConfig> headless_configs(const std::string& filename, bool synced);
+    static double percentile(std::vector<double> values, double p);
+    static void on_handoff(GstElement* sink, GstBuffer* buffer, GstPad* pad, gpointer data);
+};
+
+#endif // BENCHMARK_HPP
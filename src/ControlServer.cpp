@@ -0,0 +1,201 @@
+#include "ControlServer.hpp"
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+#include <iostream>
+#include <algorithm>
+
+// send() gives up on an instance that does not answer within this long
+static const int CLIENT_TIMEOUT_S = 5;
+
+struct ControlServer::Client {
+    ControlServer* server;  // nullptr once the server stopped
+    GSocketConnection* connection;
+    GDataInputStream* input;
+    GCancellable* cancellable;
+    std::string reply;      // Kept alive while it is written
+};
+
+ControlServer::ControlServer() : service(nullptr) {
+}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+std::string ControlServer::default_path() {
+    gchar* path = g_build_filename(g_get_user_runtime_dir(), "vidc", "control.sock", nullptr);
+    std::string result = path;
+    g_free(path);
+    return result;
+}
+
+bool ControlServer::start(const std::string& path, Handler new_handler) {
+    stop();
+
+    // A socket file nobody answers on is left over from a crash
+    if (g_file_test(path.c_str(), G_FILE_TEST_EXISTS)) {
+        std::vector<std::string> replies;
+        if (send(path, {"ping"}, replies)) {
+            return false;
+        }
+        g_unlink(path.c_str());
+    }
+
+    gchar* dir = g_path_get_dirname(path.c_str());
+    g_mkdir_with_parents(dir, 0700);
+    g_free(dir);
+
+    GSocketService* new_service = g_socket_service_new();
+    GSocketAddress* address = g_unix_socket_address_new(path.c_str());
+    GError* error = nullptr;
+    gboolean added = g_socket_listener_add_address(G_SOCKET_LISTENER(new_service), address,
+                                                   G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                                   nullptr, nullptr, &error);
+    g_object_unref(address);
+    if (!added) {
+        std::cerr << "Warning: Could not listen on " << path << ": " << error->message << std::endl;
+        g_error_free(error);
+        g_object_unref(new_service);
+        return false;
+    }
+
+    service = new_service;
+    socket_path = path;
+    handler = std::move(new_handler);
+    g_signal_connect(service, "incoming", G_CALLBACK(on_incoming), this);
+    g_socket_service_start(service);
+    return true;
+}
+
+void ControlServer::stop() {
+    // Pending reads and writes finish with G_IO_ERROR_CANCELLED and free
+    // their client
+    for (Client* client : clients) {
+        client->server = nullptr;
+        g_cancellable_cancel(client->cancellable);
+    }
+    clients.clear();
+
+    if (service) {
+        g_socket_service_stop(service);
+        g_socket_listener_close(G_SOCKET_LISTENER(service));
+        g_object_unref(service);
+        service = nullptr;
+        g_unlink(socket_path.c_str());
+    }
+}
+
+gboolean ControlServer::on_incoming(GSocketService* service, GSocketConnection* connection,
+                                    GObject* source, gpointer data) {
+    ControlServer* server = static_cast<ControlServer*>(data);
+
+    Client* client = new Client();
+    client->server = server;
+    client->connection = G_SOCKET_CONNECTION(g_object_ref(connection));
+    client->input = g_data_input_stream_new(g_io_stream_get_input_stream(G_IO_STREAM(connection)));
+    client->cancellable = g_cancellable_new();
+    server->clients.push_back(client);
+
+    read_next(client);
+    return TRUE;
+}
+
+void ControlServer::read_next(Client* client) {
+    g_data_input_stream_read_line_async(client->input, G_PRIORITY_DEFAULT, client->cancellable,
+                                        on_line, client);
+}
+
+void ControlServer::on_line(GObject* source, GAsyncResult* result, gpointer data) {
+    Client* client = static_cast<Client*>(data);
+    gsize length = 0;
+    gchar* line = g_data_input_stream_read_line_finish_utf8(G_DATA_INPUT_STREAM(source), result, &length, nullptr);
+
+    // EOF, an error, invalid UTF-8 or the server stopped
+    if (!line || !client->server) {
+        g_free(line);
+        if (client->server) {
+            client->server->close_client(client);
+        } else {
+            free_client(client);
+        }
+        return;
+    }
+
+    std::string request = g_strstrip(line);
+    g_free(line);
+    size_t space = request.find(' ');
+    std::string command = request.substr(0, space);
+    std::string argument = space != std::string::npos ? request.substr(space + 1) : "";
+    argument.erase(0, argument.find_first_not_of(' '));
+
+    client->reply = command.empty() ? "error empty request" : client->server->handler(command, argument);
+    client->reply += '\n';
+
+    GOutputStream* output = g_io_stream_get_output_stream(G_IO_STREAM(client->connection));
+    g_output_stream_write_all_async(output, client->reply.data(), client->reply.size(), G_PRIORITY_DEFAULT,
+                                    client->cancellable, on_written, client);
+}
+
+void ControlServer::on_written(GObject* source, GAsyncResult* result, gpointer data) {
+    Client* client = static_cast<Client*>(data);
+    gboolean written = g_output_stream_write_all_finish(G_OUTPUT_STREAM(source), result, nullptr, nullptr);
+
+    if (!client->server) {
+        free_client(client);
+    } else if (!written) {
+        client->server->close_client(client);
+    } else {
+        read_next(client);
+    }
+}
+
+void ControlServer::close_client(Client* client) {
+    clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+    free_client(client);
+}
+
+void ControlServer::free_client(Client* client) {
+    g_io_stream_close(G_IO_STREAM(client->connection), nullptr, nullptr);
+    g_object_unref(client->input);
+    g_object_unref(client->connection);
+    g_object_unref(client->cancellable);
+    delete client;
+}
+
+bool ControlServer::send(const std::string& path, const std::vector<std::string>& requests,
+                         std::vector<std::string>& replies) {
+    GSocketClient* socket_client = g_socket_client_new();
+    GSocketAddress* address = g_unix_socket_address_new(path.c_str());
+    GSocketConnection* connection = g_socket_client_connect(socket_client, G_SOCKET_CONNECTABLE(address),
+                                                            nullptr, nullptr);
+    g_object_unref(address);
+    g_object_unref(socket_client);
+    if (!connection) {
+        return false;
+    }
+
+    g_socket_set_timeout(g_socket_connection_get_socket(connection), CLIENT_TIMEOUT_S);
+    GOutputStream* output = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    GDataInputStream* input = g_data_input_stream_new(g_io_stream_get_input_stream(G_IO_STREAM(connection)));
+
+    bool ok = true;
+    for (const std::string& request : requests) {
+        std::string line = request + '\n';
+        if (!g_output_stream_write_all(output, line.data(), line.size(), nullptr, nullptr, nullptr)) {
+            ok = false;
+            break;
+        }
+        gchar* reply = g_data_input_stream_read_line_utf8(input, nullptr, nullptr, nullptr);
+        if (!reply) {
+            ok = false;
+            break;
+        }
+        replies.push_back(reply);
+        g_free(reply);
+    }
+
+    g_object_unref(input);
+    g_io_stream_close(G_IO_STREAM(connection), nullptr, nullptr);
+    g_object_unref(connection);
+    return ok;
+}
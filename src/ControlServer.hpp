@@ -0,0 +1,56 @@
+#ifndef CONTROL_SERVER_HPP
+#define CONTROL_SERVER_HPP
+
+#include <gio/gio.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+// Local control socket of a single-instance player. Clients connect to a
+// Unix domain socket and send one request per line ("seek 42.5",
+// "open /media/clip.mp4"); every request gets exactly one reply line,
+// "ok ..." or "error ...". Connections are read asynchronously on the
+// main loop, so commands run between frames and a slow client never
+// blocks playback. A client's next line is read once its reply has been
+// written.
+class ControlServer {
+public:
+    // Runs on the main loop; returns the reply without the newline
+    using Handler = std::function<std::string(const std::string& command, const std::string& argument)>;
+
+    ControlServer();
+    ~ControlServer();
+
+    // Listen on path (a stale socket left by a crash is replaced); false
+    // if another instance answers there or the socket cannot be created
+    bool start(const std::string& path, Handler handler);
+    void stop();
+    bool listening() const { return service != nullptr; }
+
+    // Client side: send every request and collect one reply per request;
+    // false if nothing listens on path
+    static bool send(const std::string& path, const std::vector<std::string>& requests,
+                     std::vector<std::string>& replies);
+
+    // $XDG_RUNTIME_DIR/vidc/control.sock
+    static std::string default_path();
+
+private:
+    struct Client;
+
+    GSocketService* service;
+    std::string socket_path;
+    Handler handler;
+    std::vector<Client*> clients;
+
+    void close_client(Client* client);
+    static void read_next(Client* client);
+    static void free_client(Client* client);
+
+    static gboolean on_incoming(GSocketService* service, GSocketConnection* connection,
+                                GObject* source, gpointer data);
+    static void on_line(GObject* source, GAsyncResult* result, gpointer data);
+    static void on_written(GObject* source, GAsyncResult* result, gpointer data);
+};
+
+#endif // CONTROL_SERVER_HPP
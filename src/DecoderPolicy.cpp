@@ -0,0 +1,212 @@
+#include "DecoderPolicy.hpp"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+// Pixel counts (with some slack for cropped encodes) of the resolution tiers
+static const gint64 PIXELS_2160P = 3840LL * 2160 * 9 / 10;
+static const gint64 PIXELS_1080P = 1920LL * 1080 * 9 / 10;
+static const gint64 PIXELS_720P = 1280LL * 720 * 9 / 10;
+
+static bool valid_thread_type(const std::string& type) {
+    return type == "frame" || type == "slice" || type == "auto";
+}
+
+// Integer-valued properties are int on some decoders and uint on others
+static bool set_count_property(GObject* object, const char* name, int value) {
+    GParamSpec* spec = g_object_class_find_property(G_OBJECT_GET_CLASS(object), name);
+    if (!spec) {
+        return false;
+    }
+    if (spec->value_type == G_TYPE_INT) {
+        g_object_set(object, name, value, nullptr);
+    } else if (spec->value_type == G_TYPE_UINT) {
+        g_object_set(object, name, (guint)value, nullptr);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+DecoderPolicy::DecoderPolicy()
+    : override_threads(-1), cores(std::max(1, (int)g_get_num_processors())) {
+}
+
+std::string DecoderPolicy::default_path() {
+    return (fs::path(g_get_user_config_dir()) / "vidc" / "decoder.conf").string();
+}
+
+bool DecoderPolicy::load(const std::string& path) {
+    if (!g_file_test(path.c_str(), G_FILE_TEST_EXISTS)) {
+        return true;
+    }
+
+    GKeyFile* file = g_key_file_new();
+    GError* error = nullptr;
+    if (!g_key_file_load_from_file(file, path.c_str(), G_KEY_FILE_NONE, &error)) {
+        std::cerr << "Warning: Could not read decoder config " << path << ": " << error->message << std::endl;
+        g_error_free(error);
+        g_key_file_free(file);
+        return false;
+    }
+
+    gchar** groups = g_key_file_get_groups(file, nullptr);
+    for (gchar** group = groups; *group; group++) {
+        DecoderThreading rule;
+        if (g_key_file_has_key(file, *group, "max-threads", nullptr)) {
+            rule.max_threads = std::max(0, g_key_file_get_integer(file, *group, "max-threads", nullptr));
+        }
+        gchar* type = g_key_file_get_string(file, *group, "thread-type", nullptr);
+        if (type) {
+            if (valid_thread_type(type)) {
+                rule.thread_type = type;
+            } else {
+                std::cerr << "Warning: Unknown thread-type '" << type << "' in [" << *group << "]" << std::endl;
+            }
+            g_free(type);
+        }
+        rules[*group] = rule;
+    }
+    g_strfreev(groups);
+    g_key_file_free(file);
+
+    std::cout << "Decoder policy: " << rules.size() << " rules from " << path << std::endl;
+    return true;
+}
+
+void DecoderPolicy::set_override(int max_threads, const std::string& thread_type) {
+    override_threads = max_threads;
+    override_type = valid_thread_type(thread_type) ? thread_type : std::string();
+}
+
+int DecoderPolicy::scaled_threads(int width, int height, int cores) {
+    gint64 pixels = (gint64)width * height;
+    int threads;
+    if (pixels >= PIXELS_2160P) {
+        threads = cores;
+    } else if (pixels >= PIXELS_1080P) {
+        threads = std::max(4, cores / 2);
+    } else if (pixels >= PIXELS_720P) {
+        threads = 4;
+    } else {
+        // Small files: more threads only add frame latency and contention
+        threads = 2;
+    }
+    return std::max(1, std::min(threads, cores));
+}
+
+DecoderThreading DecoderPolicy::resolve(const std::string& codec, int width, int height) const {
+    DecoderThreading rule;
+    auto it = rules.find(codec);
+    if (it == rules.end()) {
+        it = rules.find("default");
+    }
+    if (it != rules.end()) {
+        rule = it->second;
+    }
+    if (override_threads >= 0) {
+        rule.max_threads = override_threads;
+    }
+    if (!override_type.empty()) {
+        rule.thread_type = override_type;
+    }
+
+    // Caps without a size (rare for video) are treated as 1080p
+    if (width <= 0 || height <= 0) {
+        width = 1920;
+        height = 1080;
+    }
+
+    if (rule.max_threads <= 0) {
+        rule.max_threads = scaled_threads(width, height, cores);
+    }
+    if (rule.thread_type == "auto") {
+        // Frame threading for throughput on large frames, slice threading
+        // (no added frame delay) where a few threads are enough anyway
+        rule.thread_type = (gint64)width * height >= PIXELS_1080P ? "frame" : "slice";
+    }
+    return rule;
+}
+
+std::string DecoderPolicy::codec_name(const GstStructure* caps) {
+    std::string name = gst_structure_get_name(caps);
+    if (name == "video/mpeg") {
+        gint version = 0;
+        gst_structure_get_int(caps, "mpegversion", &version);
+        return version == 4 ? "mpeg4" : "mpeg2";
+    }
+    if (name.rfind("video/x-", 0) == 0) {
+        return name.substr(strlen("video/x-"));
+    }
+    return name;
+}
+
+void DecoderPolicy::attach(GstElement* pipeline) const {
+    g_signal_connect(pipeline, "deep-element-added", G_CALLBACK(on_element_added),
+                     const_cast<DecoderPolicy*>(this));
+}
+
+void DecoderPolicy::on_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data) {
+    GstElementFactory* factory = gst_element_get_factory(element);
+    const gchar* klass = factory ? gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS) : nullptr;
+    if (!klass || !strstr(klass, "Decoder") || !strstr(klass, "Video")) {
+        return;
+    }
+
+    // Settle the threads once the stream's caps arrive, before the decoder opens
+    GstPad* pad = gst_element_get_static_pad(element, "sink");
+    if (pad) {
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, on_sink_event, data, nullptr);
+        gst_object_unref(pad);
+    }
+}
+
+GstPadProbeReturn DecoderPolicy::on_sink_event(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+    if (GST_EVENT_TYPE(event) != GST_EVENT_CAPS) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstCaps* caps = nullptr;
+    gst_event_parse_caps(event, &caps);
+    GstElement* decoder = gst_pad_get_parent_element(pad);
+    if (decoder) {
+        static_cast<DecoderPolicy*>(data)->apply(decoder, caps);
+        gst_object_unref(decoder);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+void DecoderPolicy::apply(GstElement* decoder, const GstCaps* caps) const {
+    if (!caps || gst_caps_is_empty(caps)) {
+        return;
+    }
+
+    const GstStructure* s = gst_caps_get_structure(caps, 0);
+    std::string codec = codec_name(s);
+    gint width = 0, height = 0;
+    gst_structure_get_int(s, "width", &width);
+    gst_structure_get_int(s, "height", &height);
+
+    DecoderThreading threading = resolve(codec, width, height);
+    GObject* object = G_OBJECT(decoder);
+
+    bool threads_set = set_count_property(object, "max-threads", threading.max_threads) ||
+                       set_count_property(object, "n-threads", threading.max_threads) ||
+                       set_count_property(object, "threads", threading.max_threads);
+    if (!threads_set) {
+        return;
+    }
+
+    bool type_set = g_object_class_find_property(G_OBJECT_GET_CLASS(object), "thread-type") != nullptr;
+    if (type_set) {
+        gst_util_set_object_arg(object, "thread-type", threading.thread_type.c_str());
+    }
+
+    std::cout << "🧵 " << GST_ELEMENT_NAME(decoder) << ": " << codec << " " << width << "x" << height
+              << " -> " << threading.max_threads << " threads"
+              << (type_set ? " (" + threading.thread_type + ")" : std::string()) << std::endl;
+}
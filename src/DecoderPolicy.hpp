@@ -0,0 +1,57 @@
+#ifndef DECODER_POLICY_HPP
+#define DECODER_POLICY_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <map>
+
+// Threading settings for one codec
+struct DecoderThreading {
+    int max_threads = 0;               // 0: scale with core count and resolution
+    std::string thread_type = "auto";  // "frame", "slice" or "auto" (by resolution)
+};
+
+// Applies a per-codec threading policy to the video decoders playbin
+// creates. Decoders are hooked through deep-element-added and configured
+// from their input caps (codec, width, height) before they open, using
+// whichever of max-threads (avdec_*), n-threads (dav1ddec) or threads
+// (vpxdec) they expose, plus thread-type where available.
+//
+// Config file (GKeyFile), one group per codec or [default]:
+//   [h265]
+//   max-threads=16
+//   thread-type=frame
+class DecoderPolicy {
+public:
+    DecoderPolicy();
+
+    // False if the file exists but cannot be parsed
+    bool load(const std::string& path);
+    static std::string default_path();
+
+    // Command-line settings; win over the config file for every codec.
+    // max_threads < 0 / empty thread_type leave that setting alone.
+    void set_override(int max_threads, const std::string& thread_type);
+
+    // Hook decoders added to pipeline from now on; the policy must outlive it
+    void attach(GstElement* pipeline) const;
+
+    // Effective settings for a stream; never returns "auto" or 0 threads
+    DecoderThreading resolve(const std::string& codec, int width, int height) const;
+
+    static int scaled_threads(int width, int height, int cores);
+    static std::string codec_name(const GstStructure* caps);
+
+private:
+    std::map<std::string, DecoderThreading> rules;  // By codec name, "default" for the rest
+    int override_threads;
+    std::string override_type;
+    int cores;
+
+    void apply(GstElement* decoder, const GstCaps* caps) const;
+
+    static void on_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data);
+    static GstPadProbeReturn on_sink_event(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+};
+
+#endif // DECODER_POLICY_HPP
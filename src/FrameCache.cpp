@@ -0,0 +1,206 @@
+#include "FrameCache.hpp"
+
+// Frame duration assumed before the stream has told us
+static const gint64 DEFAULT_FRAME_DURATION = 40 * GST_MSECOND;
+
+FrameCache::FrameCache(size_t max_bytes)
+    : pad(nullptr), probe_id(0), enabled(false), max_bytes(max_bytes), bytes(0),
+      last_seen(-1), last_duration(DEFAULT_FRAME_DURATION),
+      hits(0), misses(0), last_step_latency(0) {
+    gst_segment_init(&segment, GST_FORMAT_TIME);
+}
+
+FrameCache::~FrameCache() {
+    detach();
+}
+
+void FrameCache::set_max_bytes(size_t new_max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    max_bytes = new_max_bytes;
+    evict();
+}
+
+void FrameCache::attach(GstElement* sink) {
+    detach();
+    if (!sink) {
+        return;
+    }
+
+    pad = gst_element_get_static_pad(sink, "sink");
+    if (!pad) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        gst_segment_init(&segment, GST_FORMAT_TIME);
+        last_seen = -1;
+        last_duration = DEFAULT_FRAME_DURATION;
+    }
+    probe_id = gst_pad_add_probe(pad,
+        GstPadProbeType(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+        on_probe, this, nullptr);
+}
+
+void FrameCache::detach() {
+    if (pad) {
+        if (probe_id) {
+            gst_pad_remove_probe(pad, probe_id);
+            probe_id = 0;
+        }
+        gst_object_unref(pad);
+        pad = nullptr;
+    }
+    clear();
+}
+
+void FrameCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : frames) {
+        gst_sample_unref(entry.second.sample);
+    }
+    frames.clear();
+    order.clear();
+    bytes = 0;
+}
+
+void FrameCache::set_enabled(bool new_enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    enabled = new_enabled;
+}
+
+GstSample* FrameCache::lookup_before(gint64 position) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = frames.lower_bound(position);
+    if (it == frames.begin()) {
+        return nullptr;
+    }
+    --it;
+    return gst_sample_ref(it->second.sample);
+}
+
+GstSample* FrameCache::lookup_after(gint64 position) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = frames.upper_bound(position);
+    if (it == frames.end()) {
+        return nullptr;
+    }
+    return gst_sample_ref(it->second.sample);
+}
+
+gint64 FrameCache::last_position() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return last_seen;
+}
+
+gint64 FrameCache::frame_duration() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return last_duration;
+}
+
+void FrameCache::record_step(bool hit, double latency_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    (hit ? hits : misses)++;
+    last_step_latency = latency_ms;
+}
+
+double FrameCache::hit_rate() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    guint64 total = hits + misses;
+    return total ? (double)hits / total : 0;
+}
+
+size_t FrameCache::size_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
+
+gint64 FrameCache::sample_position(GstSample* sample) {
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    const GstSegment* sample_segment = gst_sample_get_segment(sample);
+    if (!buffer || !sample_segment || !GST_BUFFER_PTS_IS_VALID(buffer)) {
+        return -1;
+    }
+    GstClockTime position = gst_segment_to_stream_time(sample_segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    return GST_CLOCK_TIME_IS_VALID(position) ? (gint64)position : -1;
+}
+
+void FrameCache::insert(GstBuffer* buffer, GstCaps* caps) {
+    // Copy outside the lock; frames can be several MB
+    GstBuffer* copy = gst_buffer_copy_deep(buffer);
+    size_t size = gst_buffer_get_size(copy);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    GstSample* sample = gst_sample_new(copy, caps, &segment, nullptr);
+    gst_buffer_unref(copy);
+
+    gint64 position = sample_position(sample);
+    if (position < 0) {
+        gst_sample_unref(sample);
+        return;
+    }
+
+    auto it = frames.find(position);
+    if (it != frames.end()) {
+        bytes -= it->second.bytes;
+        gst_sample_unref(it->second.sample);
+        it->second = {sample, size};
+    } else {
+        frames[position] = {sample, size};
+        order.push_back(position);
+    }
+    bytes += size;
+    evict();
+}
+
+void FrameCache::evict() {
+    while (bytes > max_bytes && !order.empty()) {
+        auto it = frames.find(order.front());
+        order.pop_front();
+        if (it != frames.end()) {
+            bytes -= it->second.bytes;
+            gst_sample_unref(it->second.sample);
+            frames.erase(it);
+        }
+    }
+}
+
+GstPadProbeReturn FrameCache::on_probe(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    FrameCache* cache = static_cast<FrameCache*>(data);
+
+    if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+            const GstSegment* new_segment;
+            gst_event_parse_segment(event, &new_segment);
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            gst_segment_copy_into(new_segment, &cache->segment);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    bool copy;
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        if (GST_BUFFER_PTS_IS_VALID(buffer) && cache->segment.format == GST_FORMAT_TIME) {
+            GstClockTime position = gst_segment_to_stream_time(&cache->segment, GST_FORMAT_TIME,
+                                                               GST_BUFFER_PTS(buffer));
+            if (GST_CLOCK_TIME_IS_VALID(position)) {
+                cache->last_seen = position;
+            }
+        }
+        if (GST_BUFFER_DURATION_IS_VALID(buffer) && GST_BUFFER_DURATION(buffer) > 0) {
+            cache->last_duration = GST_BUFFER_DURATION(buffer);
+        }
+        copy = cache->enabled && cache->max_bytes > 0;
+    }
+
+    if (copy) {
+        GstCaps* caps = gst_pad_get_current_caps(pad);
+        if (caps) {
+            cache->insert(buffer, caps);
+            gst_caps_unref(caps);
+        }
+    }
+    return GST_PAD_PROBE_OK;
+}
@@ -0,0 +1,77 @@
+#ifndef FRAME_CACHE_HPP
+#define FRAME_CACHE_HPP
+
+#include <gst/gst.h>
+#include <map>
+#include <deque>
+#include <mutex>
+
+// Memory-bounded cache of decoded frames seen by the video sink, keyed by
+// stream time. While enabled (paused, stepping, reverse playback) every
+// frame reaching the sink pad is deep-copied in, so stepping backwards
+// through a GOP that was decoded once is a lookup instead of a re-decode.
+// Copies keep pool buffers free for the pipeline. Oldest frames are
+// evicted first once max_bytes is exceeded.
+class FrameCache {
+public:
+    explicit FrameCache(size_t max_bytes = 256 * 1024 * 1024);
+    ~FrameCache();
+
+    void set_max_bytes(size_t bytes);
+
+    // Probe the "sink" pad of sink (element or bin); drops cached frames
+    void attach(GstElement* sink);
+    void detach();
+    void clear();
+
+    // Only copy frames while they may be stepped back to
+    void set_enabled(bool enabled);
+
+    // Newest cached frame before / oldest after position (caller unrefs)
+    GstSample* lookup_before(gint64 position);
+    GstSample* lookup_after(gint64 position);
+
+    // Stream time of the last frame that reached the sink, -1 if none
+    gint64 last_position() const;
+    // Duration of the last frame, 40 ms when unknown
+    gint64 frame_duration() const;
+
+    // Step statistics, recorded by the caller
+    void record_step(bool hit, double latency_ms);
+    double hit_rate() const;
+    double last_step_ms() const { return last_step_latency; }
+
+    size_t size_bytes() const;
+
+    static gint64 sample_position(GstSample* sample);
+
+private:
+    struct Frame {
+        GstSample* sample;
+        size_t bytes;
+    };
+
+    GstPad* pad;
+    gulong probe_id;
+
+    mutable std::mutex mutex;
+    bool enabled;
+    size_t max_bytes;
+    size_t bytes;
+    std::map<gint64, Frame> frames;  // By stream time
+    std::deque<gint64> order;        // Insertion order, for eviction
+    GstSegment segment;
+    gint64 last_seen;
+    gint64 last_duration;
+
+    guint64 hits;
+    guint64 misses;
+    double last_step_latency;
+
+    void insert(GstBuffer* buffer, GstCaps* caps);
+    void evict();  // Caller holds mutex
+
+    static GstPadProbeReturn on_probe(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+};
+
+#endif // FRAME_CACHE_HPP
@@ -0,0 +1,111 @@
+#include "GapMeter.hpp"
+
+GapMeter::GapMeter(const std::string& label)
+    : label(label), pad(nullptr), probe_id(0),
+      last_end(GST_CLOCK_TIME_NONE), awaiting_first(false), new_item(false) {
+    gst_segment_init(&segment, GST_FORMAT_TIME);
+}
+
+GapMeter::~GapMeter() {
+    detach();
+}
+
+void GapMeter::attach(GstElement* new_sink) {
+    detach();
+    if (!new_sink) {
+        return;
+    }
+
+    pad = gst_element_get_static_pad(new_sink, "sink");
+    if (!pad) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        gst_segment_init(&segment, GST_FORMAT_TIME);
+        last_end = GST_CLOCK_TIME_NONE;
+        awaiting_first = false;
+        new_item = false;
+    }
+    probe_id = gst_pad_add_probe(pad,
+        GstPadProbeType(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+        on_probe, this, nullptr);
+}
+
+void GapMeter::detach() {
+    if (pad) {
+        if (probe_id) {
+            gst_pad_remove_probe(pad, probe_id);
+            probe_id = 0;
+        }
+        gst_object_unref(pad);
+        pad = nullptr;
+    }
+}
+
+GstPadProbeReturn GapMeter::on_probe(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    GapMeter* meter = static_cast<GapMeter*>(data);
+    std::lock_guard<std::mutex> lock(meter->mutex);
+
+    if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+            const GstSegment* new_segment;
+            gst_event_parse_segment(event, &new_segment);
+            gst_segment_copy_into(new_segment, &meter->segment);
+            meter->awaiting_first = GST_CLOCK_TIME_IS_VALID(meter->last_end);
+        } else if (GST_EVENT_TYPE(event) == GST_EVENT_STREAM_START) {
+            meter->awaiting_first = GST_CLOCK_TIME_IS_VALID(meter->last_end);
+            meter->new_item = meter->awaiting_first;
+        } else if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP) {
+            // A seek is not an item transition
+            meter->last_end = GST_CLOCK_TIME_NONE;
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!GST_BUFFER_PTS_IS_VALID(buffer) || meter->segment.format != GST_FORMAT_TIME) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    // Parts outside the segment are dropped (or clipped) by the sink
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    GstClockTime end = GST_BUFFER_DURATION_IS_VALID(buffer) ? pts + GST_BUFFER_DURATION(buffer) : GST_CLOCK_TIME_NONE;
+    guint64 clip_start = 0, clip_end = 0;
+    if (!gst_segment_clip(&meter->segment, GST_FORMAT_TIME, pts, end, &clip_start, &clip_end)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstClockTime start = gst_segment_to_running_time(&meter->segment, GST_FORMAT_TIME, clip_start);
+    if (!GST_CLOCK_TIME_IS_VALID(start)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    if (meter->awaiting_first) {
+        meter->awaiting_first = false;
+        const char* transition = meter->new_item ? "item" : "segment";
+        meter->new_item = false;
+        double gap_ms = (GST_CLOCK_DIFF(meter->last_end, start)) / (double)GST_MSECOND;
+
+        GstStructure* s = gst_structure_new(MESSAGE_NAME,
+            "stream", G_TYPE_STRING, meter->label.c_str(),
+            "gap-ms", G_TYPE_DOUBLE, gap_ms,
+            "transition", G_TYPE_STRING, transition, nullptr);
+        // The pad's own parent: detach() does not wait for a probe already running
+        GstElement* parent = gst_pad_get_parent_element(pad);
+        if (parent) {
+            gst_element_post_message(parent, gst_message_new_application(GST_OBJECT(parent), s));
+            gst_object_unref(parent);
+        } else {
+            gst_structure_free(s);
+        }
+    }
+
+    GstClockTime stop = GST_CLOCK_TIME_IS_VALID(clip_end)
+        ? gst_segment_to_running_time(&meter->segment, GST_FORMAT_TIME, clip_end)
+        : GST_CLOCK_TIME_NONE;
+    meter->last_end = GST_CLOCK_TIME_IS_VALID(stop) ? stop : start;
+    return GST_PAD_PROBE_OK;
+}
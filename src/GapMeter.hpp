@@ -0,0 +1,41 @@
+#ifndef GAP_METER_HPP
+#define GAP_METER_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <mutex>
+
+// Measures the gap between the last buffer of one stream and the first
+// buffer of the next on a sink pad, in running time. Buffers are clipped
+// to their segment first, as the sink does. A new segment without a
+// flush (a loop's segment seek) counts as a transition too. Each
+// measurement is posted on the pipeline bus as an application message:
+//   "gap-measured", stream=<label>, gap-ms=<double> (negative = overlap),
+//   transition="item" or "segment"
+class GapMeter {
+public:
+    explicit GapMeter(const std::string& label);
+    ~GapMeter();
+
+    // Probe the "sink" pad of sink (element or bin); replaces any earlier probe
+    void attach(GstElement* sink);
+    void detach();
+
+    static constexpr const char* MESSAGE_NAME = "gap-measured";
+
+private:
+    std::string label;
+    GstPad* pad;
+    gulong probe_id;
+
+    // Streaming-thread state
+    std::mutex mutex;
+    GstSegment segment;
+    GstClockTime last_end;      // Running time where the previous buffer ended
+    bool awaiting_first;        // STREAM_START or SEGMENT seen, next buffer starts a new item
+    bool new_item;              // ... and it was STREAM_START
+
+    static GstPadProbeReturn on_probe(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+};
+
+#endif // GAP_METER_HPP
@@ -0,0 +1,9 @@
+#ifndef JSON_ESCAPE_HPP
+#define JSON_ESCAPE_HPP
+
+#include <string>
+
+// text as the body of a JSON string literal (quotes not included)
+std::string json_escape(const std::string& text);
+
+#endif // JSON_ESCAPE_HPP
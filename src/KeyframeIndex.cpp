@@ -0,0 +1,412 @@
+#include "KeyframeIndex.hpp"
+#include "AtomicFile.hpp"
+#include "ThreadPriority.hpp"
+#include <glib/gstdio.h>
+#include <gst/base/gsttypefindhelper.h>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Head of the file read to identify the container and find its index
+static const size_t PROBE_SIZE = 64 * 1024;
+
+// filesrc read size; also the granularity of the recorded offsets
+static const guint READ_BLOCK_SIZE = 64 * 1024;
+
+// Bus waits are sliced so a cancelled build stops promptly
+static const GstClockTime BUS_POLL = 100 * GST_MSECOND;
+
+// Sidecar layout: header, then `count` Entry records sorted by timestamp
+static const char SIDECAR_MAGIC[4] = {'V', 'K', 'F', 'I'};
+static const guint32 SIDECAR_VERSION = 1;
+
+struct SidecarHeader {
+    char magic[4];
+    guint32 version;
+    guint64 file_size;  // Media file identity when the index was built
+    gint64 mtime;
+    guint64 count;
+};
+
+struct KeyframeIndex::Build {
+    KeyframeIndex* owner = nullptr;  // Main thread only, valid while not cancelled
+    std::atomic<bool> cancelled{false};
+    std::string filename;
+    std::string sidecar;
+    guint64 file_size = 0;
+    gint64 mtime = 0;
+
+    // Streaming threads of the indexer pipeline
+    std::atomic<guint64> read_offset{0};   // Start of the last block read by filesrc
+    std::atomic<bool> has_video{false};
+    guint64 previous_offset = 0;           // read_offset when the previous video buffer came out
+    GstSegment segment;
+    std::vector<Entry> entries;
+};
+
+static bool stat_file(const std::string& filename, guint64& size, gint64& mtime) {
+    GStatBuf st;
+    if (g_stat(filename.c_str(), &st) != 0) {
+        return false;
+    }
+    size = (guint64)st.st_size;
+    mtime = (gint64)st.st_mtime;
+    return true;
+}
+
+KeyframeIndex::KeyframeIndex() : map(nullptr), map_size(0), entries(nullptr), count(0) {
+}
+
+KeyframeIndex::~KeyframeIndex() {
+    close();
+}
+
+// AVI: a legacy idx1 chunk after movi, or OpenDML indx chunks in the header
+static bool avi_has_index(std::ifstream& in, const std::string& head) {
+    if (head.find("indx") != std::string::npos) {
+        return true;
+    }
+    // Walk the top-level chunks of the first RIFF; movi is skipped by size
+    guint64 offset = 12;
+    char header[8];
+    while (in.seekg(offset) && in.read(header, sizeof(header))) {
+        if (memcmp(header, "idx1", 4) == 0) {
+            return true;
+        }
+        guint32 size = GST_READ_UINT32_LE(header + 4);
+        offset += sizeof(header) + size + (size & 1);
+    }
+    return false;
+}
+
+// Matroska: the SeekHead at the start of the segment points at the Cues
+// when the muxer wrote them (SeekID element, size 4, Cues element ID)
+static bool matroska_has_index(const std::string& head) {
+    static const char SEEK_TO_CUES[] = {'\x53', '\xAB', '\x84', '\x1C', '\x53', '\xBB', '\x6B'};
+    return head.find(std::string(SEEK_TO_CUES, sizeof(SEEK_TO_CUES))) != std::string::npos;
+}
+
+bool KeyframeIndex::needs_index(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    std::string head(PROBE_SIZE, '\0');
+    in.read(&head[0], head.size());
+    head.resize(in.gcount());
+    in.clear();
+    if (head.empty()) {
+        return false;
+    }
+
+    GstCaps* caps = gst_type_find_helper_for_data(nullptr, reinterpret_cast<const guint8*>(head.data()),
+                                                  head.size(), nullptr);
+    if (!caps) {
+        return false;
+    }
+    GstStructure* structure = gst_caps_get_structure(caps, 0);
+    std::string type = gst_structure_get_name(structure);
+    gboolean system_stream = FALSE;
+    gst_structure_get_boolean(structure, "systemstream", &system_stream);
+    gst_caps_unref(caps);
+
+    // MPEG-TS/PS have no index at all
+    if (type == "video/mpegts" || (type == "video/mpeg" && system_stream)) {
+        return true;
+    }
+    if (type == "video/x-msvideo") {
+        return !avi_has_index(in, head);
+    }
+    if (type == "video/x-matroska" || type == "video/webm") {
+        return !matroska_has_index(head);
+    }
+    // MP4, Ogg and the rest seek through their own tables
+    return false;
+}
+
+std::string KeyframeIndex::sidecar_path(const std::string& filename) {
+    std::error_code ec;
+    std::string absolute = fs::absolute(filename, ec).string();
+    gchar* hash = g_compute_checksum_for_string(G_CHECKSUM_SHA1, absolute.c_str(), -1);
+    std::string path = (fs::path(g_get_user_cache_dir()) / "vidc" / "keyframes" / (std::string(hash) + ".kfi")).string();
+    g_free(hash);
+    return path;
+}
+
+void KeyframeIndex::open(const std::string& new_filename) {
+    if (new_filename == filename && (ready() || build)) {
+        return;
+    }
+    close();
+    filename = new_filename;
+
+    if (map_sidecar()) {
+        std::cout << "Keyframe index: " << count << " keyframes from sidecar" << std::endl;
+        return;
+    }
+
+    auto job = std::make_shared<Build>();
+    job->owner = this;
+    job->filename = filename;
+    job->sidecar = sidecar_path(filename);
+    if (!stat_file(filename, job->file_size, job->mtime)) {
+        return;
+    }
+    build = job;
+
+    // Detached: closing the index must not wait for a scan of a huge file
+    std::thread(worker, job).detach();
+}
+
+void KeyframeIndex::close() {
+    if (build) {
+        build->cancelled = true;
+        build.reset();
+    }
+    unmap();
+    filename.clear();
+}
+
+bool KeyframeIndex::lookup(gint64 position, Entry& entry) const {
+    if (!entries || count == 0) {
+        return false;
+    }
+
+    const Entry* end = entries + count;
+    const Entry* it = std::upper_bound(entries, end, position,
+        [](gint64 value, const Entry& e) { return value < e.timestamp; });
+    if (it == entries) {
+        return false;
+    }
+    entry = *(it - 1);
+    return true;
+}
+
+bool KeyframeIndex::map_sidecar() {
+    guint64 file_size;
+    gint64 mtime;
+    if (!stat_file(filename, file_size, mtime)) {
+        return false;
+    }
+
+    int fd = ::open(sidecar_path(filename).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(SidecarHeader)) {
+        data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    // A sidecar for an older version of the file (or a torn one) is ignored
+    const SidecarHeader* header = static_cast<const SidecarHeader*>(data);
+    if (memcmp(header->magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC)) != 0 ||
+        header->version != SIDECAR_VERSION || header->file_size != file_size ||
+        header->mtime != mtime ||
+        sizeof(SidecarHeader) + header->count * sizeof(Entry) != (size_t)st.st_size) {
+        munmap(data, st.st_size);
+        return false;
+    }
+
+    map = data;
+    map_size = st.st_size;
+    entries = reinterpret_cast<const Entry*>(static_cast<const char*>(data) + sizeof(SidecarHeader));
+    count = header->count;
+    return true;
+}
+
+void KeyframeIndex::unmap() {
+    if (map) {
+        munmap(map, map_size);
+        map = nullptr;
+        map_size = 0;
+    }
+    entries = nullptr;
+    count = 0;
+}
+
+void KeyframeIndex::worker(std::shared_ptr<Build> build) {
+    // Indexing reads the whole file; keep it out of playback's way
+    lower_thread_priority();
+    if (!needs_index(build->filename)) {
+        return;
+    }
+
+    gint64 start = g_get_monotonic_time();
+    bool ok = scan(*build);
+    if (build->cancelled) {
+        return;
+    }
+
+    if (ok && !build->entries.empty() && write_sidecar(*build)) {
+        std::cout << "Keyframe index: " << build->entries.size() << " keyframes in "
+                  << (g_get_monotonic_time() - start) / 1000 << " ms" << std::endl;
+        g_idle_add(deliver, new std::shared_ptr<Build>(build));
+    }
+}
+
+gboolean KeyframeIndex::deliver(gpointer data) {
+    std::shared_ptr<Build>* job = static_cast<std::shared_ptr<Build>*>(data);
+    Build& build = **job;
+
+    if (!build.cancelled && build.owner) {
+        KeyframeIndex* owner = build.owner;
+        owner->build.reset();
+        owner->map_sidecar();
+    }
+
+    delete job;
+    return G_SOURCE_REMOVE;
+}
+
+bool KeyframeIndex::scan(Build& build) {
+    GstElement* pipeline = gst_pipeline_new("keyframe-indexer");
+    GstElement* src = gst_element_factory_make("filesrc", nullptr);
+    GstElement* parse = gst_element_factory_make("parsebin", nullptr);
+    if (!pipeline || !src || !parse) {
+        std::cerr << "Warning: Keyframe indexer needs filesrc and parsebin" << std::endl;
+        if (src) gst_object_unref(src);
+        if (parse) gst_object_unref(parse);
+        if (pipeline) gst_object_unref(pipeline);
+        return false;
+    }
+
+    g_object_set(src, "location", build.filename.c_str(), "blocksize", READ_BLOCK_SIZE, nullptr);
+    gst_bin_add_many(GST_BIN(pipeline), src, parse, nullptr);
+    gst_element_link(src, parse);
+
+    // Parsed output only: no decoding, the file is read as fast as the disk allows
+    gst_segment_init(&build.segment, GST_FORMAT_TIME);
+    GstPad* src_pad = gst_element_get_static_pad(src, "src");
+    gst_pad_add_probe(src_pad, GST_PAD_PROBE_TYPE_BUFFER, on_read, &build, nullptr);
+    gst_object_unref(src_pad);
+    g_signal_connect(parse, "pad-added", G_CALLBACK(on_pad_added), &build);
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    GstBus* bus = gst_element_get_bus(pipeline);
+    bool reached_eos = false;
+    while (!build.cancelled) {
+        GstMessage* msg = gst_bus_timed_pop_filtered(bus, BUS_POLL,
+                                                     GstMessageType(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        if (!msg) {
+            continue;
+        }
+        reached_eos = GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+        if (!reached_eos) {
+            GError* err = nullptr;
+            gst_message_parse_error(msg, &err, nullptr);
+            std::cerr << "Warning: Keyframe indexing failed: " << err->message << std::endl;
+            g_error_free(err);
+        }
+        gst_message_unref(msg);
+        break;
+    }
+    gst_object_unref(bus);
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+    return reached_eos;
+}
+
+bool KeyframeIndex::write_sidecar(const Build& build) {
+    SidecarHeader header;
+    memcpy(header.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+    header.version = SIDECAR_VERSION;
+    header.file_size = build.file_size;
+    header.mtime = build.mtime;
+    header.count = build.entries.size();
+
+    bool written = write_file_atomically(build.sidecar, [&](std::ostream& out) {
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(build.entries.data()),
+                  build.entries.size() * sizeof(Entry));
+    });
+    if (!written) {
+        std::cerr << "Warning: Could not write keyframe index " << build.sidecar << std::endl;
+    }
+    return written;
+}
+
+void KeyframeIndex::on_pad_added(GstElement* parsebin, GstPad* pad, gpointer data) {
+    Build* build = static_cast<Build*>(data);
+    GstElement* pipeline = GST_ELEMENT(gst_element_get_parent(parsebin));
+
+    // Every stream has to be consumed, or the demuxer stalls
+    GstElement* sink = gst_element_factory_make("fakesink", nullptr);
+    g_object_set(sink, "sync", FALSE, "async", FALSE, nullptr);
+    gst_bin_add(GST_BIN(pipeline), sink);
+    gst_element_sync_state_with_parent(sink);
+    GstPad* sink_pad = gst_element_get_static_pad(sink, "sink");
+    gst_pad_link(pad, sink_pad);
+    gst_object_unref(sink_pad);
+    gst_object_unref(pipeline);
+
+    // Index the first video stream only
+    GstCaps* caps = gst_pad_get_current_caps(pad);
+    if (!caps) {
+        caps = gst_pad_query_caps(pad, nullptr);
+    }
+    const gchar* media = gst_structure_get_name(gst_caps_get_structure(caps, 0));
+    bool is_video = g_str_has_prefix(media, "video/");
+    gst_caps_unref(caps);
+
+    if (is_video && !build->has_video.exchange(true)) {
+        gst_pad_add_probe(pad,
+            GstPadProbeType(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+            on_video, build, nullptr);
+    }
+}
+
+GstPadProbeReturn KeyframeIndex::on_read(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    Build* build = static_cast<Build*>(data);
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (GST_BUFFER_OFFSET_IS_VALID(buffer)) {
+        build->read_offset = GST_BUFFER_OFFSET(buffer);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn KeyframeIndex::on_video(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    Build* build = static_cast<Build*>(data);
+
+    if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+            const GstSegment* segment;
+            gst_event_parse_segment(event, &segment);
+            gst_segment_copy_into(segment, &build->segment);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT) && GST_BUFFER_PTS_IS_VALID(buffer) &&
+        build->segment.format == GST_FORMAT_TIME) {
+        GstClockTime timestamp = gst_segment_to_stream_time(&build->segment, GST_FORMAT_TIME,
+                                                            GST_BUFFER_PTS(buffer));
+        // Demuxers emit a frame once the next one has started arriving, so the
+        // block being read when the previous frame came out holds the start of
+        // this one (or an earlier position, which is still safe to seek to)
+        if (GST_CLOCK_TIME_IS_VALID(timestamp) &&
+            (build->entries.empty() || (gint64)timestamp > build->entries.back().timestamp)) {
+            build->entries.push_back({(gint64)timestamp, build->previous_offset});
+        }
+    }
+
+    build->previous_offset = build->read_offset;
+    return GST_PAD_PROBE_OK;
+}
@@ -0,0 +1,65 @@
+#ifndef KEYFRAME_INDEX_HPP
+#define KEYFRAME_INDEX_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+// Keyframe table (stream time -> byte offset) for files whose container
+// has no seek index: AVI without idx1, MKV without Cues, MPEG-TS/PS
+// recordings. The first open of such a file scans it once on a
+// low-priority worker (filesrc ! parsebin) and writes a sidecar under
+// the user cache dir; later opens just mmap() the sidecar.
+class KeyframeIndex {
+public:
+    // Also the on-disk record, sorted by timestamp
+    struct Entry {
+        gint64 timestamp;  // Stream time of the keyframe
+        guint64 offset;    // Byte offset at or before the keyframe's data
+    };
+
+    KeyframeIndex();
+    ~KeyframeIndex();
+
+    // Map filename's sidecar, or build it in the background if missing or
+    // stale. The worker first probes the container and gives up quietly
+    // when it has an index of its own.
+    void open(const std::string& filename);
+    void close();
+
+    // Main thread only; false until the sidecar is mapped
+    bool ready() const { return entries != nullptr; }
+    size_t size() const { return count; }
+
+    // Last keyframe at or before position
+    bool lookup(gint64 position, Entry& entry) const;
+
+    // Reads the head of the file: false if the container carries its own
+    // seek index (or is unreadable), true if seeking it would mean a scan
+    static bool needs_index(const std::string& filename);
+    static std::string sidecar_path(const std::string& filename);
+
+private:
+    struct Build;
+    std::shared_ptr<Build> build;
+
+    std::string filename;
+    void* map;
+    size_t map_size;
+    const Entry* entries;
+    size_t count;
+
+    bool map_sidecar();
+    void unmap();
+
+    static void worker(std::shared_ptr<Build> build);
+    static bool scan(Build& build);
+    static bool write_sidecar(const Build& build);
+    static gboolean deliver(gpointer data);
+    static void on_pad_added(GstElement* parsebin, GstPad* pad, gpointer data);
+    static GstPadProbeReturn on_read(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+    static GstPadProbeReturn on_video(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+};
+
+#endif // KEYFRAME_INDEX_HPP
@@ -0,0 +1,311 @@
+#include "Logger.hpp"
+#include <cstdarg>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+
+// The writer wakes at least this often; errors and warnings wake it at once
+static const auto WRITER_PERIOD = std::chrono::milliseconds(20);
+
+static const char* const LEVEL_NAMES[] = {"off", "error", "warning", "info", "debug"};
+static const char* const CATEGORY_NAMES[] = {"general", "playback", "seek", "audio", "video", "net"};
+static const char LEVEL_TAGS[] = {'-', 'E', 'W', 'I', 'D'};
+
+std::atomic<int> Logger::thresholds[(int)LogCategory::Count] = {
+    (int)LogLevel::Info, (int)LogLevel::Info, (int)LogLevel::Info,
+    (int)LogLevel::Info, (int)LogLevel::Info, (int)LogLevel::Info,
+};
+
+namespace {
+
+// Bounded MPSC ring (Vyukov): a slot is free for the producer holding
+// position p when its sequence is p, readable once it is p + 1
+struct Slot {
+    std::atomic<size_t> sequence;
+    int64_t time_us;
+    LogLevel level;
+    LogCategory category;
+    char text[Logger::MESSAGE_SIZE];
+};
+
+struct State {
+    Slot ring[Logger::RING_SIZE];
+    std::atomic<size_t> enqueue_pos{0};
+    size_t dequeue_pos = 0;             // Writer thread only
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<FILE*> output{nullptr};
+    std::atomic<bool> running{false};
+
+    std::mutex mutex;                   // Writer start/stop and the waits below
+    std::condition_variable wake;
+    std::condition_variable written;    // written_pos moved
+    size_t written_pos = 0;
+    uint64_t reported_dropped = 0;      // Writer thread only
+    bool stopping = false;
+    bool initialised = false;
+    std::thread writer;
+    std::chrono::steady_clock::time_point start_time;
+};
+
+// Never destroyed: records may still be written while static
+// destructors run at exit
+State& state() {
+    static State* instance = new State();
+    return *instance;
+}
+
+int64_t now_us(const State& s) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - s.start_time).count();
+}
+
+void write_batch(State& s) {
+    std::string out, err;
+    size_t pos = s.dequeue_pos;
+
+    while (true) {
+        Slot& slot = s.ring[pos & (Logger::RING_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            break;
+        }
+        char prefix[48];
+        snprintf(prefix, sizeof(prefix), "[%9.3f] %c %s: ", slot.time_us / 1e6,
+                 LEVEL_TAGS[(int)slot.level], CATEGORY_NAMES[(int)slot.category]);
+        std::string& target = slot.level <= LogLevel::Warning ? err : out;
+        target += prefix;
+        target += slot.text;
+        target += '\n';
+        slot.sequence.store(pos + Logger::RING_SIZE, std::memory_order_release);
+        pos++;
+    }
+    s.dequeue_pos = pos;
+
+    uint64_t dropped = s.dropped.load(std::memory_order_relaxed);
+    if (dropped != s.reported_dropped) {
+        err += "Warning: " + std::to_string(dropped - s.reported_dropped) + " log records dropped (ring full)\n";
+        s.reported_dropped = dropped;
+    }
+
+    FILE* file = s.output.load();
+    for (auto* batch : {&err, &out}) {
+        if (batch->empty()) {
+            continue;
+        }
+        FILE* target = file ? file : (batch == &err ? stderr : stdout);
+        fwrite(batch->data(), 1, batch->size(), target);
+        fflush(target);
+    }
+}
+
+void run_writer() {
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    while (true) {
+        lock.unlock();
+        write_batch(s);
+        lock.lock();
+        s.written_pos = s.dequeue_pos;
+        s.written.notify_all();
+        if (s.stopping && s.dequeue_pos == s.enqueue_pos.load()) {
+            break;
+        }
+        s.wake.wait_for(lock, WRITER_PERIOD);
+    }
+}
+
+void start_writer(State& s) {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.running.load()) {
+        return;
+    }
+    if (!s.initialised) {
+        for (size_t i = 0; i < Logger::RING_SIZE; i++) {
+            s.ring[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        s.start_time = std::chrono::steady_clock::now();
+        s.initialised = true;
+    }
+    s.stopping = false;
+    s.writer = std::thread(run_writer);
+    s.running.store(true, std::memory_order_release);
+}
+
+State& started_state() {
+    State& s = state();
+    if (!s.running.load(std::memory_order_acquire)) {
+        start_writer(s);
+    }
+    return s;
+}
+
+// Claims the next slot, or nullptr when the ring is full
+Slot* claim(State& s, size_t& pos) {
+    pos = s.enqueue_pos.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = s.ring[pos & (Logger::RING_SIZE - 1)];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (s.enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                return &slot;
+            }
+        } else if (diff < 0) {
+            return nullptr;
+        } else {
+            pos = s.enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void push(LogLevel level, LogCategory category, const char* suffix, const char* format, va_list args) {
+    State& s = started_state();
+    size_t pos;
+    Slot* slot = claim(s, pos);
+    if (!slot) {
+        s.dropped.fetch_add(1, std::memory_order_relaxed);
+        s.wake.notify_one();
+        return;
+    }
+    slot->time_us = now_us(s);
+    slot->level = level;
+    slot->category = category;
+    int length = vsnprintf(slot->text, sizeof(slot->text), format, args);
+    if (suffix && length >= 0 && (size_t)length < sizeof(slot->text) - 1) {
+        strncat(slot->text, suffix, sizeof(slot->text) - length - 1);
+    }
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    // Without the mutex a wakeup can be missed; the writer's period bounds
+    // that. Bursts wake it every half ring so they are not dropped.
+    if (level <= LogLevel::Warning || (pos & (Logger::RING_SIZE / 2 - 1)) == 0) {
+        s.wake.notify_one();
+    }
+}
+
+}  // namespace
+
+void Logger::write(LogLevel level, LogCategory category, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    push(level, category, nullptr, format, args);
+    va_end(args);
+}
+
+void Logger::write_throttled(LogThrottle& throttle, int64_t interval_us, LogLevel level,
+                             LogCategory category, const char* format, ...) {
+    int64_t now = now_us(started_state());
+    int64_t next = throttle.next_us.load(std::memory_order_relaxed);
+    if (now < next || !throttle.next_us.compare_exchange_strong(next, now + interval_us,
+                                                                std::memory_order_relaxed)) {
+        throttle.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    char suffix[40] = "";
+    uint32_t suppressed = throttle.suppressed.exchange(0, std::memory_order_relaxed);
+    if (suppressed > 0) {
+        snprintf(suffix, sizeof(suffix), " (+%u suppressed)", suppressed);
+    }
+    va_list args;
+    va_start(args, format);
+    push(level, category, suffix, format, args);
+    va_end(args);
+}
+
+static bool parse_level(const std::string& name, LogLevel& level) {
+    for (int i = 0; i <= (int)LogLevel::Debug; i++) {
+        if (name == LEVEL_NAMES[i]) {
+            level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Logger::configure(const std::string& spec) {
+    int levels[(int)LogCategory::Count];
+    for (int i = 0; i < (int)LogCategory::Count; i++) {
+        levels[i] = thresholds[i].load();
+    }
+
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t comma = spec.find(',', start);
+        std::string item = spec.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        start = comma == std::string::npos ? spec.size() + 1 : comma + 1;
+        if (item.empty()) {
+            continue;
+        }
+
+        LogLevel level;
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) {
+            if (!parse_level(item, level)) {
+                return false;
+            }
+            for (int& value : levels) {
+                value = (int)level;
+            }
+            continue;
+        }
+
+        std::string name = item.substr(0, equals);
+        int category = -1;
+        for (int i = 0; i < (int)LogCategory::Count; i++) {
+            if (name == CATEGORY_NAMES[i]) {
+                category = i;
+            }
+        }
+        if (category < 0 || !parse_level(item.substr(equals + 1), level)) {
+            return false;
+        }
+        levels[category] = (int)level;
+    }
+
+    for (int i = 0; i < (int)LogCategory::Count; i++) {
+        thresholds[i].store(levels[i]);
+    }
+    return true;
+}
+
+void Logger::set_level(LogCategory category, LogLevel level) {
+    thresholds[(int)category].store((int)level);
+}
+
+void Logger::set_output(FILE* file) {
+    flush();
+    state().output.store(file);
+}
+
+void Logger::flush() {
+    State& s = state();
+    if (!s.running.load(std::memory_order_acquire)) {
+        return;
+    }
+    size_t target = s.enqueue_pos.load();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    s.wake.notify_one();
+    // A slot still being formatted holds the writer back; it is done within microseconds
+    s.written.wait(lock, [&s, target] { return s.written_pos >= target || !s.running.load(); });
+}
+
+void Logger::shutdown() {
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    if (!s.running.load()) {
+        return;
+    }
+    s.stopping = true;
+    s.wake.notify_one();
+    lock.unlock();
+    s.writer.join();
+    lock.lock();
+    s.running.store(false);
+}
+
+uint64_t Logger::dropped() {
+    return state().dropped.load();
+}
@@ -0,0 +1,87 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+enum class LogLevel : int { Off = 0, Error, Warning, Info, Debug };
+enum class LogCategory : int { General = 0, Playback, Seek, Audio, Video, Net, Count };
+
+// Rate limit of one LOG_THROTTLED call site
+struct LogThrottle {
+    std::atomic<int64_t> next_us{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+// Levelled, categorised logging for the GTK thread and streaming threads.
+// A call formats its message straight into a slot of a lock-free ring (no
+// lock, no allocation, no I/O); a background thread adds time, level and
+// category and writes whole batches with one flush. A full ring drops
+// records and counts them rather than block the caller. A disabled level
+// costs one relaxed atomic load when called through the LOG_* macros,
+// which skip evaluating the arguments.
+class Logger {
+public:
+    static const size_t RING_SIZE = 2048;    // Records in flight, power of two
+    static const size_t MESSAGE_SIZE = 200;  // Longer messages are cut
+
+    static bool enabled(LogLevel level, LogCategory category) {
+        return (int)level <= thresholds[(int)category].load(std::memory_order_relaxed);
+    }
+
+    static void write(LogLevel level, LogCategory category, const char* format, ...)
+        __attribute__((format(printf, 3, 4)));
+    // At most one record per interval from this throttle; the next record
+    // written says how many were suppressed in between
+    static void write_throttled(LogThrottle& throttle, int64_t interval_us, LogLevel level,
+                                LogCategory category, const char* format, ...)
+        __attribute__((format(printf, 5, 6)));
+
+    // "info", "debug,net=warning", "warning,seek=debug,audio=off": an
+    // optional default level for every category, then per-category
+    // overrides. False (nothing changed) on an unknown name.
+    static bool configure(const std::string& spec);
+    static void set_level(LogCategory category, LogLevel level);
+
+    // Errors and warnings go to stderr, the rest to stdout; a file set
+    // here takes everything (nullptr restores the default)
+    static void set_output(FILE* file);
+
+    // Block until everything written so far is out
+    static void flush();
+    // Flush and stop the writer thread; a later write starts it again
+    static void shutdown();
+
+    // Records lost to a full ring
+    static uint64_t dropped();
+
+private:
+    static std::atomic<int> thresholds[(int)LogCategory::Count];
+};
+
+#define LOG_AT(level, category, ...) \
+    do { \
+        if (Logger::enabled(level, category)) { \
+            Logger::write(level, category, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_ERROR(category, ...) LOG_AT(LogLevel::Error, LogCategory::category, __VA_ARGS__)
+#define LOG_WARNING(category, ...) LOG_AT(LogLevel::Warning, LogCategory::category, __VA_ARGS__)
+#define LOG_INFO(category, ...) LOG_AT(LogLevel::Info, LogCategory::category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) LOG_AT(LogLevel::Debug, LogCategory::category, __VA_ARGS__)
+
+// For events that can fire per input event or per buffer (slider drags,
+// volume changes): at most one record per interval_ms from this call site
+#define LOG_THROTTLED(level, category, interval_ms, ...) \
+    do { \
+        if (Logger::enabled(LogLevel::level, LogCategory::category)) { \
+            static LogThrottle log_throttle; \
+            Logger::write_throttled(log_throttle, (interval_ms) * 1000, LogLevel::level, \
+                                    LogCategory::category, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif // LOGGER_HPP
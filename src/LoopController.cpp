@@ -0,0 +1,67 @@
+#include "LoopController.hpp"
+#include <algorithm>
+
+LoopController::LoopController()
+    : loop_mode(Mode::Off), looping(false), point_a(0), point_b(-1), loops(0) {
+}
+
+void LoopController::set_file() {
+    loop_mode = Mode::File;
+    looping = true;
+    loops = 0;
+}
+
+bool LoopController::set_range(gint64 a, gint64 b) {
+    if (a < 0 || b <= a) {
+        return false;
+    }
+    point_a = a;
+    point_b = b;
+    loop_mode = Mode::Range;
+    looping = true;
+    loops = 0;
+    return true;
+}
+
+void LoopController::clear() {
+    loop_mode = Mode::Off;
+    looping = false;
+}
+
+bool LoopController::seek(GstElement* pipeline, double rate, GstSeekFlags flags, gint64 position,
+                          guint32* seqnum) const {
+    gint64 begin = start();
+    gint64 end = stop();
+    GstSeekType end_type = end >= 0 ? GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE;
+    if (loop_mode != Mode::Off) {
+        flags = GstSeekFlags(flags | GST_SEEK_FLAG_SEGMENT);
+        // Outside the loop means its start (or its end, in reverse)
+        if (position < begin || (end >= 0 && position >= end)) {
+            position = rate < 0 && end >= 0 ? end : begin;
+        }
+    }
+
+    GstEvent* event = rate < 0
+        ? gst_event_new_seek(rate, GST_FORMAT_TIME, flags, GST_SEEK_TYPE_SET, begin, GST_SEEK_TYPE_SET, position)
+        : gst_event_new_seek(rate, GST_FORMAT_TIME, flags, GST_SEEK_TYPE_SET, position, end_type, end);
+    if (seqnum) {
+        *seqnum = gst_event_get_seqnum(event);
+    }
+    return gst_element_send_event(pipeline, event);
+}
+
+// No FLUSH: the seek is queued behind the data still on its way to the
+// sinks, and ACCURATE clips the first buffers to A exactly
+bool LoopController::restart(GstElement* pipeline, double rate, GstSeekFlags flags) {
+    if (loop_mode == Mode::Off) {
+        return false;
+    }
+    gint64 end = stop();
+    flags = GstSeekFlags((flags & ~GST_SEEK_FLAG_FLUSH) | GST_SEEK_FLAG_SEGMENT | GST_SEEK_FLAG_ACCURATE);
+    if (!gst_element_seek(pipeline, rate, GST_FORMAT_TIME, flags, GST_SEEK_TYPE_SET, start(),
+                          end >= 0 ? GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE, end >= 0 ? end : GST_CLOCK_TIME_NONE)) {
+        return false;
+    }
+    loops++;
+    return true;
+}
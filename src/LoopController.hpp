@@ -0,0 +1,50 @@
+#ifndef LOOP_CONTROLLER_HPP
+#define LOOP_CONTROLLER_HPP
+
+#include <gst/gst.h>
+#include <atomic>
+
+// Whole-file and A-B looping without a state change. While a loop is
+// set, every seek the player makes is a SEGMENT seek ending at B (or at
+// the end of the file), so the pipeline posts SEGMENT_DONE there instead
+// of going EOS. restart() answers it with a non-flushing segment seek
+// back to A: the queued data before B still plays out, and the first
+// buffer after the seek continues the running time where it ended.
+class LoopController {
+public:
+    enum class Mode { Off, File, Range };
+
+    LoopController();
+
+    // Points are stream times; set_range() needs a < b
+    void set_file();
+    bool set_range(gint64 a, gint64 b);
+    void clear();
+
+    Mode mode() const { return loop_mode; }
+    bool active() const { return looping; }  // Safe from streaming threads
+    gint64 start() const { return loop_mode == Mode::Range ? point_a : 0; }
+    gint64 stop() const { return loop_mode == Mode::Range ? point_b : -1; }  // -1 = end of file
+
+    // Seek to position the way every seek is made while a loop may be set:
+    // with SEGMENT and the loop's end added, position kept inside the
+    // loop. Reverse rates play from position back to A (or 0). With no
+    // loop this is a plain seek. seqnum, if given, receives the seek's.
+    bool seek(GstElement* pipeline, double rate, GstSeekFlags flags, gint64 position,
+              guint32* seqnum = nullptr) const;
+
+    // Forward SEGMENT_DONE: the non-flushing seek back to the loop's
+    // start. False (nothing sent) if no loop is set.
+    bool restart(GstElement* pipeline, double rate, GstSeekFlags flags);
+
+    guint64 loop_count() const { return loops; }
+
+private:
+    Mode loop_mode;
+    std::atomic<bool> looping;
+    gint64 point_a;
+    gint64 point_b;
+    guint64 loops;
+};
+
+#endif // LOOP_CONTROLLER_HPP
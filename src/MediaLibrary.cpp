@@ -0,0 +1,294 @@
+#include "MediaLibrary.hpp"
+#include "AtomicFile.hpp"
+#include "DecoderPolicy.hpp"
+#include <gst/pbutils/pbutils.h>
+#include <glib/gstdio.h>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+static const char* const INDEX_HEADER = "# vidc library 1";
+static const GstClockTime DISCOVER_TIMEOUT = 5 * GST_SECOND;
+// Discovery is mostly small reads and demuxing; past this many workers a
+// single disk just seeks more
+static const int MAX_WORKERS = 8;
+static const size_t SAVE_EVERY = 1000;  // Discovered files between index saves
+
+MediaLibrary::MediaLibrary(const std::string& index_path) : index_path(index_path) {
+}
+
+std::string MediaLibrary::default_path() {
+    return (fs::path(g_get_user_cache_dir()) / "vidc" / "library.tsv").string();
+}
+
+bool MediaLibrary::is_media_file(const std::string& path) {
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    static const char* const extensions[] = {
+        ".mp4", ".m4v", ".mkv", ".webm", ".avi", ".mov", ".flv", ".ts", ".m2ts", ".mpg",
+        ".mpeg", ".ogv", ".mp3", ".m4a", ".aac", ".flac", ".ogg", ".opus", ".wav",
+    };
+    return std::find(std::begin(extensions), std::end(extensions), ext) != std::end(extensions);
+}
+
+const MediaInfo* MediaLibrary::find(const std::string& path) const {
+    auto it = index.find(path);
+    return it != index.end() ? &it->second : nullptr;
+}
+
+// path, mtime, size, duration (ns, -1 = unknown), width, height, video, audio, playable
+bool MediaLibrary::load() {
+    index.clear();
+    std::ifstream in(index_path);
+    if (!in) {
+        std::error_code ec;
+        return !fs::exists(index_path, ec);
+    }
+
+    std::string line;
+    if (!std::getline(in, line) || line != INDEX_HEADER) {
+        return true;  // Other version: rebuilt by the next scan
+    }
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for (size_t tab; (tab = line.find('\t', start)) != std::string::npos; start = tab + 1) {
+            fields.push_back(line.substr(start, tab - start));
+        }
+        fields.push_back(line.substr(start));
+        if (fields.size() != 9 || fields[0].empty()) {
+            continue;
+        }
+
+        MediaInfo info;
+        info.mtime = g_ascii_strtoll(fields[1].c_str(), nullptr, 10);
+        info.size = g_ascii_strtoull(fields[2].c_str(), nullptr, 10);
+        gint64 duration = g_ascii_strtoll(fields[3].c_str(), nullptr, 10);
+        info.duration = duration >= 0 ? (GstClockTime)duration : GST_CLOCK_TIME_NONE;
+        info.width = atoi(fields[4].c_str());
+        info.height = atoi(fields[5].c_str());
+        info.video_codec = fields[6];
+        info.audio_codec = fields[7];
+        info.playable = fields[8] == "1";
+        index[fields[0]] = info;
+    }
+    return true;
+}
+
+bool MediaLibrary::save() const {
+    bool written = write_file_atomically(index_path, [this](std::ostream& out) {
+        out << INDEX_HEADER << '\n';
+        for (const auto& entry : index) {
+            const MediaInfo& info = entry.second;
+            out << entry.first << '\t' << info.mtime << '\t' << info.size << '\t'
+                << (GST_CLOCK_TIME_IS_VALID(info.duration) ? (gint64)info.duration : -1) << '\t'
+                << info.width << '\t' << info.height << '\t'
+                << info.video_codec << '\t' << info.audio_codec << '\t'
+                << (info.playable ? 1 : 0) << '\n';
+        }
+    });
+    if (!written) {
+        std::cerr << "Warning: Could not write library index " << index_path << std::endl;
+    }
+    return written;
+}
+
+// "h264", "aac", ... from a stream's caps
+static std::string stream_codec(GstDiscovererStreamInfo* stream) {
+    GstCaps* caps = gst_discoverer_stream_info_get_caps(stream);
+    if (!caps) {
+        return "";
+    }
+    std::string codec;
+    if (!gst_caps_is_empty(caps)) {
+        const GstStructure* s = gst_caps_get_structure(caps, 0);
+        std::string name = gst_structure_get_name(s);
+        if (name.rfind("video/", 0) == 0) {
+            codec = DecoderPolicy::codec_name(s);
+        } else if (name == "audio/mpeg") {
+            gint version = 1;
+            gst_structure_get_int(s, "mpegversion", &version);
+            codec = version == 1 ? "mp3" : "aac";
+        } else if (name.rfind("audio/x-", 0) == 0) {
+            codec = name.substr(strlen("audio/x-"));
+        } else {
+            codec = name;
+        }
+    }
+    gst_caps_unref(caps);
+    return codec;
+}
+
+static MediaInfo discover_file(GstDiscoverer* discoverer, const std::string& path) {
+    MediaInfo info;
+    gchar* uri = gst_filename_to_uri(path.c_str(), nullptr);
+    GError* error = nullptr;
+    GstDiscovererInfo* result = uri ? gst_discoverer_discover_uri(discoverer, uri, &error) : nullptr;
+    g_free(uri);
+    g_clear_error(&error);
+    if (!result) {
+        return info;
+    }
+
+    if (gst_discoverer_info_get_result(result) == GST_DISCOVERER_OK) {
+        info.playable = true;
+        info.duration = gst_discoverer_info_get_duration(result);
+
+        GList* videos = gst_discoverer_info_get_video_streams(result);
+        for (GList* l = videos; l; l = l->next) {
+            GstDiscovererVideoInfo* video = GST_DISCOVERER_VIDEO_INFO(l->data);
+            if (gst_discoverer_video_info_is_image(video)) {
+                continue;  // Cover art
+            }
+            info.width = gst_discoverer_video_info_get_width(video);
+            info.height = gst_discoverer_video_info_get_height(video);
+            info.video_codec = stream_codec(GST_DISCOVERER_STREAM_INFO(video));
+            break;
+        }
+        gst_discoverer_stream_info_list_free(videos);
+
+        GList* audios = gst_discoverer_info_get_audio_streams(result);
+        if (audios) {
+            info.audio_codec = stream_codec(GST_DISCOVERER_STREAM_INFO(audios->data));
+        }
+        gst_discoverer_stream_info_list_free(audios);
+    }
+    g_object_unref(result);
+    return info;
+}
+
+ScanStats MediaLibrary::scan(const std::string& root, int workers, Progress progress) {
+    ScanStats stats;
+    gint64 start_time = g_get_monotonic_time();
+
+    std::error_code ec;
+    fs::path root_path = fs::weakly_canonical(fs::absolute(root, ec), ec);
+    std::string root_prefix = root_path.string();
+    if (root_prefix.empty() || root_prefix.back() != '/') {
+        root_prefix += '/';
+    }
+
+    // Walk: stat every media file, queue the new and changed ones
+    struct Pending {
+        std::string path;
+        gint64 mtime;
+        guint64 size;
+    };
+    std::vector<Pending> pending;
+    std::unordered_set<std::string> seen;
+
+    fs::recursive_directory_iterator it(root_path, fs::directory_options::skip_permission_denied, ec), end;
+    for (; !ec && it != end; it.increment(ec)) {
+        std::string path = it->path().string();
+        std::error_code entry_ec;
+        // Tabs and newlines cannot be stored in the index
+        if (!it->is_regular_file(entry_ec) || !is_media_file(path) ||
+            path.find_first_of("\t\n") != std::string::npos) {
+            continue;
+        }
+        GStatBuf st;
+        if (g_stat(path.c_str(), &st) != 0) {
+            continue;
+        }
+
+        stats.files++;
+        seen.insert(path);
+        const MediaInfo* known = find(path);
+        if (known && known->mtime == (gint64)st.st_mtime && known->size == (guint64)st.st_size) {
+            stats.unchanged++;
+        } else {
+            pending.push_back({path, (gint64)st.st_mtime, (guint64)st.st_size});
+        }
+    }
+    if (ec) {
+        std::cerr << "Warning: Stopped walking " << root_path.string() << ": " << ec.message() << std::endl;
+    }
+
+    for (auto entry = index.begin(); entry != index.end();) {
+        if (entry->first.rfind(root_prefix, 0) == 0 && !seen.count(entry->first)) {
+            entry = index.erase(entry);
+            stats.removed++;
+        } else {
+            ++entry;
+        }
+    }
+
+    // Discover: each worker owns a synchronous discoverer and takes the
+    // next pending file until none are left
+    int count = workers > 0 ? workers : std::min((int)g_get_num_processors(), MAX_WORKERS);
+    count = std::max(1, std::min(count, (int)pending.size()));
+
+    std::mutex index_mutex;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> failed{0};
+    std::atomic<int> running{pending.empty() ? 0 : count};
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < count && !pending.empty(); i++) {
+        threads.emplace_back([&]() {
+            GError* error = nullptr;
+            GstDiscoverer* discoverer = gst_discoverer_new(DISCOVER_TIMEOUT, &error);
+            if (!discoverer) {
+                std::cerr << "Warning: Could not create discoverer: "
+                          << (error ? error->message : "unknown error") << std::endl;
+                g_clear_error(&error);
+                running--;
+                return;
+            }
+
+            for (size_t n; (n = next++) < pending.size();) {
+                MediaInfo info = discover_file(discoverer, pending[n].path);
+                info.mtime = pending[n].mtime;
+                info.size = pending[n].size;
+                if (!info.playable) {
+                    failed++;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(index_mutex);
+                    index[pending[n].path] = info;
+                }
+                done++;
+            }
+            g_object_unref(discoverer);
+            running--;
+        });
+    }
+
+    size_t saved = 0;
+    while (running > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        size_t finished = done;
+        if (progress) {
+            progress(finished, pending.size());
+        }
+        if (finished - saved >= SAVE_EVERY) {
+            std::lock_guard<std::mutex> lock(index_mutex);
+            save();
+            saved = finished;
+        }
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if (progress && !pending.empty()) {
+        progress(done, pending.size());
+    }
+
+    stats.discovered = done;
+    stats.failed = failed;
+    stats.seconds = (g_get_monotonic_time() - start_time) / 1e6;
+    save();
+    return stats;
+}
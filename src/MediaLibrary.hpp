@@ -0,0 +1,67 @@
+#ifndef MEDIA_LIBRARY_HPP
+#define MEDIA_LIBRARY_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <map>
+#include <functional>
+
+// What the index knows about one file
+struct MediaInfo {
+    gint64 mtime = 0;                       // Seconds since the epoch
+    guint64 size = 0;
+    GstClockTime duration = GST_CLOCK_TIME_NONE;
+    int width = 0;                          // 0 for audio-only files
+    int height = 0;
+    std::string video_codec;                // "h264", "vp9", ... empty if none
+    std::string audio_codec;                // "aac", "opus", ... empty if none
+    bool playable = false;                  // Discovery succeeded
+};
+
+// Outcome of one scan
+struct ScanStats {
+    size_t files = 0;       // Media files found under the root
+    size_t discovered = 0;  // New or changed, run through the discoverer
+    size_t unchanged = 0;   // Same size and mtime as in the index
+    size_t failed = 0;      // Discovered but not playable (errors, timeouts, missing plugins)
+    size_t removed = 0;     // Indexed files under the root that are gone
+    double seconds = 0;
+
+    double files_per_second() const { return seconds > 0 ? files / seconds : 0; }
+};
+
+// Index of the media files in directory trees, so browsing them needs no
+// decoding. A scan walks the tree, keeps the entries whose size and mtime
+// did not change and sends the rest to a pool of GstDiscoverer workers
+// (one discoverer per thread, one file in flight per worker, threads
+// scaled to the core count). The index is a TSV file in the user cache
+// dir, also saved during long scans so an interrupted one resumes where
+// it stopped.
+class MediaLibrary {
+public:
+    // Called on the scanning thread about every 200 ms
+    using Progress = std::function<void(size_t done, size_t total)>;
+
+    explicit MediaLibrary(const std::string& index_path = default_path());
+
+    // A missing index is an empty library; false if it cannot be read
+    bool load();
+    bool save() const;
+
+    // Blocks until the tree is indexed; workers 0 = one per core, capped
+    ScanStats scan(const std::string& root, int workers = 0, Progress progress = nullptr);
+
+    // By absolute path
+    const std::map<std::string, MediaInfo>& entries() const { return index; }
+    const MediaInfo* find(const std::string& path) const;
+
+    // Extensions the scan (and the Open dialog) consider media
+    static bool is_media_file(const std::string& path);
+    static std::string default_path();
+
+private:
+    std::string index_path;
+    std::map<std::string, MediaInfo> index;
+};
+
+#endif // MEDIA_LIBRARY_HPP
@@ -0,0 +1,255 @@
+#include "MemoryBudget.hpp"
+#include "Logger.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+
+// Shares of the cap above the baseline, in percent. The queue share is
+// per queue; a playbin has up to four (playsink's audio and video queues,
+// the sink bins' own). The rest is headroom for decoder and sink buffer
+// pools.
+static const guint64 DEMUX_SHARE = 25;
+static const guint64 DEMUX_STREAMS = 2;
+static const guint64 NETWORK_SHARE = 10;
+static const guint64 QUEUE_SHARE = 3;
+static const guint64 FRAME_CACHE_SHARE = 20;
+
+// A demuxed stream always holds at least one large keyframe, and a
+// queue at least one decoded frame; below these limits playback stalls
+static const guint64 MIN_DEMUX_BYTES = 4 * 1024 * 1024;
+static const guint64 MIN_NETWORK_BYTES = 2 * 1024 * 1024;
+static const guint64 MIN_QUEUE_BYTES = 1024 * 1024;
+
+// Same for every demuxed stream: the bytes bind on the video, time keeps
+// audio and video within this much of each other; the buffer count only
+// guards against floods of tiny buffers
+static const GstClockTime DEMUX_TIME = 2 * GST_SECOND;
+static const guint DEMUX_BUFFERS = 200;
+
+MemoryBudget::MemoryBudget() : cap_bytes(0), settled(false), baseline(0) {
+}
+
+MemoryBudget::~MemoryBudget() {
+    for (GstElement* element : queues) {
+        gst_object_unref(element);
+    }
+}
+
+void MemoryBudget::set_cap(guint64 bytes) {
+    std::lock_guard<std::mutex> lock(split_mutex);
+    cap_bytes = bytes;
+    settled = false;
+}
+
+const MemoryBudget::Split& MemoryBudget::limits() {
+    settle();
+    return split;
+}
+
+void MemoryBudget::settle() {
+    std::lock_guard<std::mutex> lock(split_mutex);
+    if (settled || !enabled()) {
+        return;
+    }
+    baseline = rss_bytes();
+    split = compute(cap_bytes, baseline);
+    settled = true;
+    LOG_INFO(General, "Memory budget: %" G_GUINT64_FORMAT " MB above a %" G_GUINT64_FORMAT " MB baseline, %"
+             G_GUINT64_FORMAT " KB per demuxed stream, %" G_GUINT64_FORMAT " KB per queue, %"
+             G_GUINT64_FORMAT " MB frame cache",
+             (cap_bytes > baseline ? cap_bytes - baseline : 0) / (1024 * 1024), baseline / (1024 * 1024),
+             split.demux_bytes / 1024, split.queue_bytes / 1024, split.frame_cache_bytes / (1024 * 1024));
+}
+
+MemoryBudget::Split MemoryBudget::compute(guint64 cap, guint64 baseline) {
+    guint64 available = cap > baseline ? cap - baseline : 0;
+    Split result;
+    result.demux_bytes = std::max(MIN_DEMUX_BYTES, available * DEMUX_SHARE / 100 / DEMUX_STREAMS);
+    result.demux_buffers = DEMUX_BUFFERS;
+    result.demux_time = DEMUX_TIME;
+    result.network_bytes = std::max(MIN_NETWORK_BYTES, available * NETWORK_SHARE / 100);
+    result.queue_bytes = std::max(MIN_QUEUE_BYTES, available * QUEUE_SHARE / 100);
+    result.frame_cache_bytes = available * FRAME_CACHE_SHARE / 100;
+    return result;
+}
+
+// Byte properties of queues and decodebin are guint
+static guint clamp_uint(guint64 value) {
+    return (guint)std::min<guint64>(value, G_MAXUINT);
+}
+
+void MemoryBudget::configure(GstElement* pipeline) {
+    settle();
+    if (enabled() && g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "buffer-size")) {
+        g_object_set(pipeline, "buffer-size", (gint)std::min<guint64>(split.network_bytes, G_MAXINT), nullptr);
+    }
+    g_signal_connect(pipeline, "deep-element-added", G_CALLBACK(on_element_added), this);
+}
+
+void MemoryBudget::on_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data) {
+    MemoryBudget* budget = static_cast<MemoryBudget*>(data);
+    GstElementFactory* factory = gst_element_get_factory(element);
+    if (!factory) {
+        return;
+    }
+
+    std::string name = GST_OBJECT_NAME(factory);
+    if (budget->enabled()) {
+        budget->apply(element, name);
+    }
+    if (name == "queue" || name == "queue2" || name == "multiqueue") {
+        budget->track(element);
+    }
+}
+
+// Elements are configured before their owner links them, so the limits
+// hold from the first buffer
+void MemoryBudget::apply(GstElement* element, const std::string& factory) const {
+    if (factory == "decodebin") {
+        // decodebin sets these on its multiqueue, for preroll and playback
+        g_object_set(element,
+                     "max-size-bytes", clamp_uint(split.demux_bytes),
+                     "max-size-buffers", split.demux_buffers,
+                     "max-size-time", (guint64)split.demux_time, nullptr);
+    } else if (factory == "queue") {
+        // Tighten only; playsink's video queue is limited by buffer count
+        guint max_bytes = 0;
+        g_object_get(element, "max-size-bytes", &max_bytes, nullptr);
+        if (max_bytes == 0 || max_bytes > split.queue_bytes) {
+            g_object_set(element, "max-size-bytes", clamp_uint(split.queue_bytes), nullptr);
+        }
+    }
+}
+
+void MemoryBudget::track(GstElement* element) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Elements of disposed pipelines have lost their parent
+    auto orphaned = [](GstElement* queue) {
+        GstObject* parent = gst_object_get_parent(GST_OBJECT(queue));
+        if (!parent) {
+            gst_object_unref(queue);
+            return true;
+        }
+        gst_object_unref(parent);
+        return false;
+    };
+    queues.erase(std::remove_if(queues.begin(), queues.end(), orphaned), queues.end());
+    queues.push_back(GST_ELEMENT(gst_object_ref(element)));
+}
+
+// current-level-* of queue and queue2; multiqueue has them per pad
+static bool read_level(GObject* object, MemoryBudget::QueueLevel& level) {
+    GObjectClass* klass = G_OBJECT_GET_CLASS(object);
+    if (!g_object_class_find_property(klass, "current-level-bytes")) {
+        return false;
+    }
+    guint bytes = 0, buffers = 0;
+    guint64 time = 0;
+    g_object_get(object, "current-level-bytes", &bytes, "current-level-buffers", &buffers,
+                 "current-level-time", &time, nullptr);
+    level.bytes = bytes;
+    level.buffers = buffers;
+    level.time = time;
+    return true;
+}
+
+std::vector<MemoryBudget::QueueLevel> MemoryBudget::levels(GstElement* pipeline) {
+    std::vector<GstElement*> current;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (GstElement* element : queues) {
+            if (pipeline && gst_object_has_as_ancestor(GST_OBJECT(element), GST_OBJECT(pipeline))) {
+                current.push_back(GST_ELEMENT(gst_object_ref(element)));
+            }
+        }
+    }
+
+    std::vector<QueueLevel> result;
+    for (GstElement* element : current) {
+        guint max_bytes = 0;
+        g_object_get(element, "max-size-bytes", &max_bytes, nullptr);
+
+        GstElementFactory* factory = gst_element_get_factory(element);
+        if (factory && strcmp(GST_OBJECT_NAME(factory), "multiqueue") == 0) {
+            GstIterator* pads = gst_element_iterate_src_pads(element);
+            GValue item = G_VALUE_INIT;
+            while (gst_iterator_next(pads, &item) == GST_ITERATOR_OK) {
+                GstPad* pad = GST_PAD(g_value_get_object(&item));
+                QueueLevel level;
+                level.name = std::string(GST_ELEMENT_NAME(element)) + ":" + GST_PAD_NAME(pad);
+                level.max_bytes = max_bytes;
+                if (read_level(G_OBJECT(pad), level)) {
+                    result.push_back(level);
+                }
+                g_value_reset(&item);
+            }
+            g_value_unset(&item);
+            gst_iterator_free(pads);
+        } else {
+            QueueLevel level;
+            level.name = GST_ELEMENT_NAME(element);
+            level.max_bytes = max_bytes;
+            if (read_level(G_OBJECT(element), level)) {
+                result.push_back(level);
+            }
+        }
+        gst_object_unref(element);
+    }
+    return result;
+}
+
+static double to_mb(guint64 bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+std::string MemoryBudget::summary(GstElement* pipeline) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "Memory: " << to_mb(rss_bytes()) << " MB (peak " << to_mb(peak_rss_bytes()) << " MB";
+    if (enabled()) {
+        out << ", cap " << to_mb(cap_bytes) << " MB";
+    }
+    out << ")";
+
+    for (const QueueLevel& level : levels(pipeline)) {
+        out << "\n" << level.name << ": " << to_mb(level.bytes) << " MB";
+        if (level.max_bytes > 0) {
+            out << " / " << to_mb(level.max_bytes) << " MB";
+        }
+        out << ", " << level.buffers << " buffers, " << level.time / GST_MSECOND << " ms";
+    }
+    return out.str();
+}
+
+guint64 MemoryBudget::rss_bytes() {
+    // Second field: resident pages
+    std::ifstream statm("/proc/self/statm");
+    guint64 size = 0, resident = 0;
+    if (!(statm >> size >> resident)) {
+        return 0;
+    }
+    return resident * (guint64)sysconf(_SC_PAGESIZE);
+}
+
+guint64 MemoryBudget::peak_rss_bytes() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;  // In kB
+        }
+    }
+    return 0;
+}
+
+bool MemoryBudget::reset_peak() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return (bool)clear_refs;
+}
@@ -0,0 +1,94 @@
+#ifndef MEMORY_BUDGET_HPP
+#define MEMORY_BUDGET_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <mutex>
+
+// Per-player memory cap for high-bitrate files. Whatever the process
+// already uses when the first pipeline is configured (libraries,
+// registry, UI) is the baseline; the rest is spread across the places
+// buffers pile up:
+// decodebin's multiqueue (compressed data per stream), playbin's network
+// buffer, every plain queue (playsink's, the sink bins') and the frame
+// cache. About a third stays unassigned for decoder and sink buffer
+// pools, which no queue limit reaches. Demuxed streams all get the same
+// time limit, so a stream capped by bytes never runs further ahead of
+// the others than an uncapped one would. The thumbnail and keyframe
+// index pipelines are outside the budget: the indexer has no queues, the
+// thumbnail pipeline keeps decodebin's default multiqueue limits, and
+// decoded thumbnails have their own cache cap.
+class MemoryBudget {
+public:
+    // Limits derived from the cap, in bytes
+    struct Split {
+        guint64 demux_bytes = 0;       // Each demuxed stream in the multiqueue
+        guint demux_buffers = 0;
+        GstClockTime demux_time = 0;
+        guint64 network_bytes = 0;     // playbin buffer-size (queue2 in memory)
+        guint64 queue_bytes = 0;       // Each plain queue
+        guint64 frame_cache_bytes = 0;
+    };
+
+    // One tracked queue, or one stream of a multiqueue
+    struct QueueLevel {
+        std::string name;
+        guint64 bytes = 0;
+        guint64 max_bytes = 0;         // 0: no byte limit
+        guint buffers = 0;
+        GstClockTime time = 0;
+    };
+
+    MemoryBudget();
+    ~MemoryBudget();
+
+    // Call before the first pipeline is built. The RSS at the first
+    // configure() or limits() after it becomes the baseline: on the
+    // loader's worker that is after gst_init, so the registry is counted.
+    // 0 turns the budget off (GStreamer's own limits).
+    void set_cap(guint64 bytes);
+    guint64 cap() const { return cap_bytes; }
+    bool enabled() const { return cap_bytes > 0; }
+    const Split& limits();
+
+    // Pure: the split of cap above baseline; floors win over a cap too small
+    static Split compute(guint64 cap, guint64 baseline);
+
+    // Loader setup hook (worker thread, before PAUSED): network buffer and
+    // the limits of queues added from now on; the budget must outlive the
+    // pipeline. Queues are tracked for levels() even when disabled.
+    void configure(GstElement* pipeline);
+
+    // Fill levels of the tracked queues still inside pipeline
+    std::vector<QueueLevel> levels(GstElement* pipeline);
+    std::string summary(GstElement* pipeline);  // A few lines for the on-screen overlay
+
+    // Resident set size of this process, now and at its peak (VmHWM)
+    static guint64 rss_bytes();
+    static guint64 peak_rss_bytes();
+    // Restart the VmHWM peak at the current RSS (Linux 4.0+); false if unsupported
+    static bool reset_peak();
+
+private:
+    guint64 cap_bytes;
+
+    // Settled once, by whichever of the main thread and the loader's
+    // worker asks first
+    std::mutex split_mutex;
+    bool settled;
+    guint64 baseline;
+    Split split;
+
+    // Shared with the streaming threads adding elements
+    std::mutex mutex;
+    std::vector<GstElement*> queues;  // Referenced; dropped once out of their pipeline
+
+    void settle();
+    void track(GstElement* element);
+    void apply(GstElement* element, const std::string& factory) const;
+
+    static void on_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data);
+};
+
+#endif // MEMORY_BUDGET_HPP
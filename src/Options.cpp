@@ -0,0 +1,114 @@
+#include "Options.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+void PlayerOptions::print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] [file|playlist.m3u ...]\n"
+              << "  --stats                 Print wakeups and player callbacks per second\n"
+              << "  --telemetry-json <file> Write playback telemetry as JSON (\"-\" for stdout)\n"
+              << "  --telemetry-interval <s> Seconds between telemetry snapshots (default: 10)\n"
+              << "  --decoder-config <file> Per-codec decoder threading policy\n"
+              << "                          (default: ~/.config/vidc/decoder.conf)\n"
+              << "  --decoder-threads <n>   Threads for every video decoder (0 = scale by resolution)\n"
+              << "  --decoder-thread-type <frame|slice|auto>\n"
+              << "  --frame-cache-mb <n>    Memory for decoded frames when stepping back (default: 256)\n"
+              << "  --net-cache-mb <n>      On-disk cache for http(s) media (default: 1024, 0 = off)\n"
+              << "  --buffer-size <kb>      Network buffer size\n"
+              << "  --buffer-low <percent>  Pause to buffer below this fill level (default: 1)\n"
+              << "  --buffer-high <percent> Resume above this fill level (default: 99)\n"
+              << "  --memory-budget-mb <n>  Cap on the player's memory: queue limits and frame cache\n"
+              << "                          are sized to stay under it (default: 0 = GStreamer's own)\n"
+              << "  --scan <dir>            Index a directory tree into the media library and exit\n"
+              << "  --scan-workers <n>      Discoverer threads for --scan (default: one per core)\n"
+              << "  --no-downscale          Convert video at source resolution, not at window size\n"
+              << "  --cold-switch           Rebuild the pipeline for every file instead of reusing it\n"
+              << "  --loop                  Loop each file without a gap instead of moving on (L toggles)\n"
+              << "  --single-instance       Open the files in the running player, or start one that\n"
+              << "                          listens for commands on a local socket\n"
+              << "  --control <command>     Send a command to the running player and print the reply\n"
+              << "                          (open, queue, play, pause, stop, seek, rate, volume, next,\n"
+              << "                          prev, status, memory, log, show, quit); repeatable\n"
+              << "  --control-socket <path> Control socket (default: $XDG_RUNTIME_DIR/vidc/control.sock)\n"
+              << "  --log <levels>          Log verbosity: a default level and/or category=level pairs,\n"
+              << "                          e.g. \"debug\" or \"warning,seek=debug\" (levels: off, error,\n"
+              << "                          warning, info, debug; categories: general, playback, seek,\n"
+              << "                          audio, video, net). Also read from $VIDC_LOG\n"
+              << "  -h, --help              Show this help\n";
+}
+
+bool PlayerOptions::parse(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--stats") {
+            stats = true;
+        } else if (arg == "--telemetry-json" && has_value) {
+            telemetry_json = argv[++i];
+        } else if (arg == "--telemetry-interval" && has_value) {
+            telemetry_interval = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--decoder-config" && has_value) {
+            decoder_config = argv[++i];
+        } else if (arg == "--decoder-threads" && has_value) {
+            decoder_threads = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--decoder-thread-type" && has_value) {
+            decoder_thread_type = argv[++i];
+            if (decoder_thread_type != "frame" && decoder_thread_type != "slice" &&
+                decoder_thread_type != "auto") {
+                std::cerr << "Unknown thread type: " << decoder_thread_type << std::endl;
+                print_usage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--frame-cache-mb" && has_value) {
+            frame_cache_mb = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--net-cache-mb" && has_value) {
+            net_cache_mb = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--buffer-size" && has_value) {
+            buffer_size_kb = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--buffer-low" && has_value) {
+            buffer_low = std::clamp(std::atoi(argv[++i]), 0, 100);
+        } else if (arg == "--buffer-high" && has_value) {
+            buffer_high = std::clamp(std::atoi(argv[++i]), 0, 100);
+        } else if (arg == "--memory-budget-mb" && has_value) {
+            memory_budget_mb = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--scan" && has_value) {
+            scan_dir = argv[++i];
+        } else if (arg == "--scan-workers" && has_value) {
+            scan_workers = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--no-downscale") {
+            downscale = false;
+        } else if (arg == "--cold-switch") {
+            warm_switch = false;
+        } else if (arg == "--loop") {
+            loop = true;
+        } else if (arg == "--single-instance") {
+            single_instance = true;
+        } else if (arg == "--control" && has_value) {
+            control_commands.push_back(argv[++i]);
+        } else if (arg == "--control-socket" && has_value) {
+            control_socket = argv[++i];
+        } else if (arg == "--log" && has_value) {
+            log_spec = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return false;
+        } else if (arg == "--") {
+            // Everything after "--" is a file, even if it starts with '-'
+            for (i++; i < argc; i++) {
+                files.push_back(argv[i]);
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            print_usage(argv[0]);
+            return false;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (buffer_low >= buffer_high) {
+        std::cerr << "--buffer-low must be below --buffer-high" << std::endl;
+        return false;
+    }
+    return true;
+}
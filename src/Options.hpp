@@ -0,0 +1,39 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <string>
+#include <vector>
+
+// Command-line options of gui-player
+struct PlayerOptions {
+    std::vector<std::string> files;  // Media files and .m3u playlists, in order
+    bool stats = false;              // Print wakeups and player callbacks per second
+    std::string telemetry_json;      // Periodic telemetry snapshots: file path, "-" for stdout
+    int telemetry_interval = 10;     // Seconds between snapshots
+    std::string decoder_config;      // Decoder threading policy, default path when empty
+    int decoder_threads = -1;        // Threads for every video decoder, -1 = policy
+    std::string decoder_thread_type; // "frame", "slice" or "auto", empty = policy
+    int frame_cache_mb = 256;        // Decoded frames kept for stepping back, 0 = off
+    int net_cache_mb = 1024;         // On-disk cache for network media, 0 = stream only
+    int buffer_size_kb = 0;          // Network buffer size, 0 = GStreamer default
+    int buffer_low = 1;              // Buffering starts below this fill level (%)
+    int buffer_high = 99;            // ... and ends above this one
+    int memory_budget_mb = 0;        // Per-player memory cap for queues and caches, 0 = off
+    std::string scan_dir;            // Index this tree into the media library and exit
+    int scan_workers = 0;            // Discoverer threads, 0 = one per core
+    bool downscale = true;           // Scale video to the window before converting it
+    bool warm_switch = true;         // Reuse the playbin when switching files
+    bool loop = false;               // Loop each file seamlessly (segment seeks) instead of ending
+    bool single_instance = false;    // Hand files to a running instance, or become it
+    std::string control_socket;      // Control socket path, default path when empty
+    std::vector<std::string> control_commands;  // Send these to the running instance and exit
+    std::string log_spec;            // Log levels, e.g. "info,seek=debug"; applied after $VIDC_LOG
+
+    // Parse argv (after gtk_init has removed GTK's own options).
+    // Returns false and prints usage on an unknown option.
+    bool parse(int argc, char* argv[]);
+
+    static void print_usage(const char* program);
+};
+
+#endif // OPTIONS_HPP
@@ -0,0 +1,459 @@
+#include "PipelineLoader.hpp"
+#include "VideoFrameSink.hpp"
+#include "PipelineReaper.hpp"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+// Bus waits are sliced so a cancelled load stops promptly
+static const gint64 BUS_POLL_US = 100 * 1000;
+
+// Shared by a loader and its detached workers, which may outlive it
+struct PipelineLoader::Workers {
+    std::mutex mutex;
+    std::condition_variable stopped;
+    size_t running = 0;
+};
+
+struct PipelineLoader::Job {
+    std::shared_ptr<Workers> workers;
+    std::vector<PipelineConfig> configs;
+    Callback on_done;
+    Setup setup;
+    Prepare prepare;
+    std::atomic<bool> cancelled{false};  // Set under workers->mutex
+    std::atomic<bool> finished{false};
+    bool handed_over = false;  // Worker done, result queued for the main loop (workers->mutex)
+    gint64 start_time = 0;  // g_get_monotonic_time() at load()
+    GstElement* reused = nullptr;  // reuse(): the pipeline to switch, owned until tried
+    std::string reuse_uri;
+    std::string reuse_config;
+    PipelineLoadResult result;
+};
+
+PipelineLoader::PipelineLoader() : workers(std::make_shared<Workers>()) {
+}
+
+PipelineLoader::~PipelineLoader() {
+    cancel();
+}
+
+std::string PipelineLoader::to_uri(const std::string& location) {
+    if (gst_uri_is_valid(location.c_str())) {
+        return location;
+    }
+
+    // Escaped URI, so paths with spaces survive gst_parse_launch
+    gchar* uri = gst_filename_to_uri(location.c_str(), nullptr);
+    std::string uri_str = uri ? uri : "file://" + location;
+    g_free(uri);
+    return uri_str;
+}
+
+bool PipelineLoader::can_reuse(GstElement* pipeline, const std::string& location) {
+    if (!pipeline || !g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "uri")) {
+        return false;
+    }
+    gchar* current = nullptr;
+    g_object_get(pipeline, "uri", &current, nullptr);
+    bool same_kind = current && is_remote(current) == is_remote(location);
+    g_free(current);
+    return same_kind;
+}
+
+bool PipelineLoader::is_remote(const std::string& location) {
+    gchar* scheme = g_uri_parse_scheme(location.c_str());
+    bool remote = scheme && g_ascii_strcasecmp(scheme, "file") != 0;
+    g_free(scheme);
+    return remote;
+}
+
+PipelineConfig PipelineLoader::playbin_config(const std::string& name, const std::string& location,
+                                              const std::string& video_sink, const std::string& audio_sink) {
+    std::string uri_str = to_uri(location);
+
+    // Multi-element sink descriptions have to be quoted
+    auto quote = [](const std::string& sink) {
+        return sink.find(' ') != std::string::npos ? "\"" + sink + "\"" : sink;
+    };
+
+    return {name, "playbin uri=" + uri_str + " video-sink=" + quote(video_sink) +
+                  " audio-sink=" + quote(audio_sink)};
+}
+
+std::vector<PipelineConfig> PipelineLoader::build_configs(const std::string& location) {
+    // For Wayland, we need to use waylandsink or gtksink
+    std::vector<PipelineConfig> configs = {
+        // In-tree renderer: pooled BGRx frames painted straight from the buffer
+        playbin_config("appsink", location, VideoFrameSink::SINK_DESCRIPTION, "autoaudiosink"),
+
+        // Best option for Wayland: gtksink (embedded in GTK)
+        playbin_config("gtksink", location, "gtksink", "autoaudiosink"),
+
+        // Second option: waylandsink
+        playbin_config("waylandsink", location, "waylandsink", "autoaudiosink"),
+
+        // Third option: autovideosink (will use waylandsink automatically on Wayland)
+        playbin_config("autovideosink", location, "autovideosink", "autoaudiosink"),
+
+        // Fallback
+        {"decodebin", "filesrc location=\"" + location + "\" ! decodebin ! videoconvert ! autovideosink name=videosink"}
+    };
+
+    // The filesrc fallback only works for local files
+    if (gst_uri_is_valid(location.c_str())) {
+        configs.pop_back();
+    }
+    return configs;
+}
+
+void PipelineLoader::load(const std::vector<PipelineConfig>& configs, Callback on_done,
+                          Prepare prepare) {
+    cancel();
+
+    auto job = std::make_shared<Job>();
+    job->configs = configs;
+    job->on_done = std::move(on_done);
+    job->setup = setup;
+    job->prepare = std::move(prepare);
+    job->start_time = g_get_monotonic_time();
+    job->workers = workers;
+    current_job = job;
+
+    // Detached: a stuck candidate must not block whoever cancels it
+    {
+        std::lock_guard<std::mutex> lock(workers->mutex);
+        workers->running++;
+    }
+    std::thread(worker, job).detach();
+}
+
+void PipelineLoader::reuse(GstElement* pipeline, const std::string& config_name,
+                           const std::string& location, Callback on_done) {
+    cancel();
+
+    auto job = std::make_shared<Job>();
+    job->on_done = std::move(on_done);
+    job->reused = pipeline;
+    job->reuse_uri = to_uri(location);
+    job->reuse_config = config_name;
+    job->start_time = g_get_monotonic_time();
+    job->workers = workers;
+    current_job = job;
+
+    {
+        std::lock_guard<std::mutex> lock(workers->mutex);
+        workers->running++;
+    }
+    std::thread(worker, job).detach();
+}
+
+// A worker still running stops its own pipeline (see finish()); one that
+// already handed its result over leaves it to be released here
+void PipelineLoader::cancel() {
+    if (!current_job) {
+        return;
+    }
+    bool handed_over;
+    {
+        std::lock_guard<std::mutex> lock(workers->mutex);
+        current_job->cancelled = true;
+        handed_over = current_job->handed_over;
+    }
+    if (handed_over) {
+        release_result(current_job->result);
+    }
+    current_job.reset();
+}
+
+bool PipelineLoader::wait(gint64 timeout_us) {
+    std::unique_lock<std::mutex> lock(workers->mutex);
+    return workers->stopped.wait_for(lock, std::chrono::microseconds(timeout_us),
+                                     [this] { return workers->running == 0; });
+}
+
+bool PipelineLoader::busy() const {
+    return current_job && !current_job->finished;
+}
+
+void PipelineLoader::worker(std::shared_ptr<Job> job) {
+    // No-op once initialised; otherwise loads the registry (or waits for
+    // the thread already loading it)
+    gst_init(nullptr, nullptr);
+    if (job->reused) {
+        if (job->cancelled) {
+            gst_element_set_state(job->reused, GST_STATE_NULL);
+            gst_object_unref(job->reused);
+            job->reused = nullptr;
+        } else {
+            try_reuse(*job, job->result);
+        }
+        finish(job);
+        return;
+    }
+    if (job->prepare && !job->cancelled) {
+        job->prepare(job->configs);
+    }
+
+    for (size_t i = 0; i < job->configs.size() && !job->cancelled; i++) {
+        if (try_config(*job, i, job->result)) {
+            break;
+        }
+    }
+
+    finish(job);
+}
+
+// Hand the result back to the main loop. A job cancelled by now stops its
+// pipeline here instead: the handlers its setup hooks installed point
+// into an owner that may be about to be destroyed once wait() returns.
+void PipelineLoader::finish(std::shared_ptr<Job> job) {
+    Workers& workers = *job->workers;
+    std::unique_lock<std::mutex> lock(workers.mutex);
+    if (job->cancelled) {
+        lock.unlock();
+        if (job->result.video_sink) {
+            gst_object_unref(job->result.video_sink);
+            job->result.video_sink = nullptr;
+        }
+        if (job->result.pipeline) {
+            gst_element_set_state(job->result.pipeline, GST_STATE_NULL);
+            gst_object_unref(job->result.pipeline);
+            job->result.pipeline = nullptr;
+        }
+        lock.lock();
+    } else {
+        job->handed_over = true;
+        g_idle_add_full(G_PRIORITY_DEFAULT, deliver, new std::shared_ptr<Job>(job), nullptr);
+    }
+    workers.running--;
+    workers.stopped.notify_all();
+}
+
+// Pop a pending error off the bus, if any
+static std::string pop_bus_error(GstBus* bus) {
+    std::string message;
+    GstMessage* msg = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR);
+    if (msg) {
+        GError* err = nullptr;
+        gchar* debug = nullptr;
+        gst_message_parse_error(msg, &err, &debug);
+        message = err->message;
+        g_error_free(err);
+        g_free(debug);
+        gst_message_unref(msg);
+    }
+    return message;
+}
+
+// Every message is popped, since a filtered pop drops the rest. Those
+// the receiver's bus watch should still see (stream-start, tags,
+// buffering, duration...) are posted again, in order, once the
+// pipeline has prerolled.
+bool PipelineLoader::wait_for_preroll(Job& job, GstElement* pipeline, GstBus* bus, std::string& error) {
+    gint64 deadline = g_get_monotonic_time() + PREROLL_TIMEOUT / GST_USECOND;
+    std::vector<GstMessage*> deferred;
+    bool prerolled = false;
+    error = "Cancelled";
+
+    while (!job.cancelled) {
+        gint64 remaining = deadline - g_get_monotonic_time();
+        if (remaining <= 0) {
+            error = "Preroll timed out";
+            break;
+        }
+
+        GstMessage* msg = gst_bus_timed_pop(bus, std::min(remaining, BUS_POLL_US) * GST_USECOND);
+        if (!msg) {
+            continue;
+        }
+
+        if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+            GError* err = nullptr;
+            gchar* debug = nullptr;
+            gst_message_parse_error(msg, &err, &debug);
+            error = err->message;
+            g_error_free(err);
+            g_free(debug);
+            gst_message_unref(msg);
+            break;
+        }
+
+        // Only the top-level ASYNC_DONE means the whole pipeline prerolled
+        if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ASYNC_DONE && GST_MESSAGE_SRC(msg) == GST_OBJECT(pipeline)) {
+            gst_message_unref(msg);
+            prerolled = true;
+            break;
+        }
+        deferred.push_back(msg);
+    }
+
+    if (prerolled) {
+        // Ahead of whatever was posted after ASYNC_DONE
+        while (GstMessage* msg = gst_bus_pop(bus)) {
+            deferred.push_back(msg);
+        }
+        for (GstMessage* msg : deferred) {
+            gst_bus_post(bus, msg);
+        }
+        error.clear();
+    } else {
+        for (GstMessage* msg : deferred) {
+            gst_message_unref(msg);
+        }
+    }
+    return prerolled;
+}
+
+// PAUSED, waiting for ASYNC_DONE when the sinks have to preroll
+bool PipelineLoader::preroll(Job& job, GstElement* pipeline, std::string& error) {
+    GstBus* bus = gst_element_get_bus(pipeline);
+    bool prerolled = false;
+
+    GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    if (ret == GST_STATE_CHANGE_FAILURE) {
+        error = pop_bus_error(bus);
+        if (error.empty()) {
+            error = "Failed to go to PAUSED state";
+        }
+    } else if (ret == GST_STATE_CHANGE_ASYNC) {
+        prerolled = wait_for_preroll(job, pipeline, bus, error);
+    } else {
+        // SUCCESS, or NO_PREROLL for live sources
+        prerolled = true;
+    }
+
+    gst_object_unref(bus);
+    return prerolled;
+}
+
+GstElement* PipelineLoader::find_video_sink(GstElement* pipeline) {
+    // playbin exposes its sink as a property; parsed pipelines name it
+    GstElement* video_sink = nullptr;
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "video-sink")) {
+        g_object_get(pipeline, "video-sink", &video_sink, nullptr);
+    }
+    if (!video_sink) {
+        video_sink = gst_bin_get_by_name(GST_BIN(pipeline), "videosink");
+    }
+    return video_sink;
+}
+
+bool PipelineLoader::try_reuse(Job& job, PipelineLoadResult& result) {
+    GstElement* pipeline = job.reused;
+    job.reused = nullptr;
+    std::cout << "\nSwitching pipeline (" << job.reuse_config << ") to " << job.reuse_uri << std::endl;
+
+    // READY drops the streams but keeps the sinks and their devices
+    gst_element_set_state(pipeline, GST_STATE_READY);
+
+    // The old stream's EOS or errors must not end the new preroll
+    GstBus* bus = gst_element_get_bus(pipeline);
+    gst_bus_set_flushing(bus, TRUE);
+    gst_bus_set_flushing(bus, FALSE);
+    gst_object_unref(bus);
+
+    g_object_set(pipeline, "uri", job.reuse_uri.c_str(), nullptr);
+    if (!preroll(job, pipeline, result.error)) {
+        std::cerr << "❌ Pipeline switch failed: " << result.error << std::endl;
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+        return false;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    result.pipeline = pipeline;
+    result.video_sink = find_video_sink(pipeline);
+    result.config_name = job.reuse_config;
+    result.preroll_time_ns = (now - job.start_time) * GST_USECOND;
+    result.error.clear();
+
+    std::cout << "✅ Pipeline switched! (prerolled in " << (now - job.start_time) / 1000 << " ms)" << std::endl;
+    return true;
+}
+
+bool PipelineLoader::try_config(Job& job, size_t index, PipelineLoadResult& result) {
+    const PipelineConfig& config = job.configs[index];
+    std::cout << "\nTrying pipeline " << (index+1) << " (" << config.name << "):\n"
+              << config.description << std::endl;
+
+    GError* error = nullptr;
+    GstElement* pipeline = gst_parse_launch(config.description.c_str(), &error);
+
+    if (error) {
+        std::cerr << "❌ Error: " << error->message << std::endl;
+        result.error = error->message;
+        g_error_free(error);
+        if (pipeline) {
+            gst_object_unref(pipeline);
+        }
+        return false;
+    }
+
+    if (!pipeline) {
+        return false;
+    }
+
+    // A cancelled job must not reach into its owner again
+    if (job.cancelled) {
+        gst_object_unref(pipeline);
+        result.error = "Cancelled";
+        return false;
+    }
+    if (job.setup) {
+        job.setup(pipeline);
+    }
+
+    gint64 candidate_start = g_get_monotonic_time();
+    if (!preroll(job, pipeline, result.error)) {
+        std::cerr << "❌ Pipeline " << (index+1) << " failed: " << result.error << std::endl;
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+        return false;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    result.pipeline = pipeline;
+    result.video_sink = find_video_sink(pipeline);
+    result.config_name = config.name;
+    result.config_index = index;
+    result.preroll_time_ns = (now - job.start_time) * GST_USECOND;
+    result.error.clear();
+
+    std::cout << "✅ Pipeline " << (index+1) << " successful! (prerolled in "
+              << (now - candidate_start) / 1000 << " ms)" << std::endl;
+    return true;
+}
+
+gboolean PipelineLoader::deliver(gpointer data) {
+    auto* holder = static_cast<std::shared_ptr<Job>*>(data);
+    std::shared_ptr<Job> job = *holder;
+    delete holder;
+
+    job->finished = true;
+
+    if (job->cancelled) {
+        release_result(job->result);
+    } else {
+        job->on_done(job->result);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+void PipelineLoader::release_result(PipelineLoadResult& result) {
+    if (result.video_sink) {
+        gst_object_unref(result.video_sink);
+        result.video_sink = nullptr;
+    }
+    if (result.pipeline) {
+        // Runs on the main loop; a prerolled pipeline can be slow to stop
+        PipelineReaper::reap(result.pipeline);
+        result.pipeline = nullptr;
+    }
+}
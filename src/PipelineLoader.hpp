@@ -0,0 +1,114 @@
+#ifndef PIPELINE_LOADER_HPP
+#define PIPELINE_LOADER_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+// One candidate pipeline tried by the loader
+struct PipelineConfig {
+    std::string name;         // Short id, e.g. "gtksink"
+    std::string description;  // gst_parse_launch() description
+};
+
+// Outcome of a load, delivered on the GTK main loop
+struct PipelineLoadResult {
+    GstElement* pipeline = nullptr;    // Prerolled (PAUSED) pipeline, owned by the receiver
+    GstElement* video_sink = nullptr;  // Referenced video sink, may be nullptr
+    std::string config_name;
+    size_t config_index = 0;
+    gint64 preroll_time_ns = 0;        // load() call -> ASYNC_DONE of the winning candidate
+    std::string error;                 // Last failure reason when pipeline is nullptr
+};
+
+// Builds and prerolls candidate pipelines on a worker thread.
+// Candidates are tried in order; each one is driven by its bus
+// (ASYNC_DONE / ERROR) so the GTK thread never waits on a state change.
+class PipelineLoader {
+public:
+    using Callback = std::function<void(PipelineLoadResult& result)>;
+
+    // Runs on the worker for every candidate, after parsing and before
+    // PAUSED, e.g. to hook element creation
+    using Setup = std::function<void(GstElement* pipeline)>;
+
+    // Runs on the worker once GStreamer is initialised, before the first
+    // candidate; may reorder or drop configs (e.g. by registry contents)
+    using Prepare = std::function<void(std::vector<PipelineConfig>& configs)>;
+
+    PipelineLoader();
+    ~PipelineLoader();
+
+    // Start loading; cancels any load still in flight.
+    // on_done runs on the default main context. GStreamer need not be
+    // initialised yet: the worker calls gst_init (or waits for one in
+    // progress), so a cold start's registry load overlaps the caller.
+    void load(const std::vector<PipelineConfig>& configs, Callback on_done,
+              Prepare prepare = nullptr);
+
+    // Switch a prerolled playbin to another file without rebuilding it:
+    // READY, new uri, PAUSED on the worker. The sinks, their negotiated
+    // devices and the setup hooks stay; only the source and decoders are
+    // replaced. Takes over the caller's pipeline ref. On failure the
+    // pipeline is released and the result is empty, so the caller can
+    // fall back to load(). Cancels any load still in flight.
+    void reuse(GstElement* pipeline, const std::string& config_name, const std::string& location,
+               Callback on_done);
+
+    // Drop the in-flight load (its result is released, callback never runs)
+    void cancel();
+
+    // Wait up to timeout_us for every worker this loader started to stop.
+    // After cancel(), an owner whose setup or prepare hooks capture it
+    // calls this before it is destroyed: a cancelled worker runs no more
+    // hooks and stops its pipeline (and the handlers the hooks installed)
+    // itself. False if a worker is still stuck when the time is up.
+    bool wait(gint64 timeout_us);
+
+    // Applies to loads started afterwards
+    void set_setup(Setup new_setup) { setup = std::move(new_setup); }
+
+    bool busy() const;
+
+    // Candidate list for a local file or URI, best option first
+    static std::vector<PipelineConfig> build_configs(const std::string& location);
+
+    // playbin candidate for a local file or URI with the given sink descriptions
+    static PipelineConfig playbin_config(const std::string& name, const std::string& location,
+                                         const std::string& video_sink, const std::string& audio_sink);
+
+    // reuse() can switch pipeline to location: a playbin whose current
+    // uri is local or remote like location (setup hooks configure
+    // network playback per pipeline)
+    static bool can_reuse(GstElement* pipeline, const std::string& location);
+
+    // URIs pass through; paths become escaped file:// URIs
+    static std::string to_uri(const std::string& location);
+    // Has a scheme other than file://
+    static bool is_remote(const std::string& location);
+
+    // Max time a single candidate may take to preroll
+    static constexpr gint64 PREROLL_TIMEOUT = 2 * GST_SECOND;
+
+private:
+    struct Job;
+    struct Workers;
+
+    std::shared_ptr<Job> current_job;
+    std::shared_ptr<Workers> workers;
+    Setup setup;
+
+    static void worker(std::shared_ptr<Job> job);
+    static void finish(std::shared_ptr<Job> job);
+    static bool try_config(Job& job, size_t index, PipelineLoadResult& result);
+    static bool try_reuse(Job& job, PipelineLoadResult& result);
+    static bool preroll(Job& job, GstElement* pipeline, std::string& error);
+    static bool wait_for_preroll(Job& job, GstElement* pipeline, GstBus* bus, std::string& error);
+    static GstElement* find_video_sink(GstElement* pipeline);
+    static gboolean deliver(gpointer data);
+    static void release_result(PipelineLoadResult& result);
+};
+
+#endif // PIPELINE_LOADER_HPP
@@ -0,0 +1,84 @@
+#include "PipelineReaper.hpp"
+#include <iostream>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+// Teardowns slower than this are reported
+static const gint64 SLOW_STOP_US = 100 * 1000;
+
+namespace {
+
+struct State {
+    std::mutex mutex;
+    std::condition_variable wake;     // Work queued
+    std::condition_variable drained;  // Queue empty and nothing in progress
+    std::deque<GstElement*> queue;
+    size_t stopping = 0;              // Taken off the queue, not unreffed yet
+    bool started = false;
+};
+
+// Never destroyed: the thread may still be stopping a pipeline while
+// static destructors run at exit
+State& state() {
+    static State* instance = new State();
+    return *instance;
+}
+
+void run() {
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    while (true) {
+        s.wake.wait(lock, [&s] { return !s.queue.empty(); });
+        GstElement* pipeline = s.queue.front();
+        s.queue.pop_front();
+        s.stopping++;
+        lock.unlock();
+
+        gint64 start = g_get_monotonic_time();
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+        gint64 elapsed = g_get_monotonic_time() - start;
+        if (elapsed > SLOW_STOP_US) {
+            std::cerr << "Warning: Old pipeline took " << elapsed / 1000 << " ms to stop" << std::endl;
+        }
+
+        lock.lock();
+        s.stopping--;
+        if (s.queue.empty() && s.stopping == 0) {
+            s.drained.notify_all();
+        }
+    }
+}
+
+}  // namespace
+
+void PipelineReaper::reap(GstElement* pipeline) {
+    if (!pipeline) {
+        return;
+    }
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.started) {
+        // Never joined: a pipeline stuck in its teardown must not hold up exit
+        std::thread(run).detach();
+        s.started = true;
+    }
+    s.queue.push_back(pipeline);
+    s.wake.notify_one();
+}
+
+bool PipelineReaper::drain(gint64 timeout_us) {
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    return s.drained.wait_for(lock, std::chrono::microseconds(timeout_us),
+                              [&s] { return s.queue.empty() && s.stopping == 0; });
+}
+
+size_t PipelineReaper::pending() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.queue.size() + s.stopping;
+}
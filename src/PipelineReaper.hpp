@@ -0,0 +1,26 @@
+#ifndef PIPELINE_REAPER_HPP
+#define PIPELINE_REAPER_HPP
+
+#include <gst/gst.h>
+#include <cstddef>
+
+// Stops pipelines off the GTK thread. Going to NULL joins a pipeline's
+// streaming threads, which can take seconds when a network source waits
+// on its socket or a sink is stuck in its device; the UI hands the
+// pipeline over and carries on. One process-wide thread, started on first
+// use, stops pipelines in the order they were handed over. Callers detach
+// their probes, bus watches and signal handlers first.
+class PipelineReaper {
+public:
+    // Takes over the caller's reference
+    static void reap(GstElement* pipeline);
+
+    // Wait until every pipeline handed over is stopped; false on timeout
+    // (what is left is abandoned with the process)
+    static bool drain(gint64 timeout_us);
+
+    // Handed over and not stopped yet
+    static size_t pending();
+};
+
+#endif // PIPELINE_REAPER_HPP
@@ -0,0 +1,62 @@
+#include "PlaybackRate.hpp"
+#include <iostream>
+#include <algorithm>
+#include <iterator>
+
+static const double SPEEDS[] = {0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0, 4.0, 8.0, 16.0};
+
+GstSeekFlags PlaybackRate::flags(double rate) {
+    if (!trickmode(rate)) {
+        return GST_SEEK_FLAG_NONE;
+    }
+    return GstSeekFlags(GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS |
+                        GST_SEEK_FLAG_TRICKMODE_NO_AUDIO);
+}
+
+bool PlaybackRate::apply(GstElement* pipeline, double rate, gint64 position, const LoopController* loop) {
+    rate = std::clamp(rate, MIN, MAX);
+    GstSeekFlags seek_flags = GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE | flags(rate));
+    bool sent = loop ? loop->seek(pipeline, rate, seek_flags, position)
+                     : gst_element_seek(pipeline, rate, GST_FORMAT_TIME, seek_flags,
+                                        GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+    if (!sent) {
+        return false;
+    }
+    update_mute(pipeline, rate);
+    return true;
+}
+
+void PlaybackRate::update_mute(GstElement* pipeline, double rate) {
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "mute")) {
+        g_object_set(pipeline, "mute", trickmode(rate), nullptr);
+    }
+}
+
+void PlaybackRate::configure(GstElement* pipeline) {
+    if (!g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "audio-filter")) {
+        return;
+    }
+    GstElement* filter = nullptr;
+    g_object_get(pipeline, "audio-filter", &filter, nullptr);
+    if (filter) {
+        gst_object_unref(filter);
+        return;
+    }
+
+    // Passthrough at 1x, so normal playback pays nothing for it
+    GstElement* scaletempo = gst_element_factory_make("scaletempo", nullptr);
+    if (!scaletempo) {
+        std::cerr << "Warning: scaletempo not available, audio pitch follows the speed" << std::endl;
+        return;
+    }
+    g_object_set(pipeline, "audio-filter", scaletempo, nullptr);
+}
+
+double PlaybackRate::next(double rate, int direction) {
+    if (direction > 0) {
+        const double* faster = std::upper_bound(std::begin(SPEEDS), std::end(SPEEDS), rate + 1e-6);
+        return faster != std::end(SPEEDS) ? *faster : MAX;
+    }
+    const double* slower = std::lower_bound(std::begin(SPEEDS), std::end(SPEEDS), rate - 1e-6);
+    return slower != std::begin(SPEEDS) ? *(slower - 1) : MIN;
+}
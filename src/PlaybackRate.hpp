@@ -0,0 +1,37 @@
+#ifndef PLAYBACK_RATE_HPP
+#define PLAYBACK_RATE_HPP
+
+#include <gst/gst.h>
+#include "LoopController.hpp"
+
+// Forward playback speed. Up to PITCH_LIMIT every frame is decoded and
+// scaletempo (playbin's audio filter) stretches the audio so it keeps its
+// pitch. Faster rates switch to key-unit trick mode with audio dropped:
+// demuxers only push keyframes, so decoders do a few frames a second
+// instead of decoding every frame for the sink to drop.
+class PlaybackRate {
+public:
+    static constexpr double MIN = 0.25;
+    static constexpr double MAX = 16.0;
+    static constexpr double PITCH_LIMIT = 2.0;
+
+    static bool trickmode(double rate) { return rate > PITCH_LIMIT; }
+
+    // Extra seek flags for playing at rate
+    static GstSeekFlags flags(double rate);
+
+    // Flushing seek that continues from position at rate (clamped),
+    // inside loop's segment when it has one set
+    static bool apply(GstElement* pipeline, double rate, gint64 position, const LoopController* loop = nullptr);
+
+    // Mutes playbin while in trick mode, for demuxers that ignore TRICKMODE_NO_AUDIO
+    static void update_mute(GstElement* pipeline, double rate);
+
+    // Loader setup hook: scaletempo as playbin's audio filter
+    static void configure(GstElement* pipeline);
+
+    // Neighbouring speed in direction: 0.25, 0.5, 0.75, 1, 1.25, 1.5, 2, 4, 8, 16
+    static double next(double rate, int direction);
+};
+
+#endif // PLAYBACK_RATE_HPP
@@ -1,47 +1,122 @@
 #include "PlayerGUI.hpp"
+#include "AtomicFile.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <filesystem>
 #include <cstdlib>
+#include <memory>
+#include <cmath>
 #include <gst/video/videooverlay.h>
 #include <gdk/gdk.h>
+#include <glib-unix.h>
+#include <csignal>
+#include <sys/resource.h>
 
 namespace fs = std::filesystem;
 
+// --stats report interval
+static const guint STATS_INTERVAL_S = 5;
+
+// Thumbnails decoded in the background after a file loads
+static const int PREVIEW_SPRITE_COUNT = 60;
+
+// On exit, pipelines still stopping after this long are abandoned
+static const gint64 REAP_DEADLINE_US = 2 * G_USEC_PER_SEC;
+
+// GstPlayFlags of playbin (not in a public header)
+static const guint PLAY_FLAG_TEXT = 1 << 2;
+
+// Times the calling thread (RUSAGE_THREAD) or the process (RUSAGE_SELF)
+// blocked and was woken
+static long voluntary_switches(int who) {
+    struct rusage usage;
+    return getrusage(who, &usage) == 0 ? usage.ru_nvcsw : 0;
+}
+
 PlayerGUI::PlayerGUI() 
-    : window(nullptr), video_area(nullptr), pipeline(nullptr), video_sink(nullptr),
-      duration(0), timer_id(0), is_playing(false), is_fullscreen(false) {
-    // Initialize GStreamer
-    gst_init(nullptr, nullptr);
+    : window(nullptr), video_area(nullptr), preview_popover(nullptr), preview_image(nullptr),
+      preview_label(nullptr), stats_label(nullptr), pipeline(nullptr), video_sink(nullptr),
+      video_gap("video"), audio_gap("audio"), subtitle_choice(-1), gapless_pending(false), duration(0),
+      tick_id(0), stats_timer_id(0), overlay_timer_id(0), telemetry_timer_id(0), callbacks(0), main_switches(0), process_switches(0), displayed_second(-1), displayed_duration(-1),
+      is_playing(false), is_fullscreen(false), is_iconified(false), scrubbing(false), buffering_paused(false),
+      hover_position(-1), load_start_time(0), startup_pending(false), playback_rate(1.0), loop_a(-1), step_wait(StepWait::None),
+      step_target(-1), step_position(-1), step_start_time(0) {
 }
 
 PlayerGUI::~PlayerGUI() {
     cleanup();
+    // The loader's hooks and the handlers they install point into this
+    // object; cleanup() cancelled the load, now let its worker stop
+    if (!loader.wait(REAP_DEADLINE_US)) {
+        std::cerr << "Warning: Pipeline load still running at exit, abandoned" << std::endl;
+    }
+    if (registry_thread.joinable()) {
+        registry_thread.join();
+    }
+    if (!PipelineReaper::drain(REAP_DEADLINE_US)) {
+        std::cerr << "Warning: " << PipelineReaper::pending()
+                  << " pipeline(s) still stopping at exit, abandoned" << std::endl;
+    }
+    Logger::shutdown();
 }
 
 void PlayerGUI::cleanup() {
     std::cout << "Cleaning up resources..." << std::endl;
     
-    // Remove timer
-    if (timer_id) {
-        g_source_remove(timer_id);
-        timer_id = 0;
+    // Remove UI update sources
+    if (tick_id) {
+        gtk_widget_remove_tick_callback(window, tick_id);
+        tick_id = 0;
+    }
+    if (stats_timer_id) {
+        g_source_remove(stats_timer_id);
+        stats_timer_id = 0;
+    }
+    if (overlay_timer_id) {
+        g_source_remove(overlay_timer_id);
+        overlay_timer_id = 0;
     }
+    if (telemetry_timer_id) {
+        g_source_remove(telemetry_timer_id);
+        telemetry_timer_id = 0;
+        write_telemetry();  // Final snapshot
+    }
+    
+    // No more commands; later invocations start their own instance
+    control.stop();
     
-    // Stop and cleanup GStreamer pipeline
+    // Abandon any pipeline still being built
+    loader.cancel();
+    thumbnails.close();
+    keyframes.close();
+    video_gap.detach();
+    audio_gap.detach();
+    renderer.detach();
+    visualizer.hide();
+    telemetry.detach();
+    frame_cache.detach();
+    net_cache.detach();
+    
+    // Stop and cleanup GStreamer pipeline; the reaper thread waits for
+    // it, so the window closes at once
     if (pipeline) {
         std::cout << "Stopping GStreamer pipeline..." << std::endl;
-        gst_element_set_state(pipeline, GST_STATE_NULL);
+        bus = gst_element_get_bus(pipeline);
+        gst_bus_remove_watch(bus);
+        gst_object_unref(bus);
+        g_signal_handlers_disconnect_by_data(pipeline, this);
         
         if (video_sink) {
             gst_object_unref(video_sink);
             video_sink = nullptr;
         }
         
-        gst_object_unref(pipeline);
+        seek_scheduler.set_pipeline(nullptr);
+        PipelineReaper::reap(pipeline);
         pipeline = nullptr;
-        std::cout << "GStreamer pipeline cleaned up" << std::endl;
+        std::cout << "GStreamer pipeline handed to the reaper" << std::endl;
     }
     
     is_playing = false;
@@ -79,7 +154,33 @@ void PlayerGUI::createUI() {
     g_object_unref(css_provider);
     
     gtk_widget_set_size_request(video_area, 640, 360);  // Minimum size
-    gtk_box_pack_start(GTK_BOX(video_container), video_area, TRUE, TRUE, 0);
+    visualizer.set_widget(video_area);  // First: draws instead of the renderer for audio-only files
+    renderer.set_widget(video_area);
+    renderer.set_overlay([this](cairo_t* cr, double x, double y, double width, double height, GstClockTime position) {
+        subtitles.draw(cr, x, y, width, height, gtk_widget_get_scale_factor(video_area), position);
+    });
+    
+    // Telemetry overlay (toggled with I) floats over the top-left corner
+    GtkWidget* video_overlay = gtk_overlay_new();
+    gtk_container_add(GTK_CONTAINER(video_overlay), video_area);
+    stats_label = gtk_label_new("");
+    gtk_widget_set_halign(stats_label, GTK_ALIGN_START);
+    gtk_widget_set_valign(stats_label, GTK_ALIGN_START);
+    gtk_widget_set_margin_start(stats_label, 10);
+    gtk_widget_set_margin_top(stats_label, 10);
+    gtk_widget_set_no_show_all(stats_label, TRUE);
+    
+    GtkCssProvider* stats_css = gtk_css_provider_new();
+    gtk_css_provider_load_from_data(stats_css,
+        "label { font-family: monospace; color: #e0e0e0; background-color: rgba(0,0,0,0.6); padding: 6px; }", -1, NULL);
+    gtk_style_context_add_provider(gtk_widget_get_style_context(stats_label),
+        GTK_STYLE_PROVIDER(stats_css),
+        GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    g_object_unref(stats_css);
+    
+    gtk_overlay_add_overlay(GTK_OVERLAY(video_overlay), stats_label);
+    gtk_overlay_set_overlay_pass_through(GTK_OVERLAY(video_overlay), stats_label, TRUE);
+    gtk_box_pack_start(GTK_BOX(video_container), video_overlay, TRUE, TRUE, 0);
     
     // Create control panel at bottom
     GtkWidget* control_panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
@@ -105,6 +206,20 @@ void PlayerGUI::createUI() {
     gtk_widget_set_margin_start(seek_scale, 10);
     gtk_widget_set_margin_end(seek_scale, 10);
     gtk_box_pack_start(GTK_BOX(control_panel), seek_scale, FALSE, FALSE, 0);
+    gtk_widget_add_events(seek_scale, GDK_POINTER_MOTION_MASK | GDK_LEAVE_NOTIFY_MASK);
+    
+    // Hover preview above the seek bar (non-modal so it never steals input)
+    preview_popover = gtk_popover_new(seek_scale);
+    gtk_popover_set_modal(GTK_POPOVER(preview_popover), FALSE);
+    gtk_popover_set_position(GTK_POPOVER(preview_popover), GTK_POS_TOP);
+    GtkWidget* preview_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 2);
+    preview_image = gtk_image_new();
+    gtk_widget_set_size_request(preview_image, ThumbnailEngine::WIDTH, -1);
+    preview_label = gtk_label_new("00:00");
+    gtk_box_pack_start(GTK_BOX(preview_box), preview_image, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(preview_box), preview_label, FALSE, FALSE, 0);
+    gtk_container_add(GTK_CONTAINER(preview_popover), preview_box);
+    gtk_widget_show_all(preview_box);
     
     // Control buttons (horizontal box)
     GtkWidget* hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
@@ -119,6 +234,11 @@ void PlayerGUI::createUI() {
     gtk_widget_set_tooltip_text(open_button, "Open media file");
     gtk_box_pack_start(GTK_BOX(hbox), open_button, FALSE, FALSE, 0);
     
+    // Library button
+    library_button = gtk_button_new_with_label("📚 Library");
+    gtk_widget_set_tooltip_text(library_button, "Browse the media library (see --scan)");
+    gtk_box_pack_start(GTK_BOX(hbox), library_button, FALSE, FALSE, 0);
+    
     // Play button
     play_button = gtk_button_new_with_label("▶ Play");
     gtk_widget_set_tooltip_text(play_button, "Play media");
@@ -156,13 +276,29 @@ void PlayerGUI::createUI() {
 void PlayerGUI::setupCallbacks() {
     g_signal_connect(window, "destroy", G_CALLBACK(on_window_close), this);
     g_signal_connect(window, "key-press-event", G_CALLBACK(on_window_key_press), this);
+    g_signal_connect(window, "key-release-event", G_CALLBACK(on_window_key_release), this);
+    g_signal_connect(window, "window-state-event", G_CALLBACK(on_window_state), this);
+    g_signal_connect(window, "map-event", G_CALLBACK(on_window_map), this);
+    g_signal_connect(video_area, "realize", G_CALLBACK(on_video_area_realize), this);
+    g_signal_connect(video_area, "size-allocate", G_CALLBACK(on_video_area_size_allocate), this);
+    g_signal_connect(gtk_widget_get_frame_clock(window), "after-paint", G_CALLBACK(on_after_paint), this);
     g_signal_connect(open_button, "clicked", G_CALLBACK(on_open_clicked), this);
+    g_signal_connect(library_button, "clicked", G_CALLBACK(on_library_clicked), this);
     g_signal_connect(play_button, "clicked", G_CALLBACK(on_play_clicked), this);
     g_signal_connect(pause_button, "clicked", G_CALLBACK(on_pause_clicked), this);
     g_signal_connect(stop_button, "clicked", G_CALLBACK(on_stop_clicked), this);
     g_signal_connect(fullscreen_button, "clicked", G_CALLBACK(on_fullscreen_clicked), this);
     g_signal_connect(volume_scale, "value-changed", G_CALLBACK(on_volume_changed), this);
     g_signal_connect(seek_scale, "value-changed", G_CALLBACK(on_seek_changed), this);
+    g_signal_connect(seek_scale, "button-press-event", G_CALLBACK(on_seek_button_press), this);
+    g_signal_connect(seek_scale, "button-release-event", G_CALLBACK(on_seek_button_release), this);
+    g_signal_connect(seek_scale, "motion-notify-event", G_CALLBACK(on_seek_motion), this);
+    g_signal_connect(seek_scale, "leave-notify-event", G_CALLBACK(on_seek_leave), this);
+    
+    // Decoded previews arrive on the main loop
+    thumbnails.set_callback([this](gint64 position, ThumbnailPtr thumbnail) {
+        on_thumbnail_ready(position, thumbnail);
+    });
     
     // Double-click on video area to toggle fullscreen
     g_signal_connect(video_area, "button-press-event", G_CALLBACK(+[](GtkWidget* widget, GdkEventButton* event, gpointer data) -> gboolean {
@@ -187,22 +323,124 @@ void PlayerGUI::show_error(const std::string& message) {
 }
 
 void PlayerGUI::run(int argc, char* argv[]) {
-    // Initialize GTK
+    // Strips GTK's own options without opening the display: --scan and
+    // forwarding to a running instance never need one
+    gtk_parse_args(&argc, &argv);
+    
+    if (!options.parse(argc, argv)) {
+        return;
+    }
+    
+    const char* env_log = g_getenv("VIDC_LOG");
+    for (const std::string& spec : {std::string(env_log ? env_log : ""), options.log_spec}) {
+        if (!spec.empty() && !Logger::configure(spec)) {
+            std::cerr << "Warning: Ignoring log levels \"" << spec << "\"" << std::endl;
+        }
+    }
+    
+    if (!options.scan_dir.empty()) {
+        scan_library();
+        return;
+    }
+    
+    // A running instance takes the files (or the --control commands) and
+    // this process exits before building a pipeline or a window
+    std::string control_path = options.control_socket.empty() ? ControlServer::default_path()
+                                                               : options.control_socket;
+    if (options.single_instance || !options.control_commands.empty()) {
+        if (forward_to_instance(control_path)) {
+            return;
+        }
+        if (!options.control_commands.empty()) {
+            std::cerr << "❌ No running player on " << control_path << std::endl;
+            return;
+        }
+    }
+    
+    // Loading the registry is the slow part of gst_init on a cold start;
+    // it runs while GTK initialises and builds the UI. Anything needing
+    // GStreamer before a pipeline is delivered goes through the loader's
+    // worker, which waits for it.
+    registry_thread = std::thread([] {
+        gst_init(nullptr, nullptr);
+        StartupTimeline::mark("registry");
+    });
     gtk_init(&argc, &argv);
     
+    // Decoder threads are chosen per codec and resolution as decoders appear
+    decoder_policy.load(options.decoder_config.empty() ? DecoderPolicy::default_path()
+                                                       : options.decoder_config);
+    decoder_policy.set_override(options.decoder_threads, options.decoder_thread_type);
+    net_cache.set_max_bytes((guint64)options.net_cache_mb * 1024 * 1024);
+    net_cache.set_buffering({options.buffer_size_kb, options.buffer_low / 100.0, options.buffer_high / 100.0});
+    // Split once the first pipeline is configured, after the registry loaded
+    memory_budget.set_cap((guint64)options.memory_budget_mb * 1024 * 1024);
+    loader.set_setup([this](GstElement* new_pipeline) {
+        decoder_policy.attach(new_pipeline);
+        memory_budget.configure(new_pipeline);
+        net_cache.configure(new_pipeline);  // An explicit --buffer-size wins over the budget
+        PlaybackRate::configure(new_pipeline);
+    });
+    frame_cache.set_max_bytes((size_t)options.frame_cache_mb * 1024 * 1024);
+    renderer.set_downscale(options.downscale);
+    
+    // Every file argument is a playlist entry (media files or .m3u lists).
+    // The first one prerolls while the widgets are built; its result is
+    // delivered on the main loop, after the UI exists.
+    for (const std::string& file : options.files) {
+        playlist.add(file);
+    }
+    bool early_load = !playlist.empty() &&
+                      (PipelineLoader::is_remote(playlist.current()) || fs::exists(playlist.current()));
+    if (early_load) {
+        startup_pending = true;
+        start_load(playlist.current());
+    }
+    
     createUI();
     setupCallbacks();
+    seek_scheduler.set_keyframe_index(&keyframes);
+    seek_scheduler.set_loop(&loop);
+    if (options.loop) {
+        loop.set_file();
+    }
+    
+    if (options.single_instance) {
+        bool listening = control.start(control_path, [this](const std::string& command, const std::string& argument) {
+            return handle_command(command, argument);
+        });
+        if (listening) {
+            std::cout << "🔌 Listening for commands on " << control_path << std::endl;
+        }
+    }
     
-    // Start timer for UI updates
-    timer_id = g_timeout_add(100, update_ui, this);
+    // Position updates follow the frame clock while playing (see update_ticking);
+    // nothing wakes the main loop periodically unless --stats asks for it
+    if (options.stats) {
+        main_switches = voluntary_switches(RUSAGE_THREAD);
+        process_switches = voluntary_switches(RUSAGE_SELF);
+        stats_timer_id = g_timeout_add_seconds(STATS_INTERVAL_S, on_stats_timer, this);
+    }
+    if (!options.telemetry_json.empty()) {
+        telemetry_timer_id = g_timeout_add_seconds(options.telemetry_interval, on_telemetry_timer, this);
+    }
     
-    // Load file from command line if provided
-    if (argc > 1) {
-        load_file(argv[1]);
+    if (early_load) {
+        std::string display_name = fs::path(playlist.current()).filename().string();
+        gtk_label_set_text(GTK_LABEL(file_label), ("Loading: " + display_name).c_str());
+    } else if (!playlist.empty()) {
+        load_file(playlist.current());  // Reports the missing file
     }
     
+    // Ctrl+C and SIGTERM shut down from the main loop, like closing the window
+    guint sigint_id = g_unix_signal_add(SIGINT, on_quit_signal, this);
+    guint sigterm_id = g_unix_signal_add(SIGTERM, on_quit_signal, this);
+    
     // Start GTK main loop
     gtk_main();
+    
+    g_source_remove(sigint_id);
+    g_source_remove(sigterm_id);
 }
 
 // Callback implementations
@@ -230,6 +468,14 @@ void PlayerGUI::on_open_clicked(GtkButton* button, gpointer data) {
     gtk_file_filter_add_pattern(filter, "*.flv");
     gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter);
     
+    GtkFileFilter* subtitle_filter = gtk_file_filter_new();
+    gtk_file_filter_set_name(subtitle_filter, "Subtitles");
+    gtk_file_filter_add_pattern(subtitle_filter, "*.srt");
+    gtk_file_filter_add_pattern(subtitle_filter, "*.vtt");
+    gtk_file_filter_add_pattern(subtitle_filter, "*.ass");
+    gtk_file_filter_add_pattern(subtitle_filter, "*.ssa");
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), subtitle_filter);
+    
     GtkFileFilter* all_filter = gtk_file_filter_new();
     gtk_file_filter_set_name(all_filter, "All Files");
     gtk_file_filter_add_pattern(all_filter, "*");
@@ -237,13 +483,314 @@ void PlayerGUI::on_open_clicked(GtkButton* button, gpointer data) {
     
     if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
         char* filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
-        player->load_file(filename);
+        if (player->pipeline && SubtitleTrack::is_subtitle_file(filename)) {
+            // Shown over the file playing now, first in the S cycle
+            player->subtitle_files.insert(player->subtitle_files.begin(), filename);
+            player->subtitle_choice = 0;
+            player->apply_subtitles();
+        } else {
+            player->playlist.clear();
+            player->playlist.add(filename);
+            if (!player->playlist.empty()) {
+                player->load_file(player->playlist.current());
+            }
+        }
         g_free(filename);
     }
     
     gtk_widget_destroy(dialog);
 }
 
+void PlayerGUI::on_library_clicked(GtkButton* button, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    
+    // Re-read every time: --scan may have run since the last look
+    if (!player->library.load()) {
+        player->show_error("Could not read the media library index");
+        return;
+    }
+    if (player->library.entries().empty()) {
+        player->show_error("The media library is empty. Index a folder with:\n"
+                           "gui-player --scan <folder>");
+        return;
+    }
+    
+    enum { COL_NAME, COL_DURATION, COL_RESOLUTION, COL_CODECS, COL_FOLDER, COL_PATH, COL_DURATION_NS, N_COLUMNS };
+    GtkListStore* store = gtk_list_store_new(N_COLUMNS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                             G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_INT64);
+    for (const auto& entry : player->library.entries()) {
+        const MediaInfo& info = entry.second;
+        if (!info.playable) {
+            continue;
+        }
+        fs::path path(entry.first);
+        bool has_duration = GST_CLOCK_TIME_IS_VALID(info.duration);
+        std::string resolution = info.width > 0 ? std::to_string(info.width) + "×" + std::to_string(info.height) : "";
+        std::string codecs = info.video_codec;
+        if (!info.audio_codec.empty()) {
+            codecs += (codecs.empty() ? "" : " / ") + info.audio_codec;
+        }
+        gtk_list_store_insert_with_values(store, nullptr, -1,
+                                          COL_NAME, path.filename().c_str(),
+                                          COL_DURATION, has_duration ? player->format_time(info.duration).c_str() : "",
+                                          COL_RESOLUTION, resolution.c_str(),
+                                          COL_CODECS, codecs.c_str(),
+                                          COL_FOLDER, path.parent_path().c_str(),
+                                          COL_PATH, entry.first.c_str(),
+                                          COL_DURATION_NS, has_duration ? (gint64)info.duration : (gint64)-1,
+                                          -1);
+    }
+    
+    GtkWidget* dialog = gtk_dialog_new_with_buttons(
+        "Media Library",
+        GTK_WINDOW(player->window),
+        GTK_DIALOG_MODAL,
+        "_Cancel", GTK_RESPONSE_CANCEL,
+        "_Play", GTK_RESPONSE_ACCEPT,
+        NULL);
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 900, 500);
+    
+    GtkWidget* view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    g_object_unref(store);
+    const struct { const char* title; int column; int sort_column; } columns[] = {
+        {"Name", COL_NAME, COL_NAME},
+        {"Duration", COL_DURATION, COL_DURATION_NS},
+        {"Resolution", COL_RESOLUTION, COL_RESOLUTION},
+        {"Codecs", COL_CODECS, COL_CODECS},
+        {"Folder", COL_FOLDER, COL_FOLDER},
+    };
+    for (const auto& column : columns) {
+        GtkTreeViewColumn* view_column = gtk_tree_view_column_new_with_attributes(
+            column.title, gtk_cell_renderer_text_new(), "text", column.column, NULL);
+        gtk_tree_view_column_set_sort_column_id(view_column, column.sort_column);
+        gtk_tree_view_column_set_resizable(view_column, TRUE);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(view), view_column);
+    }
+    gtk_tree_view_set_search_column(GTK_TREE_VIEW(view), COL_NAME);  // Type to find
+    g_signal_connect(view, "row-activated", G_CALLBACK(on_library_row_activated), dialog);
+    
+    GtkWidget* scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_container_add(GTK_CONTAINER(scrolled), view);
+    gtk_box_pack_start(GTK_BOX(gtk_dialog_get_content_area(GTK_DIALOG(dialog))), scrolled, TRUE, TRUE, 0);
+    gtk_widget_show_all(dialog);
+    
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
+        GtkTreeModel* model;
+        GtkTreeIter iter;
+        GtkTreeSelection* selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(view));
+        if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+            gchar* filename = nullptr;
+            gtk_tree_model_get(model, &iter, COL_PATH, &filename, -1);
+            player->playlist.clear();
+            player->playlist.add(filename);
+            if (!player->playlist.empty()) {
+                player->load_file(player->playlist.current());
+            }
+            g_free(filename);
+        }
+    }
+    
+    gtk_widget_destroy(dialog);
+}
+
+void PlayerGUI::on_library_row_activated(GtkTreeView* view, GtkTreePath* path, GtkTreeViewColumn* column, gpointer data) {
+    gtk_dialog_response(GTK_DIALOG(data), GTK_RESPONSE_ACCEPT);
+}
+
+// --scan: index the tree, report throughput and exit without a window
+void PlayerGUI::scan_library() {
+    gst_init(nullptr, nullptr);
+    library.load();
+    
+    std::cout << "🔎 Scanning " << options.scan_dir << "..." << std::endl;
+    ScanStats stats = library.scan(options.scan_dir, options.scan_workers, [](size_t done, size_t total) {
+        std::cout << "\r   Discovered " << done << "/" << total << std::flush;
+    });
+    if (stats.discovered > 0) {
+        std::cout << std::endl;
+    }
+    
+    std::cout << "📚 Indexed " << stats.files << " files in " << stats.seconds << " s ("
+              << (int)stats.files_per_second() << " files/s): "
+              << stats.discovered << " discovered, " << stats.unchanged << " unchanged, "
+              << stats.failed << " unplayable, " << stats.removed << " removed" << std::endl;
+}
+
+bool PlayerGUI::forward_to_instance(const std::string& socket_path) {
+    std::vector<std::string> requests = options.control_commands;
+    if (requests.empty()) {
+        // The instance has its own working directory
+        for (const std::string& file : options.files) {
+            std::string location = PipelineLoader::is_remote(file) ? file : fs::absolute(file).string();
+            requests.push_back((requests.empty() ? "open " : "queue ") + location);
+        }
+        if (requests.empty()) {
+            requests.push_back("show");
+        }
+    }
+    
+    gint64 start = g_get_monotonic_time();
+    std::vector<std::string> replies;
+    bool sent = ControlServer::send(socket_path, requests, replies);
+    if (!sent && replies.empty()) {
+        return false;
+    }
+    
+    if (!options.control_commands.empty()) {
+        for (const std::string& reply : replies) {
+            std::cout << reply << std::endl;
+        }
+    } else {
+        std::cout << "📨 Handed " << options.files.size() << " file(s) to the running player in "
+                  << (g_get_monotonic_time() - start) / 1000.0 << " ms" << std::endl;
+    }
+    if (!sent) {
+        std::cerr << "Warning: The running player stopped answering" << std::endl;
+    }
+    return true;
+}
+
+// Control socket requests, on the main loop. The reply is sent once the
+// command has been handed to the pipeline; loads and seeks complete
+// asynchronously, "status" shows when they have landed.
+std::string PlayerGUI::handle_command(const std::string& command, const std::string& argument) {
+    auto parse_number = [&argument](double& value) {
+        gchar* end = nullptr;
+        value = g_ascii_strtod(argument.c_str(), &end);
+        return !argument.empty() && end && *end == '\0' && std::isfinite(value);
+    };
+    double value = 0;
+    
+    if (command == "ping") {
+        return "ok";
+    } else if (command == "open" || command == "queue") {
+        if (argument.empty()) {
+            return "error missing file";
+        }
+        if (!PipelineLoader::is_remote(argument) && !fs::exists(argument)) {
+            return "error file not found: " + argument;
+        }
+        if (command == "open") {
+            playlist.clear();
+        }
+        bool idle = playlist.empty();
+        playlist.add(argument);
+        if (idle && !playlist.empty()) {
+            load_file(playlist.current());
+        }
+        return "ok";
+    } else if (command == "play") {
+        if (!pipeline) {
+            return "error no file loaded";
+        }
+        if (!is_playing) {
+            play();
+        }
+        return "ok";
+    } else if (command == "pause") {
+        pause();
+        return "ok";
+    } else if (command == "stop") {
+        stop();
+        return "ok";
+    } else if (command == "seek") {
+        if (!parse_number(value)) {
+            return "error seek needs a position in seconds";
+        }
+        if (!pipeline || duration <= 0) {
+            return "error not seekable";
+        }
+        seek(std::clamp(value * GST_SECOND, 0.0, (double)duration));
+        return "ok";
+    } else if (command == "rate") {
+        if (!parse_number(value) || value <= 0) {
+            return "error rate needs a positive speed";
+        }
+        set_rate(value);
+        return "ok rate=" + std::to_string(playback_rate);
+    } else if (command == "loop") {
+        // "off", "file" or "<a> <b>" in seconds
+        if (argument == "off") {
+            loop.clear();
+            loop_a = -1;
+        } else if (argument == "file") {
+            loop.set_file();
+        } else {
+            gchar* end = nullptr;
+            double a = g_ascii_strtod(argument.c_str(), &end);
+            const gchar* rest = end;
+            double b = g_ascii_strtod(rest, &end);
+            if (rest == argument.c_str() || end == rest || *end != '\0' || !std::isfinite(a) || !std::isfinite(b)) {
+                return "error loop needs off, file or <a> <b>";
+            }
+            if (!loop.set_range((gint64)(a * GST_SECOND), (gint64)(b * GST_SECOND))) {
+                return "error loop needs 0 <= a < b";
+            }
+        }
+        update_loop();
+        return "ok loop=" + loop_description();
+    } else if (command == "volume") {
+        if (!parse_number(value)) {
+            return "error volume needs a level from 0 to 1";
+        }
+        gtk_range_set_value(GTK_RANGE(volume_scale), std::clamp(value, 0.0, 1.0) * 100);  // Applies it
+        return "ok";
+    } else if (command == "next" || command == "prev") {
+        bool moved = command == "next" ? play_next() : play_previous();
+        return moved ? "ok" : "error end of playlist";
+    } else if (command == "status") {
+        GstState state = GST_STATE_NULL;
+        gint64 position = -1;
+        if (pipeline) {
+            gst_element_get_state(pipeline, &state, nullptr, 0);
+            gst_element_query_position(pipeline, GST_FORMAT_TIME, &position);
+        }
+        gchar* status = g_strdup_printf("ok state=%s position=%.3f duration=%.3f rate=%g volume=%.2f loading=%d rss_mb=%.1f file=%s",
+                                        gst_element_state_get_name(state),
+                                        position >= 0 ? (double)position / GST_SECOND : -1.0,
+                                        duration > 0 ? (double)duration / GST_SECOND : -1.0,
+                                        playback_rate, gtk_range_get_value(GTK_RANGE(volume_scale)) / 100.0,
+                                        loader.busy() ? 1 : 0, MemoryBudget::rss_bytes() / (1024.0 * 1024.0),
+                                        current_file.c_str());
+        std::string reply = status;
+        g_free(status);
+        return reply;
+    } else if (command == "memory") {
+        // One line: totals, then bytes/limit per queue (0 = no byte limit)
+        gchar* totals = g_strdup_printf("ok rss=%" G_GUINT64_FORMAT " peak=%" G_GUINT64_FORMAT " cap=%" G_GUINT64_FORMAT,
+                                        MemoryBudget::rss_bytes(), MemoryBudget::peak_rss_bytes(), memory_budget.cap());
+        std::string reply = totals;
+        g_free(totals);
+        for (const MemoryBudget::QueueLevel& level : memory_budget.levels(pipeline)) {
+            reply += " " + level.name + "=" + std::to_string(level.bytes) + "/" + std::to_string(level.max_bytes);
+        }
+        return reply;
+    } else if (command == "log") {
+        return Logger::configure(argument) ? "ok" : "error unknown log level or category: " + argument;
+    } else if (command == "show") {
+        gtk_window_present(GTK_WINDOW(window));
+        return "ok";
+    } else if (command == "quit") {
+        // After the reply has gone out
+        g_idle_add_full(G_PRIORITY_LOW, on_quit_idle, this, nullptr);
+        return "ok";
+    }
+    return "error unknown command: " + command;
+}
+
+gboolean PlayerGUI::on_quit_signal(gpointer data) {
+    std::cerr << "\nReceived signal, shutting down..." << std::endl;
+    on_quit_idle(data);
+    return G_SOURCE_CONTINUE;  // Removed by run() once the loop has quit
+}
+
+gboolean PlayerGUI::on_quit_idle(gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->cleanup();
+    gtk_main_quit();
+    return G_SOURCE_REMOVE;
+}
+
 void PlayerGUI::on_play_clicked(GtkButton* button, gpointer data) {
     PlayerGUI* player = static_cast<PlayerGUI*>(data);
     player->play();
@@ -276,6 +823,72 @@ void PlayerGUI::on_seek_changed(GtkRange* range, gpointer data) {
     player->seek((percent / 100.0) * player->duration);
 }
 
+gboolean PlayerGUI::on_seek_button_press(GtkWidget* widget, GdkEventButton* event, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->scrubbing = true;
+    return FALSE;  // Let GtkRange handle the drag
+}
+
+gboolean PlayerGUI::on_seek_button_release(GtkWidget* widget, GdkEventButton* event, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    double percent = gtk_range_get_value(GTK_RANGE(widget));
+    player->finish_scrub((percent / 100.0) * player->duration);
+    return FALSE;
+}
+
+gboolean PlayerGUI::on_seek_motion(GtkWidget* widget, GdkEventMotion* event, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    if (!player->pipeline || player->duration <= 0) {
+        return FALSE;
+    }
+    
+    GtkAllocation allocation;
+    gtk_widget_get_allocation(widget, &allocation);
+    double fraction = CLAMP(event->x / MAX(allocation.width, 1), 0.0, 1.0);
+    player->hover_position = static_cast<gint64>(fraction * player->duration);
+    
+    // Point the preview at the cursor
+    GdkRectangle rect = { static_cast<int>(event->x), 0, 1, 1 };
+    gtk_popover_set_pointing_to(GTK_POPOVER(player->preview_popover), &rect);
+    gtk_label_set_text(GTK_LABEL(player->preview_label),
+                       player->format_time(player->hover_position).c_str());
+    
+    // Cache hit shows immediately; a miss is decoded in the background
+    ThumbnailPtr thumbnail = player->thumbnails.request(player->hover_position);
+    if (thumbnail) {
+        player->show_thumbnail(thumbnail);
+    }
+    
+    gtk_popover_popup(GTK_POPOVER(player->preview_popover));
+    return FALSE;  // GtkRange still needs motion while dragging
+}
+
+gboolean PlayerGUI::on_seek_leave(GtkWidget* widget, GdkEventCrossing* event, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->hover_position = -1;
+    gtk_popover_popdown(GTK_POPOVER(player->preview_popover));
+    return FALSE;
+}
+
+void PlayerGUI::on_thumbnail_ready(gint64 position, ThumbnailPtr thumbnail) {
+    // Ignore late results for a spot the pointer already left
+    if (hover_position >= 0 &&
+        position / ThumbnailEngine::BUCKET == hover_position / ThumbnailEngine::BUCKET) {
+        show_thumbnail(thumbnail);
+    }
+}
+
+void PlayerGUI::show_thumbnail(const ThumbnailPtr& thumbnail) {
+    // The pixbuf borrows the thumbnail's pixels and keeps it alive
+    GdkPixbuf* pixbuf = gdk_pixbuf_new_from_data(
+        thumbnail->pixels.data(), GDK_COLORSPACE_RGB, FALSE, 8,
+        thumbnail->width, thumbnail->height, thumbnail->stride,
+        [](guchar* pixels, gpointer data) { delete static_cast<ThumbnailPtr*>(data); },
+        new ThumbnailPtr(thumbnail));
+    gtk_image_set_from_pixbuf(GTK_IMAGE(preview_image), pixbuf);
+    g_object_unref(pixbuf);
+}
+
 gboolean PlayerGUI::on_window_key_press(GtkWidget* widget, GdkEventKey* event, gpointer data) {
     PlayerGUI* player = static_cast<PlayerGUI*>(data);
     
@@ -287,6 +900,45 @@ gboolean PlayerGUI::on_window_key_press(GtkWidget* widget, GdkEventKey* event, g
     } else if (event->keyval == GDK_KEY_f || event->keyval == GDK_KEY_F) {
         player->toggle_fullscreen();
         return TRUE;  // Event handled
+    } else if (event->keyval == GDK_KEY_n || event->keyval == GDK_KEY_N) {
+        player->play_next();
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_p || event->keyval == GDK_KEY_P) {
+        player->play_previous();
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_i || event->keyval == GDK_KEY_I) {
+        player->toggle_stats_overlay();
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_s || event->keyval == GDK_KEY_S) {
+        player->cycle_subtitles();
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_l || event->keyval == GDK_KEY_L) {
+        player->toggle_loop();
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_a || event->keyval == GDK_KEY_A) {
+        player->mark_loop_point(true);
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_b || event->keyval == GDK_KEY_B) {
+        player->mark_loop_point(false);
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_period) {
+        player->step_frame(1);
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_comma) {
+        player->step_frame(-1);
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_r || event->keyval == GDK_KEY_R) {
+        player->toggle_reverse();
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_bracketright) {
+        player->set_rate(PlaybackRate::next(player->seek_scheduler.rate(), 1));
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_bracketleft) {
+        player->set_rate(PlaybackRate::next(player->seek_scheduler.rate(), -1));
+        return TRUE;
+    } else if (event->keyval == GDK_KEY_backslash) {
+        player->set_rate(1.0);
+        return TRUE;
     } else if (event->keyval == GDK_KEY_space) {
         if (player->is_playing) {
             player->pause();
@@ -295,23 +947,27 @@ gboolean PlayerGUI::on_window_key_press(GtkWidget* widget, GdkEventKey* event, g
         }
         return TRUE;  // Event handled
     } else if (event->keyval == GDK_KEY_Left) {
-        // Seek backward 5 seconds
+        // Seek backward 5 seconds (key repeat scrubs from the pending target)
         if (player->pipeline && player->duration > 0) {
-            gint64 current = 0;
-            if (gst_element_query_position(player->pipeline, GST_FORMAT_TIME, &current)) {
+            gint64 current = player->seek_scheduler.target();
+            if (player->seek_scheduler.busy() ||
+                gst_element_query_position(player->pipeline, GST_FORMAT_TIME, &current)) {
                 gint64 new_position = current - 5 * GST_SECOND;
                 if (new_position < 0) new_position = 0;
+                player->scrubbing = true;
                 player->seek(new_position);
             }
         }
         return TRUE;
     } else if (event->keyval == GDK_KEY_Right) {
-        // Seek forward 5 seconds
+        // Seek forward 5 seconds (key repeat scrubs from the pending target)
         if (player->pipeline && player->duration > 0) {
-            gint64 current = 0;
-            if (gst_element_query_position(player->pipeline, GST_FORMAT_TIME, &current)) {
+            gint64 current = player->seek_scheduler.target();
+            if (player->seek_scheduler.busy() ||
+                gst_element_query_position(player->pipeline, GST_FORMAT_TIME, &current)) {
                 gint64 new_position = current + 5 * GST_SECOND;
                 if (new_position > player->duration) new_position = player->duration;
+                player->scrubbing = true;
                 player->seek(new_position);
             }
         }
@@ -321,6 +977,18 @@ gboolean PlayerGUI::on_window_key_press(GtkWidget* widget, GdkEventKey* event, g
     return FALSE;  // Event not handled
 }
 
+gboolean PlayerGUI::on_window_key_release(GtkWidget* widget, GdkEventKey* event, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    
+    // Releasing a seek key lands on the exact target
+    if ((event->keyval == GDK_KEY_Left || event->keyval == GDK_KEY_Right) && player->scrubbing) {
+        player->finish_scrub(player->seek_scheduler.target());
+        return TRUE;
+    }
+    
+    return FALSE;
+}
+
 gboolean PlayerGUI::on_window_close(GtkWidget* widget, gpointer data) {
     PlayerGUI* player = static_cast<PlayerGUI*>(data);
     
@@ -335,6 +1003,10 @@ gboolean PlayerGUI::on_window_close(GtkWidget* widget, gpointer data) {
 
 gboolean PlayerGUI::bus_callback(GstBus* bus, GstMessage* msg, gpointer data) {
     PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->callbacks++;
+    
+    // QoS, latency, buffering and warnings feed the health counters
+    player->telemetry.handle_message(msg);
     
     switch (GST_MESSAGE_TYPE(msg)) {
         case GST_MESSAGE_ERROR: {
@@ -353,21 +1025,121 @@ gboolean PlayerGUI::bus_callback(GstBus* bus, GstMessage* msg, gpointer data) {
             g_free(debug);
             break;
         }
+        case GST_MESSAGE_SEGMENT_DONE:
+            // End of a loop: back to its start without a flush or a state change
+            if (player->loop.restart(player->pipeline, player->playback_rate,
+                                     PlaybackRate::flags(player->playback_rate))) {
+                LOG_DEBUG(Playback, "🔁 Loop %" G_GUINT64_FORMAT, player->loop.loop_count());
+                break;
+            }
+            // The loop was turned off after its last segment seek
+            if (!player->play_next()) {
+                player->stop();
+            }
+            break;
         case GST_MESSAGE_EOS:
-            player->stop();
+            // Demuxers without segment seeks end the loop with EOS; loop the slow way
+            if (player->loop.active()) {
+                LOG_WARNING(Playback, "Segment seeks not supported, looping with a flushing seek");
+                player->loop.seek(player->pipeline, player->playback_rate,
+                                  GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE |
+                                               PlaybackRate::flags(player->playback_rate)),
+                                  player->playback_rate < 0 ? player->duration : player->loop.start());
+                break;
+            }
+            // Reverse playback ends at the start of this item, not the next one
+            if (player->playback_rate < 0) {
+                player->pause();
+                break;
+            }
+            // Items that could not be queued gaplessly are opened the slow way
+            if (!player->play_next()) {
+                player->stop();
+            }
+            break;
+        case GST_MESSAGE_STREAM_START:
+            if (player->gapless_pending.exchange(false)) {
+                player->on_gapless_transition();
+            }
+            break;
+        case GST_MESSAGE_BUFFERING: {
+            // Network streams: hold playback until the buffer refills
+            player->net_cache.handle_message(msg);
+            gint percent = 100;
+            gst_message_parse_buffering(msg, &percent);
+            if (percent < 100 && player->is_playing) {
+                gst_element_set_state(player->pipeline, GST_STATE_PAUSED);
+                player->buffering_paused = true;
+            } else if (percent == 100 && player->buffering_paused) {
+                player->buffering_paused = false;
+                gst_element_set_state(player->pipeline, GST_STATE_PLAYING);
+            }
+            if (percent < 100 || player->buffering_paused) {
+                std::string label = "Buffering: " + std::to_string(percent) + "%";
+                gtk_label_set_text(GTK_LABEL(player->file_label), label.c_str());
+            } else {
+                std::string display_name = fs::path(player->current_file).filename().string();
+                gtk_label_set_text(GTK_LABEL(player->file_label), ("Loaded: " + display_name).c_str());
+            }
+            break;
+        }
+        case GST_MESSAGE_DURATION_CHANGED:
+            gst_element_query_duration(player->pipeline, GST_FORMAT_TIME, &player->duration);
+            break;
+        case GST_MESSAGE_APPLICATION: {
+            const GstStructure* s = gst_message_get_structure(msg);
+            if (gst_structure_has_name(s, GapMeter::MESSAGE_NAME)) {
+                double gap_ms = 0;
+                gst_structure_get_double(s, "gap-ms", &gap_ms);
+                const gchar* transition = gst_structure_get_string(s, "transition");
+                if (g_strcmp0(transition, "segment") != 0) {
+                    std::cout << "⏱ Transition gap (" << gst_structure_get_string(s, "stream")
+                              << "): " << gap_ms << " ms" << std::endl;
+                } else if (player->loop.active()) {
+                    LOG_DEBUG(Playback, "⏱ Loop gap (%s): %.3f ms", gst_structure_get_string(s, "stream"), gap_ms);
+                }
+            }
+            break;
+        }
+        case GST_MESSAGE_ASYNC_DONE:
+            // A flushing seek finished prerolling at its new position
+            player->seek_scheduler.on_async_done(msg);
+            if (player->step_wait == StepWait::BackSeek) {
+                player->step_back_decoded();
+            } else if (player->step_wait == StepWait::Seek) {
+                player->finish_step(false);
+            }
+            player->update_position();
+            break;
+        case GST_MESSAGE_STEP_DONE:
+            if (player->step_wait == StepWait::Step) {
+                player->finish_step(false);
+                player->update_position();
+            }
             break;
         case GST_MESSAGE_STATE_CHANGED: {
+            // Only the pipeline's own state matters, not every child element's
+            if (GST_MESSAGE_SRC(msg) != GST_OBJECT(player->pipeline)) {
+                break;
+            }
+            
             GstState old_state, new_state, pending;
             gst_message_parse_state_changed(msg, &old_state, &new_state, &pending);
             
-            // Update play/pause button state
+            // Update play/pause button state; PAUSED on the way to PLAYING
+            // is not a pause
             if (new_state == GST_STATE_PLAYING) {
+                if (old_state != GST_STATE_PLAYING) {
+                    LOG_INFO(Playback, "✅ Playback started successfully!");
+                }
                 player->is_playing = true;
                 gtk_button_set_label(GTK_BUTTON(player->play_button), "⏸ Pause");
-            } else if (new_state == GST_STATE_PAUSED) {
+            } else if (new_state == GST_STATE_PAUSED && pending == GST_STATE_VOID_PENDING) {
                 player->is_playing = false;
                 gtk_button_set_label(GTK_BUTTON(player->play_button), "▶ Play");
             }
+            player->update_ticking();
+            player->update_frame_caching();
             break;
         }
     }
@@ -375,153 +1147,371 @@ gboolean PlayerGUI::bus_callback(GstBus* bus, GstMessage* msg, gpointer data) {
     return TRUE;
 }
 
-gboolean PlayerGUI::update_ui(gpointer data) {
+gboolean PlayerGUI::on_tick(GtkWidget* widget, GdkFrameClock* clock, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->callbacks++;
+    player->update_position();
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean PlayerGUI::on_window_state(GtkWidget* widget, GdkEventWindowState* event, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->is_iconified = (event->new_window_state & GDK_WINDOW_STATE_ICONIFIED) != 0;
+    player->update_ticking();
+    return FALSE;
+}
+
+gboolean PlayerGUI::on_stats_timer(gpointer data) {
     PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->callbacks++;
     
-    if (player->pipeline) {
-        // Update time display
-        player->update_time_display();
-        
-        // Update seek slider if playing
-        if (player->is_playing) {
-            gint64 position = 0;
-            if (gst_element_query_position(player->pipeline, GST_FORMAT_TIME, &position)) {
-                if (player->duration > 0) {
-                    double percent = (double)position / player->duration * 100.0;
-                    // Block signal to prevent recursive call
-                    g_signal_handlers_block_by_func(player->seek_scale, (gpointer)on_seek_changed, player);
-                    gtk_range_set_value(GTK_RANGE(player->seek_scale), percent);
-                    g_signal_handlers_unblock_by_func(player->seek_scale, (gpointer)on_seek_changed, player);
-                }
-            }
+    // Real wakeups are the times a thread slept and was woken: voluntary
+    // context switches, of the GTK thread (this one) and of the process.
+    // The callbacks are only the player's own share of the main thread's.
+    long main_now = voluntary_switches(RUSAGE_THREAD);
+    long process_now = voluntary_switches(RUSAGE_SELF);
+    std::cout << "📊 Wakeups: main thread " << (double)(main_now - player->main_switches) / STATS_INTERVAL_S
+              << "/s, all threads " << (double)(process_now - player->process_switches) / STATS_INTERVAL_S
+              << "/s; player callbacks " << (double)player->callbacks / STATS_INTERVAL_S << "/s"
+              << " (frame clock " << (player->tick_id ? "on" : "off") << ")" << std::endl;
+    player->main_switches = main_now;
+    player->process_switches = process_now;
+    player->callbacks = 0;
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean PlayerGUI::on_overlay_timer(gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->callbacks++;
+    gtk_label_set_text(GTK_LABEL(player->stats_label), player->overlay_text().c_str());
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean PlayerGUI::on_telemetry_timer(gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->callbacks++;
+    player->write_telemetry();
+    return G_SOURCE_CONTINUE;
+}
+
+// The overlay refreshes once a second, and only while it is visible
+void PlayerGUI::toggle_stats_overlay() {
+    if (overlay_timer_id) {
+        g_source_remove(overlay_timer_id);
+        overlay_timer_id = 0;
+        gtk_widget_hide(stats_label);
+        return;
+    }
+    
+    gtk_label_set_text(GTK_LABEL(stats_label), overlay_text().c_str());
+    gtk_widget_show(stats_label);
+    overlay_timer_id = g_timeout_add_seconds(1, on_overlay_timer, this);
+}
+
+std::string PlayerGUI::overlay_text() {
+    std::string text = telemetry.summary() + "\n" + memory_budget.summary(pipeline);
+    if (subtitles.loaded()) {
+        text += "\nSubtitles: " + std::to_string(subtitles.track().size()) + " cues, bitmap cache " +
+                std::to_string(subtitles.cache_hits()) + " hits / " + std::to_string(subtitles.cache_misses()) +
+                " misses";
+    }
+    return text;
+}
+
+// One JSON object per snapshot: appended line to stdout, or replacing the file
+void PlayerGUI::write_telemetry() {
+    std::string json = telemetry.to_json();
+    if (options.telemetry_json == "-") {
+        std::cout << json << std::endl;
+        return;
+    }
+    
+    if (!write_file_atomically(options.telemetry_json, [&json](std::ostream& out) { out << json << '\n'; })) {
+        std::cerr << "Warning: Could not write telemetry to " << options.telemetry_json << std::endl;
+    }
+}
+
+// Tick on the frame clock only while there is something moving to show
+void PlayerGUI::update_ticking() {
+    bool want_ticks = pipeline && is_playing && !is_iconified;
+    
+    if (want_ticks && !tick_id) {
+        tick_id = gtk_widget_add_tick_callback(window, on_tick, this, nullptr);
+    } else if (!want_ticks && tick_id) {
+        gtk_widget_remove_tick_callback(window, tick_id);
+        tick_id = 0;
+    }
+    visualizer.set_running(want_ticks);
+}
+
+// Audio-only media get the spectrum in the video area; the stream count
+// is settled once playbin has prerolled (or switched to the next item)
+void PlayerGUI::update_visualizer() {
+    bool audio_only = false;
+    if (pipeline && g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "n-video")) {
+        gint n_video = 0, n_audio = 0;
+        g_object_get(pipeline, "n-video", &n_video, "n-audio", &n_audio, nullptr);
+        audio_only = n_video == 0 && n_audio > 0;
+    }
+    
+    if (!audio_only) {
+        visualizer.hide();
+    } else if (!visualizer.visible() && !visualizer.show(pipeline)) {
+        std::cerr << "Warning: No audio sink to visualise" << std::endl;
+    }
+    update_ticking();
+}
+
+// Sidecar files of the new current_file; the first one is shown. The
+// file is parsed here, once, into the overlay's cue table.
+void PlayerGUI::open_subtitles() {
+    subtitle_files.clear();
+    if (renderer.active() && !PipelineLoader::is_remote(current_file)) {
+        subtitle_files = SubtitleTrack::find_sidecars(current_file);
+    }
+    subtitle_choice = !subtitle_files.empty() || embedded_subtitle_count() > 0 ? 0 : -1;
+    apply_subtitles();
+}
+
+gint PlayerGUI::embedded_subtitle_count() {
+    gint n_text = 0;
+    if (pipeline && g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "n-text")) {
+        g_object_get(pipeline, "n-text", &n_text, nullptr);
+    }
+    return n_text;
+}
+
+// Sidecar files, then the file's own text streams, then off
+void PlayerGUI::cycle_subtitles() {
+    gint total = (gint)subtitle_files.size() + embedded_subtitle_count();
+    subtitle_choice = subtitle_choice + 1 < total ? subtitle_choice + 1 : -1;
+    apply_subtitles();
+    if (subtitle_choice < 0) {
+        std::cout << "💬 Subtitles off" << std::endl;
+    }
+}
+
+void PlayerGUI::apply_subtitles() {
+    bool external = subtitle_choice >= 0 && subtitle_choice < (int)subtitle_files.size();
+    bool embedded = subtitle_choice >= (int)subtitle_files.size();
+    
+    if (external && !renderer.active()) {
+        // Only the in-tree renderer draws the overlay
+        std::cerr << "Warning: External subtitles need the built-in renderer, not shown" << std::endl;
+        external = false;
+    }
+    if (external) {
+        const std::string& path = subtitle_files[subtitle_choice];
+        gint64 start = g_get_monotonic_time();
+        if (subtitles.load(path)) {
+            std::cout << "💬 Subtitles: " << fs::path(path).filename().string() << " ("
+                      << subtitles.track().size() << " cues, parsed in "
+                      << (g_get_monotonic_time() - start) / 1000 << " ms)" << std::endl;
+        } else {
+            std::cerr << "Warning: No subtitles in " << path << std::endl;
+        }
+    } else {
+        subtitles.clear();
+    }
+    
+    // playbin renders embedded streams itself; keep it off while a file is shown
+    if (pipeline && g_object_class_find_property(G_OBJECT_GET_CLASS(pipeline), "current-text")) {
+        guint flags = 0;
+        g_object_get(pipeline, "flags", &flags, nullptr);
+        flags = embedded ? flags | PLAY_FLAG_TEXT : flags & ~PLAY_FLAG_TEXT;
+        g_object_set(pipeline, "flags", flags, nullptr);
+        if (embedded) {
+            g_object_set(pipeline, "current-text", subtitle_choice - (gint)subtitle_files.size(), nullptr);
+            std::cout << "💬 Subtitles: embedded stream " << (subtitle_choice - subtitle_files.size() + 1)
+                      << "/" << embedded_subtitle_count() << std::endl;
         }
     }
+    gtk_widget_queue_draw(video_area);  // Paused frames show the change too
+}
+
+// One position query feeds both the time label and the seek slider
+void PlayerGUI::update_position() {
+    if (!pipeline) {
+        return;
+    }
+    
+    // Gapless transitions may not know the new duration right away
+    if (duration <= 0) {
+        gst_element_query_duration(pipeline, GST_FORMAT_TIME, &duration);
+    }
+    
+    gint64 position = 0;
+    if (!gst_element_query_position(pipeline, GST_FORMAT_TIME, &position)) {
+        return;
+    }
     
-    return TRUE; // Continue timer
+    update_time_display(position);
+    
+    // Update seek slider (not while the user is moving it)
+    if (duration > 0 && !scrubbing && !seek_scheduler.busy()) {
+        double percent = (double)position / duration * 100.0;
+        // Block signal to prevent recursive call
+        g_signal_handlers_block_by_func(seek_scale, (gpointer)on_seek_changed, this);
+        gtk_range_set_value(GTK_RANGE(seek_scale), percent);
+        g_signal_handlers_unblock_by_func(seek_scale, (gpointer)on_seek_changed, this);
+    }
 }
 
 // Player control methods - Wayland specific
 void PlayerGUI::load_file(const std::string& filename) {
-    // Clean up previous pipeline
+    // Drop any load still in flight
+    loader.cancel();
+    startup_pending = false;  // The timeline is for the command-line file only
+    thumbnails.close();
+    keyframes.close();
+    
+    // Network URIs are checked by the source
+    bool missing = !PipelineLoader::is_remote(filename) && !fs::exists(filename);
+    
+    // Clean up previous pipeline; a playbin that can play the new file is
+    // kept (with its sinks) and switched instead of rebuilt
+    GstElement* warm = nullptr;
+    std::string location;
     if (pipeline) {
-        gst_element_set_state(pipeline, GST_STATE_NULL);
-        gst_object_unref(pipeline);
+        // Queued messages of the old pipeline must not reach the new one's handlers
+        bus = gst_element_get_bus(pipeline);
+        gst_bus_remove_watch(bus);
+        gst_object_unref(bus);
+        
+        // Keeps a finished download; needs the pipeline still running to tell
+        net_cache.detach();
+        
+        if (!missing && options.warm_switch) {
+            location = net_cache.lookup(filename);
+            if (location.empty()) {
+                location = filename;
+            }
+        }
+        g_signal_handlers_disconnect_by_data(pipeline, this);
+        if (video_sink) {
+            gst_object_unref(video_sink);
+            video_sink = nullptr;
+        }
+        seek_scheduler.set_pipeline(nullptr);
+        video_gap.detach();
+        audio_gap.detach();
+        renderer.detach();
+        visualizer.hide();
+        telemetry.detach();
+        frame_cache.detach();
+        
+        // Our ref moves to the loader, or to the reaper thread so the new
+        // file starts without waiting for the old pipeline to stop
+        if (!location.empty() && PipelineLoader::can_reuse(pipeline, location)) {
+            warm = pipeline;
+        } else {
+            PipelineReaper::reap(pipeline);
+        }
         pipeline = nullptr;
-        video_sink = nullptr;
     }
+    playback_rate = 1.0;
+    seek_scheduler.set_rate(1.0);
+    step_wait = StepWait::None;
+    step_position = -1;
+    buffering_paused = false;
     
-    // First, check if file exists
-    if (!fs::exists(filename)) {
+    // A-B points belong to the file they were marked in; a whole-file loop stays
+    loop_a = -1;
+    if (loop.mode() == LoopController::Mode::Range) {
+        loop.clear();
+        if (options.loop) {
+            loop.set_file();
+        }
+    }
+    
+    if (missing) {
         show_error("File not found: " + filename);
         return;
     }
     
     std::cout << "Loading file: " << filename << std::endl;
     
-    // Ensure video area is realized
-    if (!gtk_widget_get_realized(video_area)) {
-        gtk_widget_realize(video_area);
+    std::string display_name = fs::path(filename).filename().string();
+    gtk_label_set_text(GTK_LABEL(file_label), ("Loading: " + display_name).c_str());
+    
+    if (warm) {
+        switch_load(filename, location, warm);
+    } else {
+        start_load(filename);
+    }
+}
+
+// READY, new uri, PAUSED on the loader's worker; rebuilds from scratch if
+// the kept pipeline cannot preroll the new file
+void PlayerGUI::switch_load(const std::string& filename, const std::string& location, GstElement* warm) {
+    if (location != filename) {
+        std::cout << "📦 Serving from cache: " << filename << std::endl;
     }
+    load_start_time = g_get_monotonic_time();
+    loader.reuse(warm, pipeline_config, location, [this, filename](PipelineLoadResult& result) {
+        if (!result.pipeline) {
+            std::cout << "Rebuilding pipeline for: " << filename << std::endl;
+            start_load(filename);
+            return;
+        }
+        on_pipeline_loaded(filename, result);
+    });
+}
+
+// Needs no widgets, so it can run before createUI()
+void PlayerGUI::start_load(const std::string& filename) {
+    // Network media downloaded completely before plays from disk
+    std::string location = net_cache.lookup(filename);
+    if (!location.empty()) {
+        std::cout << "📦 Serving from cache: " << filename << std::endl;
+    } else {
+        location = filename;
+    }
+    std::vector<PipelineConfig> configs = PipelineLoader::build_configs(location);
+    std::string backend = G_OBJECT_TYPE_NAME(gdk_display_get_default());
     
-    // For Wayland, we need to use waylandsink or gtksink
-    std::vector<std::string> pipeline_configs = {
-        // Best option for Wayland: gtksink (embedded in GTK)
-        "playbin uri=file://" + filename + " video-sink=gtksink name=videosink audio-sink=autoaudiosink",
-        
-        // Second option: waylandsink
-        "playbin uri=file://" + filename + " video-sink=waylandsink name=videosink audio-sink=autoaudiosink",
-        
-        // Third option: autovideosink (will use waylandsink automatically on Wayland)
-        "playbin uri=file://" + filename + " video-sink=autovideosink name=videosink audio-sink=autoaudiosink",
-        
-        // Fallback
-        "filesrc location=\"" + filename + "\" ! decodebin ! videoconvert ! autovideosink name=videosink"
+    // The cache key fingerprints the registry, so the config that last
+    // prerolled on this machine is moved first on the worker, after
+    // gst_init. The main thread only touches sink_cache once the result
+    // is delivered, and a new load cancels the old one first.
+    auto choice = std::make_shared<SinkChoice>();
+    PipelineLoader::Prepare prepare = [this, backend, choice](std::vector<PipelineConfig>& candidates) {
+        choice->key = SinkCache::make_key(backend);
+        choice->config = sink_cache.lookup(choice->key);
+        auto cached = std::find_if(candidates.begin(), candidates.end(),
+                                   [&choice](const PipelineConfig& config) { return config.name == choice->config; });
+        if (cached != candidates.end()) {
+            std::cout << "Using cached pipeline config: " << choice->config << std::endl;
+            std::rotate(candidates.begin(), cached, cached + 1);
+        } else {
+            choice->config.clear();
+        }
     };
     
-    GError* error = nullptr;
-    bool success = false;
-    
-    for (size_t i = 0; i < pipeline_configs.size() && !success; i++) {
-        std::cout << "\nTrying pipeline " << (i+1) << ":\n" << pipeline_configs[i] << std::endl;
+    // Candidates are built and prerolled off the GTK thread
+    load_start_time = g_get_monotonic_time();
+    loader.load(configs,
+                [this, filename, choice](PipelineLoadResult& result) {
+                    sink_cache_key = choice->key;
+                    cached_config = choice->config;
+                    on_pipeline_loaded(filename, result);
+                },
+                prepare);
+}
+
+void PlayerGUI::on_pipeline_loaded(const std::string& filename, PipelineLoadResult& result) {
+    if (!result.pipeline) {
+        gtk_label_set_text(GTK_LABEL(file_label), "No file loaded");
+        startup_pending = false;
         
-        pipeline = gst_parse_launch(pipeline_configs[i].c_str(), &error);
+        // Every config failing says more about the file than the sinks, so
+        // the cached choice stays
         
-        if (error) {
-            std::cerr << "❌ Error: " << error->message << std::endl;
-            g_error_free(error);
-            error = nullptr;
-            if (pipeline) {
-                gst_object_unref(pipeline);
-                pipeline = nullptr;
-            }
-            continue;
-        }
-        
-        if (pipeline) {
-            // Get the video sink element
-            video_sink = gst_bin_get_by_name(GST_BIN(pipeline), "videosink");
-            
-            // For Wayland, if we have a video overlay sink, set it up
-            if (video_sink && GST_IS_VIDEO_OVERLAY(video_sink)) {
-                // Get the GDK window
-                GdkWindow* gdk_window = gtk_widget_get_window(video_area);
-                if (gdk_window) {
-                    // For Wayland, we need to use a different approach
-                    // The surface handle is managed automatically by GTK/GDK
-                    std::cout << "Setting up video overlay for Wayland" << std::endl;
-                    
-                    // Get video area dimensions
-                    GtkAllocation allocation;
-                    gtk_widget_get_allocation(video_area, &allocation);
-                    
-                    // Set video to fill the entire area
-                    gst_video_overlay_set_render_rectangle(GST_VIDEO_OVERLAY(video_sink), 
-                                                           0, 0, 
-                                                           allocation.width, 
-                                                           allocation.height);
-                    
-                    // Expose the widget to GStreamer
-                    gst_video_overlay_expose(GST_VIDEO_OVERLAY(video_sink));
-                }
-            }
-            
-            // First try to set to PAUSED state
-            GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PAUSED);
-            
-            if (ret == GST_STATE_CHANGE_FAILURE) {
-                std::cerr << "❌ Failed to go to PAUSED state" << std::endl;
-                if (video_sink) {
-                    gst_object_unref(video_sink);
-                    video_sink = nullptr;
-                }
-                gst_object_unref(pipeline);
-                pipeline = nullptr;
-                continue;
-            }
-            
-            // Wait for state change to complete
-            ret = gst_element_get_state(pipeline, nullptr, nullptr, 2 * GST_SECOND);
-            
-            if (ret != GST_STATE_CHANGE_SUCCESS) {
-                std::cerr << "❌ State change didn't complete" << std::endl;
-                gst_element_set_state(pipeline, GST_STATE_NULL);
-                if (video_sink) {
-                    gst_object_unref(video_sink);
-                    video_sink = nullptr;
-                }
-                gst_object_unref(pipeline);
-                pipeline = nullptr;
-                continue;
-            }
-            
-            success = true;
-            std::cout << "✅ Pipeline " << (i+1) << " successful!" << std::endl;
-        }
-    }
-    
-    if (!success || !pipeline) {
         // Show detailed error help
         std::string error_msg = "Failed to create pipeline for: " + filename;
+        if (!result.error.empty()) {
+            error_msg += "\n\nLast error: " + result.error;
+        }
         error_msg += "\n\nTroubleshooting steps:\n";
         error_msg += "1. Test with command line:\n";
         error_msg += "   gst-play-1.0 \"" + filename + "\"\n\n";
@@ -533,6 +1523,63 @@ void PlayerGUI::load_file(const std::string& filename) {
         return;
     }
     
+    // Only playbin sink configs are remembered: the decodebin fallback is
+    // what is left when every sink failed, not a choice worth repeating
+    bool is_playbin = g_signal_lookup("about-to-finish", G_OBJECT_TYPE(result.pipeline)) != 0;
+    if (is_playbin) {
+        sink_cache.store(sink_cache_key, result.config_name);
+    } else if (!cached_config.empty() && result.config_name != cached_config) {
+        // The cached config failed where another one played
+        sink_cache.invalidate(sink_cache_key);
+    }
+    
+    // The loader's setup hook has settled the budget by now
+    if (memory_budget.enabled()) {
+        frame_cache.set_max_bytes(std::min<size_t>((size_t)options.frame_cache_mb * 1024 * 1024,
+                                                   memory_budget.limits().frame_cache_bytes));
+    }
+    
+    pipeline = result.pipeline;
+    video_sink = result.video_sink;
+    pipeline_config = result.config_name;
+    result.pipeline = nullptr;
+    result.video_sink = nullptr;
+    seek_scheduler.set_pipeline(pipeline);
+    
+    // playbin can be handed the next playlist item before this one ends
+    gapless_pending = false;
+    if (g_signal_lookup("about-to-finish", G_OBJECT_TYPE(pipeline))) {
+        g_signal_connect(pipeline, "about-to-finish", G_CALLBACK(on_about_to_finish), this);
+        
+        GstElement* audio_sink = nullptr;
+        g_object_get(pipeline, "audio-sink", &audio_sink, nullptr);
+        audio_gap.attach(audio_sink);
+        if (audio_sink) {
+            gst_object_unref(audio_sink);
+        }
+    }
+    video_gap.attach(video_sink);
+    telemetry.attach(pipeline, video_sink);
+    
+    // In-tree output: frames are painted into video_area by the renderer
+    renderer.attach(pipeline);
+    
+    // Cache what the renderer can paint (its appsink input); with other
+    // sinks the probe still tracks the frame on screen for stepping
+    GstElement* cache_sink = renderer.active()
+        ? gst_bin_get_by_name(GST_BIN(pipeline), VideoFrameSink::SINK_NAME) : nullptr;
+    frame_cache.attach(cache_sink ? cache_sink : video_sink);
+    if (cache_sink) {
+        gst_object_unref(cache_sink);
+    }
+    update_frame_caching();
+    
+    // Overlay sinks need video_area's window; on a cold start the pipeline
+    // can preroll before it exists, so the realize handler finishes this
+    if (gtk_widget_get_realized(video_area)) {
+        attach_video_output();
+    }
+    
     // Setup bus callback
     bus = gst_element_get_bus(pipeline);
     gst_bus_add_watch(bus, bus_callback, this);
@@ -545,6 +1592,20 @@ void PlayerGUI::load_file(const std::string& filename) {
     }
     
     current_file = filename;
+    open_subtitles();
+    
+    // Seek-bar previews come from their own pipeline; fill a sprite sheet in the background.
+    // Not for network media, which would be fetched a second time.
+    if (!PipelineLoader::is_remote(filename)) {
+        thumbnails.open(PipelineLoader::to_uri(filename));
+        thumbnails.precompute(duration, PREVIEW_SPRITE_COUNT);
+        
+        // Mapped from the sidecar, or built in the background on first open
+        keyframes.open(filename);
+    }
+    
+    // Completed downloads are kept for the next open
+    net_cache.attach(pipeline);
     
     // Update UI
     std::string display_name = fs::path(filename).filename().string();
@@ -552,8 +1613,7 @@ void PlayerGUI::load_file(const std::string& filename) {
                       ("Loaded: " + display_name).c_str());
     
     // Reset time display
-    std::string time_display = "00:00 / " + format_time(duration);
-    gtk_label_set_text(GTK_LABEL(time_label), time_display.c_str());
+    reset_time_display();
     
     // Reset seek slider
     g_signal_handlers_block_by_func(seek_scale, (gpointer)on_seek_changed, this);
@@ -561,71 +1621,228 @@ void PlayerGUI::load_file(const std::string& filename) {
     g_signal_handlers_unblock_by_func(seek_scale, (gpointer)on_seek_changed, this);
     
     // AUTO-ENTER FULLSCREEN WHEN FILE IS LOADED
-    if (!is_fullscreen) {
+    bool entered_fullscreen = !is_fullscreen;
+    if (entered_fullscreen) {
         toggle_fullscreen();
     }
     
+    update_visualizer();
+    
+    // Looping starts with a segment seek; the pipeline is still PAUSED
+    if (loop.active()) {
+        loop.seek(pipeline, 1.0, GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE), 0);
+    }
+    
     // Start playback automatically
     play();
     
+    // Startup timeline of the command-line file; the renderer's first paint
+    // marks its first frame, other sinks show the prerolled frame at once
+    if (startup_pending) {
+        StartupTimeline::mark_at("preroll", load_start_time + result.preroll_time_ns / GST_USECOND);
+        if (!renderer.active()) {
+            StartupTimeline::mark_at("first frame", load_start_time + result.preroll_time_ns / GST_USECOND);
+            report_startup();
+        }
+    }
+    
+    // Other sinks already show the prerolled frame; the renderer's first
+    // frame is its first paint, which the startup timeline reports
+    gint64 ui_ready_ms = (g_get_monotonic_time() - load_start_time) / 1000;
     std::cout << "✅ Successfully loaded: " << filename << std::endl;
     std::cout << "Duration: " << (duration / GST_SECOND) << " seconds" << std::endl;
-    std::cout << "Auto-entered fullscreen mode" << std::endl;
+    std::cout << (renderer.active() ? "⏱ Preroll time: " : "⏱ Time to first frame: ")
+              << (result.preroll_time_ns / GST_MSECOND) << " ms"
+              << " (" << result.config_name << ", playing after " << ui_ready_ms << " ms)" << std::endl;
+    if (entered_fullscreen) {
+        std::cout << "Auto-entered fullscreen mode" << std::endl;
+    }
+}
+
+void PlayerGUI::attach_video_output() {
+    // For Wayland, if we have a video overlay sink, set it up
+    if (video_sink && GST_IS_VIDEO_OVERLAY(video_sink)) {
+        // Get the GDK window
+        GdkWindow* gdk_window = gtk_widget_get_window(video_area);
+        if (gdk_window) {
+            // For Wayland, we need to use a different approach
+            // The surface handle is managed automatically by GTK/GDK
+            std::cout << "Setting up video overlay for Wayland" << std::endl;
+            update_render_rectangle();
+        }
+    }
+}
+
+// Overlay sinks draw into a rectangle of their own; keep it on the video area
+void PlayerGUI::update_render_rectangle() {
+    if (!video_sink || !GST_IS_VIDEO_OVERLAY(video_sink)) {
+        return;
+    }
+    
+    // Set video to fill the entire area
+    GtkAllocation allocation;
+    gtk_widget_get_allocation(video_area, &allocation);
+    gst_video_overlay_set_render_rectangle(GST_VIDEO_OVERLAY(video_sink), 
+                                           0, 0, 
+                                           allocation.width, 
+                                           allocation.height);
+    gst_video_overlay_expose(GST_VIDEO_OVERLAY(video_sink));
+}
+
+// Window resizes, fullscreen and un-maximise all end up here; the
+// appsink renderer follows the size by itself
+void PlayerGUI::on_video_area_size_allocate(GtkWidget* widget, GdkRectangle* allocation, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    player->update_render_rectangle();
+}
+
+void PlayerGUI::on_video_area_realize(GtkWidget* widget, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    if (player->pipeline) {
+        player->attach_video_output();
+    }
+}
+
+// Watches frame-clock paints until the renderer has put the first frame up
+void PlayerGUI::on_after_paint(GdkFrameClock* clock, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    if (!player->startup_pending) {
+        g_signal_handlers_disconnect_by_func(clock, (gpointer)on_after_paint, data);
+    } else if (player->renderer.painted_count() > 0) {
+        StartupTimeline::mark("first frame");
+        player->report_startup();
+    }
+}
+
+gboolean PlayerGUI::on_window_map(GtkWidget* widget, GdkEvent* event, gpointer data) {
+    StartupTimeline::mark("UI shown");
+    return FALSE;
+}
+
+void PlayerGUI::report_startup() {
+    startup_pending = false;
+    std::cout << "🚀 Startup: " << StartupTimeline::summary() << std::endl;
+}
+
+// Runs on a streaming thread shortly before the current item drains
+void PlayerGUI::on_about_to_finish(GstElement* playbin, gpointer data) {
+    PlayerGUI* player = static_cast<PlayerGUI*>(data);
+    
+    // A looping item never finishes
+    std::string next = player->loop.active() ? "" : player->playlist.peek_next();
+    if (next.empty()) {
+        return;
+    }
+    
+    // Let go of the finished download before the uri changes; it is kept
+    // from the main loop, off this thread
+    player->net_cache.finish();
+    
+    // Downloaded network media plays from disk; a remote next item is
+    // downloaded even if this pipeline started with a local file
+    std::string cached = player->net_cache.lookup(next);
+    std::string uri = PipelineLoader::to_uri(cached.empty() ? next : cached);
+    player->net_cache.configure_next(playbin, uri);
+    
+    // Same pipeline, same sinks: playbin switches streams without a gap
+    g_object_set(playbin, "uri", uri.c_str(), nullptr);
+    player->gapless_pending = true;
+    LOG_INFO(Playback, "Queued next item (gapless): %s", next.c_str());
+}
+
+void PlayerGUI::on_gapless_transition() {
+    playlist.advance();
+    current_file = playlist.current();
+    open_subtitles();
+    seek_scheduler.reset();
+    frame_cache.clear();
+    step_position = -1;
+    
+    duration = 0;
+    gst_element_query_duration(pipeline, GST_FORMAT_TIME, &duration);
+    
+    if (!PipelineLoader::is_remote(current_file)) {
+        thumbnails.open(PipelineLoader::to_uri(current_file));
+        thumbnails.precompute(duration, PREVIEW_SPRITE_COUNT);
+        keyframes.open(current_file);
+    } else {
+        thumbnails.close();
+        keyframes.close();
+    }
+    net_cache.attach(pipeline);
+    
+    update_visualizer();
+    
+    // The new item starts with a 1x segment; carry the chosen speed over
+    if (seek_scheduler.rate() != 1.0) {
+        set_rate(seek_scheduler.rate());
+    }
+    
+    std::string display_name = fs::path(current_file).filename().string();
+    gtk_label_set_text(GTK_LABEL(file_label), ("Loaded: " + display_name).c_str());
+    
+    std::cout << "▶ Now playing (" << (playlist.position() + 1) << "/" << playlist.size()
+              << "): " << current_file << std::endl;
+}
+
+bool PlayerGUI::play_next() {
+    if (!playlist.advance()) {
+        return false;
+    }
+    load_file(playlist.current());
+    return true;
+}
+
+bool PlayerGUI::play_previous() {
+    if (!playlist.go_back()) {
+        return false;
+    }
+    load_file(playlist.current());
+    return true;
 }
 
 void PlayerGUI::play() {
     if (pipeline && !is_playing) {
-        std::cout << "Attempting to start playback..." << std::endl;
+        LOG_DEBUG(Playback, "Attempting to start playback...");
+        leave_cached_frame();
         
+        // Never waits: reaching PLAYING is reported by STATE_CHANGED on the
+        // bus, and a failure while prerolling by ERROR
         GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PLAYING);
         
-        std::cout << "State change return: " << ret << std::endl;
+        LOG_DEBUG(Playback, "State change return: %s", gst_element_state_change_return_get_name(ret));
         
         if (ret == GST_STATE_CHANGE_FAILURE) {
             // Try to get more error details
             GstBus* error_bus = gst_element_get_bus(pipeline);
-            GstMessage* msg = gst_bus_timed_pop_filtered(error_bus, 0, 
-                GstMessageType(GST_MESSAGE_ERROR | GST_MESSAGE_WARNING));
+            GstMessage* msg = gst_bus_pop_filtered(error_bus, GST_MESSAGE_ERROR);
             
             std::string error_msg = "Failed to start playback";
             
             if (msg) {
                 GError* err;
                 gchar* debug;
-                if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
-                    gst_message_parse_error(msg, &err, &debug);
-                    error_msg = std::string("Playback error: ") + err->message;
-                    if (debug) {
-                        error_msg += "\nDebug: " + std::string(debug);
-                    }
-                    g_error_free(err);
-                    g_free(debug);
+                gst_message_parse_error(msg, &err, &debug);
+                error_msg = std::string("Playback error: ") + err->message;
+                if (debug) {
+                    error_msg += "\nDebug: " + std::string(debug);
                 }
+                g_error_free(err);
+                g_free(debug);
                 gst_message_unref(msg);
             }
             
             gst_object_unref(error_bus);
-            
-            // Try a different approach - set to READY first, then PLAYING
-            std::cout << "Trying alternative playback method..." << std::endl;
-            gst_element_set_state(pipeline, GST_STATE_READY);
-            ret = gst_element_set_state(pipeline, GST_STATE_PLAYING);
-            
-            if (ret == GST_STATE_CHANGE_FAILURE) {
-                show_error(error_msg + "\n\nTry:\n1. Install missing codecs\n2. Check video output");
-                return;
-            }
+            show_error(error_msg + "\n\nTry:\n1. Install missing codecs\n2. Check video output");
+            return;
         }
         
-        // Wait for state change to complete
-        ret = gst_element_get_state(pipeline, nullptr, nullptr, 2 * GST_SECOND);
-        if (ret == GST_STATE_CHANGE_SUCCESS) {
-            is_playing = true;
-            gtk_button_set_label(GTK_BUTTON(play_button), "⏸ Pause");
-            std::cout << "✅ Playback started successfully!" << std::endl;
-        } else {
-            show_error("Playback started but state change didn't complete");
-        }
+        // Playing as far as the controls are concerned; the bus watch
+        // corrects this if the pipeline settles elsewhere
+        is_playing = true;
+        update_ticking();
+        update_frame_caching();
+        gtk_button_set_label(GTK_BUTTON(play_button), "⏸ Pause");
     } else if (!pipeline) {
         show_error("No file loaded. Please open a media file first.");
     } else {
@@ -635,18 +1852,31 @@ void PlayerGUI::play() {
 }
 
 void PlayerGUI::pause() {
+    buffering_paused = false;  // Stay paused when the buffer refills
     if (pipeline && is_playing) {
         gst_element_set_state(pipeline, GST_STATE_PAUSED);
         is_playing = false;
+        update_ticking();
+        update_frame_caching();
         gtk_button_set_label(GTK_BUTTON(play_button), "▶ Play");
-        std::cout << "Playback paused" << std::endl;
+        LOG_INFO(Playback, "Playback paused");
     }
 }
 
 void PlayerGUI::stop() {
     if (pipeline) {
-        gst_element_set_state(pipeline, GST_STATE_READY);
+        // Back to the start at 1x, paused: both complete asynchronously, where
+        // READY would join the streaming threads on the GTK thread
+        gst_element_set_state(pipeline, GST_STATE_PAUSED);
+        seek_scheduler.reset();
+        loop.seek(pipeline, 1.0, GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE), 0);
+        if (playback_rate != 1.0) {
+            playback_rate = 1.0;
+            seek_scheduler.set_rate(1.0);
+            PlaybackRate::update_mute(pipeline, 1.0);
+        }
         is_playing = false;
+        update_frame_caching();
         gtk_button_set_label(GTK_BUTTON(play_button), "▶ Play");
         
         // Reset seek slider
@@ -655,10 +1885,10 @@ void PlayerGUI::stop() {
         g_signal_handlers_unblock_by_func(seek_scale, (gpointer)on_seek_changed, this);
         
         // Reset time display
-        std::string time_display = "00:00 / " + format_time(duration);
-        gtk_label_set_text(GTK_LABEL(time_label), time_display.c_str());
+        reset_time_display();
+        update_ticking();
         
-        std::cout << "Playback stopped" << std::endl;
+        LOG_INFO(Playback, "Playback stopped");
     }
 }
 
@@ -667,29 +1897,15 @@ void PlayerGUI::toggle_fullscreen() {
         gtk_window_unfullscreen(GTK_WINDOW(window));
         gtk_button_set_label(GTK_BUTTON(fullscreen_button), "Fullscreen");
         is_fullscreen = false;
-        std::cout << "Exited fullscreen mode" << std::endl;
+        LOG_INFO(Video, "Exited fullscreen mode");
     } else {
         gtk_window_fullscreen(GTK_WINDOW(window));
         gtk_button_set_label(GTK_BUTTON(fullscreen_button), "Exit Fullscreen");
         is_fullscreen = true;
-        std::cout << "Entered fullscreen mode" << std::endl;
+        LOG_INFO(Video, "Entered fullscreen mode");
     }
     
-    // Update video overlay rectangle when resizing
-    if (video_sink && GST_IS_VIDEO_OVERLAY(video_sink)) {
-        // Get new video area dimensions
-        GtkAllocation allocation;
-        gtk_widget_get_allocation(video_area, &allocation);
-        
-        // Set video to fill the entire area
-        gst_video_overlay_set_render_rectangle(GST_VIDEO_OVERLAY(video_sink), 
-                                               0, 0, 
-                                               allocation.width, 
-                                               allocation.height);
-        
-        // Expose again after resize
-        gst_video_overlay_expose(GST_VIDEO_OVERLAY(video_sink));
-    }
+    // The video area's new size arrives through size-allocate
 }
 
 void PlayerGUI::set_volume(double volume) {
@@ -703,31 +1919,282 @@ void PlayerGUI::set_volume(double volume) {
             // Try setting on playbin directly
             g_object_set(pipeline, "volume", volume, nullptr);
         }
-        std::cout << "Volume set to: " << (volume * 100) << "%" << std::endl;
+        LOG_THROTTLED(Info, Audio, 250, "Volume set to: %g%%", volume * 100);
     }
 }
 
 void PlayerGUI::seek(double position) {
     if (pipeline && duration > 0) {
+        // Keyframe seeks while scrubbing; the display updates on ASYNC_DONE
         gint64 nanoseconds = static_cast<gint64>(position);
-        bool success = gst_element_seek_simple(pipeline, GST_FORMAT_TIME,
-                               GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT),
-                               nanoseconds);
-        if (success) {
-            std::cout << "Seeked to: " << (position / GST_SECOND) << " seconds" << std::endl;
-            update_time_display();
+        step_position = -1;
+        playback_rate = seek_scheduler.rate();  // Scheduler seeks play forward
+        seek_scheduler.request(nanoseconds, scrubbing ? SeekScheduler::Mode::Scrub
+                                                      : SeekScheduler::Mode::Accurate);
+    }
+}
+
+void PlayerGUI::finish_scrub(gint64 position) {
+    scrubbing = false;
+    if (pipeline && duration > 0 && position >= 0) {
+        step_position = -1;
+        playback_rate = seek_scheduler.rate();
+        seek_scheduler.request(position, SeekScheduler::Mode::Accurate);
+    }
+}
+
+// One frame forward (direction > 0) or back. Back steps are served from
+// the frame cache when the renderer can paint cached frames; a miss seeks
+// to the keyframe before the target and steps forward to it, which fills
+// the cache with that whole GOP on the way.
+void PlayerGUI::step_frame(int direction) {
+    if (!pipeline || step_wait != StepWait::None) {
+        return;  // One step at a time
+    }
+    pause();
+    step_start_time = g_get_monotonic_time();
+    
+    // Steps go forward in stream time at 1x; leave reverse and fast
+    // segments with a seek
+    bool reseek = playback_rate != 1.0;
+    playback_rate = 1.0;
+    if (seek_scheduler.rate() != 1.0) {
+        seek_scheduler.set_rate(1.0);
+        PlaybackRate::update_mute(pipeline, 1.0);
+    }
+    
+    gint64 current = step_position >= 0 ? step_position : frame_cache.last_position();
+    if (current < 0 && !gst_element_query_position(pipeline, GST_FORMAT_TIME, &current)) {
+        return;
+    }
+    
+    // Forward hits only exist while stepping back through cached frames
+    if (renderer.active() && (direction < 0 || step_position >= 0)) {
+        GstSample* sample = direction < 0 ? frame_cache.lookup_before(current)
+                                          : frame_cache.lookup_after(current);
+        if (sample) {
+            gint64 position = FrameCache::sample_position(sample);
+            if (renderer.present(sample)) {
+                // Back on the frame the pipeline holds: nothing to resync
+                step_position = position == frame_cache.last_position() ? -1 : position;
+                update_time_display(position);
+                finish_step(true);
+                return;
+            }
         }
     }
+    
+    gint64 frame = frame_cache.frame_duration();
+    if (direction < 0) {
+        step_target = current - frame;
+        if (step_target < 0) {
+            step_start_time = 0;
+            return;
+        }
+        step_position = -1;
+        step_wait = StepWait::BackSeek;
+        loop.seek(pipeline, 1.0, GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT |
+                                              GST_SEEK_FLAG_SNAP_BEFORE), step_target);
+    } else if (step_position >= 0 || reseek) {
+        // Past the last cached frame: move the pipeline to the next one
+        step_position = -1;
+        step_wait = StepWait::Seek;
+        loop.seek(pipeline, 1.0, GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE), current + frame);
+    } else {
+        step_wait = StepWait::Step;
+        gst_element_send_event(pipeline, gst_event_new_step(GST_FORMAT_BUFFERS, 1, 1.0, TRUE, FALSE));
+    }
 }
 
-void PlayerGUI::update_time_display() {
-    if (pipeline) {
-        gint64 position = 0;
-        if (gst_element_query_position(pipeline, GST_FORMAT_TIME, &position)) {
-            std::string time_str = format_time(position) + " / " + format_time(duration);
-            gtk_label_set_text(GTK_LABEL(time_label), time_str.c_str());
+// The keyframe before a missed back step has prerolled; step up to the target
+void PlayerGUI::step_back_decoded() {
+    gint64 keyframe = 0;
+    gst_element_query_position(pipeline, GST_FORMAT_TIME, &keyframe);
+    gint64 frame = frame_cache.frame_duration();
+    guint64 frames = step_target > keyframe ? (step_target - keyframe + frame / 2) / frame : 0;
+    
+    if (frames == 0) {
+        finish_step(false);
+        return;
+    }
+    step_wait = StepWait::Step;
+    gst_element_send_event(pipeline, gst_event_new_step(GST_FORMAT_BUFFERS, frames, 1.0, TRUE, FALSE));
+}
+
+void PlayerGUI::finish_step(bool cache_hit) {
+    double latency_ms = (g_get_monotonic_time() - step_start_time) / 1000.0;
+    step_wait = StepWait::None;
+    step_start_time = 0;
+    frame_cache.record_step(cache_hit, latency_ms);
+    
+    LOG_INFO(Seek, "⏯ Frame step: %.2f ms (%s, hit rate %d%%, cache %zu MB)", latency_ms,
+             cache_hit ? "cached" : "decoded", (int)(frame_cache.hit_rate() * 100),
+             frame_cache.size_bytes() / (1024 * 1024));
+}
+
+// Put the pipeline on the frame shown from the cache before it runs again
+gint64 PlayerGUI::leave_cached_frame() {
+    gint64 position = step_position;
+    if (step_position >= 0) {
+        step_position = -1;
+        loop.seek(pipeline, 1.0, GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE), position);
+    }
+    return position;
+}
+
+// Reverse playback from the current frame back to the start (and forward
+// again). Decoders output each GOP backwards after decoding it once; the
+// frames also land in the frame cache for stepping afterwards.
+void PlayerGUI::toggle_reverse() {
+    if (!pipeline || step_wait != StepWait::None) {
+        return;
+    }
+    
+    gint64 position = leave_cached_frame();
+    if (position < 0 && !gst_element_query_position(pipeline, GST_FORMAT_TIME, &position)) {
+        return;
+    }
+    
+    // Forward again at the speed chosen with [ and ]
+    double rate = playback_rate > 0 ? -1.0 : seek_scheduler.rate();
+    GstSeekFlags flags = GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE);
+    bool ok = rate < 0 ? loop.seek(pipeline, rate, flags, position)
+                       : PlaybackRate::apply(pipeline, rate, position, &loop);
+    if (!ok) {
+        LOG_WARNING(Playback, "Reverse playback not supported for this file");
+        return;
+    }
+    if (rate < 0) {
+        PlaybackRate::update_mute(pipeline, rate);
+    }
+    
+    playback_rate = rate;
+    update_frame_caching();
+    LOG_INFO(Playback, "%s", rate < 0 ? "⏪ Playing in reverse" : "▶ Playing forward");
+    if (!is_playing) {
+        play();
+    }
+}
+
+// Forward speed, kept across seeks until the next file is loaded.
+// Applying it from a reverse segment plays forward again.
+void PlayerGUI::set_rate(double rate) {
+    if (!pipeline || step_wait != StepWait::None) {
+        return;
+    }
+    
+    rate = std::clamp(rate, PlaybackRate::MIN, PlaybackRate::MAX);
+    gint64 position = leave_cached_frame();
+    if (position < 0 && !gst_element_query_position(pipeline, GST_FORMAT_TIME, &position)) {
+        return;
+    }
+    if (!PlaybackRate::apply(pipeline, rate, position, &loop)) {
+        LOG_WARNING(Playback, "Speed change not supported for this file");
+        return;
+    }
+    
+    playback_rate = rate;
+    seek_scheduler.set_rate(rate);
+    update_frame_caching();
+    LOG_INFO(Playback, "⏩ Speed %gx%s", rate,
+             PlaybackRate::trickmode(rate) ? " (keyframes only, audio muted)" : "");
+}
+
+// L: loop the whole file, or stop looping (an A-B loop too)
+void PlayerGUI::toggle_loop() {
+    if (step_wait != StepWait::None) {
+        return;
+    }
+    if (loop.active()) {
+        loop.clear();
+        loop_a = -1;
+    } else {
+        loop.set_file();
+    }
+    update_loop();
+}
+
+// A marks where the next A-B loop starts (the start of the file until
+// then); B marks its end and starts it. A inside a running A-B loop moves
+// its start.
+void PlayerGUI::mark_loop_point(bool start) {
+    if (!pipeline || step_wait != StepWait::None) {
+        return;
+    }
+    gint64 position = step_position >= 0 ? step_position : -1;
+    if (position < 0 && !gst_element_query_position(pipeline, GST_FORMAT_TIME, &position)) {
+        return;
+    }
+    
+    if (start) {
+        loop_a = position;
+        LOG_INFO(Playback, "🔁 Loop start at %.3f s", (double)position / GST_SECOND);
+        if (loop.mode() != LoopController::Mode::Range) {
+            return;
         }
+        if (!loop.set_range(loop_a, loop.stop())) {
+            loop.clear();  // A moved past B
+        }
+    } else if (!loop.set_range(std::max<gint64>(loop_a, 0), position)) {
+        LOG_WARNING(Playback, "Loop end must come after its start");
+        return;
+    }
+    update_loop();
+}
+
+// A flushing seek from the current position gives the pipeline a segment
+// that matches the loop, or none when looping stops
+void PlayerGUI::update_loop() {
+    if (!pipeline) {
+        LOG_INFO(Playback, "🔁 Loop: %s", loop_description().c_str());
+        return;
     }
+    gint64 position = leave_cached_frame();
+    if (position < 0 && !gst_element_query_position(pipeline, GST_FORMAT_TIME, &position)) {
+        position = loop.start();
+    }
+    GstSeekFlags flags = GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE | PlaybackRate::flags(playback_rate));
+    if (!loop.seek(pipeline, playback_rate, flags, position)) {
+        LOG_WARNING(Playback, "Looping not supported for this file");
+        loop.clear();
+        return;
+    }
+    LOG_INFO(Playback, "🔁 Loop: %s", loop_description().c_str());
+}
+
+std::string PlayerGUI::loop_description() {
+    if (loop.mode() == LoopController::Mode::File) {
+        return "file";
+    } else if (loop.mode() == LoopController::Mode::Range) {
+        gchar* range = g_strdup_printf("%.3f-%.3f", (double)loop.start() / GST_SECOND, (double)loop.stop() / GST_SECOND);
+        std::string text = range;
+        g_free(range);
+        return text;
+    }
+    return "off";
+}
+
+// Copying frames costs a memcpy per frame, so only while they may be stepped back to
+void PlayerGUI::update_frame_caching() {
+    frame_cache.set_enabled(!is_playing || playback_rate < 0);
+}
+
+void PlayerGUI::update_time_display(gint64 position) {
+    // Re-layout the label only when the shown second actually changes
+    gint64 second = position / GST_SECOND;
+    gint64 duration_second = duration / GST_SECOND;
+    if (second == displayed_second && duration_second == displayed_duration) {
+        return;
+    }
+    displayed_second = second;
+    displayed_duration = duration_second;
+    
+    std::string time_str = format_time(position) + " / " + format_time(duration);
+    gtk_label_set_text(GTK_LABEL(time_label), time_str.c_str());
+}
+
+void PlayerGUI::reset_time_display() {
+    update_time_display(0);
 }
 
 std::string PlayerGUI::format_time(gint64 nanoseconds) {
@@ -5,6 +5,31 @@
 #include <gst/gst.h>
 #include <string>
 #include <chrono>
+#include <atomic>
+#include <thread>
+#include "PipelineLoader.hpp"
+#include "SinkCache.hpp"
+#include "SeekScheduler.hpp"
+#include "ThumbnailEngine.hpp"
+#include "Playlist.hpp"
+#include "GapMeter.hpp"
+#include "Options.hpp"
+#include "VideoRenderer.hpp"
+#include "Visualizer.hpp"
+#include "SubtitleOverlay.hpp"
+#include "KeyframeIndex.hpp"
+#include "Telemetry.hpp"
+#include "DecoderPolicy.hpp"
+#include "FrameCache.hpp"
+#include "StartupTimeline.hpp"
+#include "ProgressiveCache.hpp"
+#include "MemoryBudget.hpp"
+#include "MediaLibrary.hpp"
+#include "PlaybackRate.hpp"
+#include "LoopController.hpp"
+#include "ControlServer.hpp"
+#include "PipelineReaper.hpp"
+#include "Logger.hpp"
 
 class PlayerGUI {
 public:
@@ -21,24 +46,83 @@ private:
     GtkWidget* pause_button;
     GtkWidget* stop_button;
     GtkWidget* open_button;
+    GtkWidget* library_button;
     GtkWidget* volume_scale;
     GtkWidget* seek_scale;
     GtkWidget* time_label;
     GtkWidget* file_label;
     GtkWidget* fullscreen_button;
     GtkWidget* video_container;  // Container for video area
+    GtkWidget* preview_popover;  // Seek-bar hover preview
+    GtkWidget* preview_image;
+    GtkWidget* preview_label;
+    GtkWidget* stats_label;      // Telemetry overlay on top of the video
     
     // GStreamer
     GstElement* pipeline;
     GstElement* video_sink;
     GstBus* bus;
+    std::thread registry_thread;  // gst_init, overlapped with GTK startup
+    PipelineLoader loader;
+    SinkCache sink_cache;
+    std::string sink_cache_key;  // Display backend + registry of this session
+    std::string cached_config;   // Config tried first for the current load
+    std::string pipeline_config; // Config of the pipeline playing now
+    struct SinkChoice {          // Settled on the loader worker (needs the registry)
+        std::string key;
+        std::string config;
+    };
+    SeekScheduler seek_scheduler;
+    LoopController loop;      // Whole-file / A-B loop via segment seeks
+    KeyframeIndex keyframes;  // Sidecar seek table for poorly indexed containers
+    ThumbnailEngine thumbnails;
+    GapMeter video_gap;
+    GapMeter audio_gap;
+    VideoRenderer renderer;  // Paints the appsink output into video_area
+    Visualizer visualizer;   // Takes video_area over for audio-only media
+    SubtitleOverlay subtitles;  // External subtitle file, drawn by the renderer
+    Telemetry telemetry;
+    DecoderPolicy decoder_policy;  // Applied by the loader to every candidate pipeline
+    FrameCache frame_cache;        // Decoded frames for stepping back without a re-decode
+    ProgressiveCache net_cache;    // Downloads of http(s) media, replayed from disk
+    MemoryBudget memory_budget;    // --memory-budget-mb queue limits; queue levels for the overlay
+    MediaLibrary library;          // Index written by --scan, browsed without decoding
+    ControlServer control;         // --single-instance command socket
     
     // State
+    PlayerOptions options;
+    Playlist playlist;
     std::string current_file;
+    std::vector<std::string> subtitle_files;  // Sidecars of current_file, then picked files
+    int subtitle_choice;     // Index into subtitle_files, then embedded text streams; -1 = off
+    std::atomic<bool> gapless_pending;  // Next URI handed to playbin, STREAM_START not seen yet
     gint64 duration;
-    guint timer_id;
+    guint tick_id;           // Frame-clock callback; only installed while playing and visible
+    guint stats_timer_id;
+    guint overlay_timer_id;  // Refreshes stats_label while it is shown
+    guint telemetry_timer_id;
+    guint64 callbacks;       // Player callbacks run on the main loop, for --stats
+    long main_switches;      // Voluntary context switches at the last --stats report:
+    long process_switches;   // of the GTK thread, of the whole process
+    gint64 displayed_second; // What time_label currently shows, -1 to force a refresh
+    gint64 displayed_duration;
     bool is_playing;
     bool is_fullscreen;
+    bool is_iconified;
+    bool scrubbing;          // Seek slider dragged or seek key held
+    bool buffering_paused;   // Paused by BUFFERING, resume at 100%
+    gint64 hover_position;   // Seek-bar position under the pointer, -1 if none
+    gint64 load_start_time;  // Monotonic time (us) of the last load_file()
+    bool startup_pending;    // Command-line file not on screen yet; report the timeline then
+    double playback_rate;    // Segment rate: negative while playing in reverse
+    gint64 loop_a;           // Marked with A for the next A-B loop, -1 = start of file
+    
+    // Frame stepping
+    enum class StepWait { None, Step, Seek, BackSeek };
+    StepWait step_wait;      // Bus message the step in flight is waiting for
+    gint64 step_target;      // Frame a back step that missed the cache lands on
+    gint64 step_position;    // Frame shown from the cache, -1 when the sink shows its own
+    gint64 step_start_time;  // Monotonic time (us) the step in flight was requested
     
     // Private methods
     void createUI();
@@ -48,6 +132,8 @@ private:
     
     // Static callbacks
     static void on_open_clicked(GtkButton* button, gpointer data);
+    static void on_library_clicked(GtkButton* button, gpointer data);
+    static void on_library_row_activated(GtkTreeView* view, GtkTreePath* path, GtkTreeViewColumn* column, gpointer data);
     static void on_play_clicked(GtkButton* button, gpointer data);
     static void on_pause_clicked(GtkButton* button, gpointer data);
     static void on_stop_clicked(GtkButton* button, gpointer data);
@@ -56,19 +142,71 @@ private:
     static void on_seek_changed(GtkRange* range, gpointer data);
     static gboolean on_window_close(GtkWidget* widget, gpointer data);
     static gboolean on_window_key_press(GtkWidget* widget, GdkEventKey* event, gpointer data);
-    static gboolean on_video_area_realize(GtkWidget* widget, gpointer data);
+    static gboolean on_window_key_release(GtkWidget* widget, GdkEventKey* event, gpointer data);
+    static gboolean on_seek_button_press(GtkWidget* widget, GdkEventButton* event, gpointer data);
+    static gboolean on_seek_button_release(GtkWidget* widget, GdkEventButton* event, gpointer data);
+    static gboolean on_seek_motion(GtkWidget* widget, GdkEventMotion* event, gpointer data);
+    static gboolean on_seek_leave(GtkWidget* widget, GdkEventCrossing* event, gpointer data);
+    static void on_video_area_realize(GtkWidget* widget, gpointer data);
+    static void on_video_area_size_allocate(GtkWidget* widget, GdkRectangle* allocation, gpointer data);
+    static void on_after_paint(GdkFrameClock* clock, gpointer data);
+    static gboolean on_window_map(GtkWidget* widget, GdkEvent* event, gpointer data);
     static gboolean bus_callback(GstBus* bus, GstMessage* msg, gpointer data);
-    static gboolean update_ui(gpointer data);
+    static void on_about_to_finish(GstElement* playbin, gpointer data);
+    static gboolean on_tick(GtkWidget* widget, GdkFrameClock* clock, gpointer data);
+    static gboolean on_window_state(GtkWidget* widget, GdkEventWindowState* event, gpointer data);
+    static gboolean on_stats_timer(gpointer data);
+    static gboolean on_overlay_timer(gpointer data);
+    static gboolean on_telemetry_timer(gpointer data);
     
     // Helper methods
     void load_file(const std::string& filename);
+    void scan_library();
+    bool forward_to_instance(const std::string& socket_path);
+    std::string handle_command(const std::string& command, const std::string& argument);
+    static gboolean on_quit_idle(gpointer data);
+    static gboolean on_quit_signal(gpointer data);
+    void start_load(const std::string& filename);
+    void switch_load(const std::string& filename, const std::string& location, GstElement* warm);
+    void attach_video_output();
+    void update_render_rectangle();
+    void report_startup();
+    void on_pipeline_loaded(const std::string& filename, PipelineLoadResult& result);
+    void on_gapless_transition();
+    bool play_next();
+    bool play_previous();
     void play();
     void pause();
     void stop();
     void set_volume(double volume);
     void seek(double position);
-    void update_time_display();
+    void finish_scrub(gint64 position);
+    void step_frame(int direction);
+    void step_back_decoded();
+    void finish_step(bool cache_hit);
+    gint64 leave_cached_frame();
+    void toggle_reverse();
+    void set_rate(double rate);
+    void toggle_loop();
+    void mark_loop_point(bool start);
+    void update_loop();
+    std::string loop_description();
+    void update_frame_caching();
+    void on_thumbnail_ready(gint64 position, ThumbnailPtr thumbnail);
+    void show_thumbnail(const ThumbnailPtr& thumbnail);
+    void update_position();
+    void update_time_display(gint64 position);
+    void reset_time_display();
+    void update_ticking();
+    void update_visualizer();
+    void open_subtitles();
+    void cycle_subtitles();
+    void apply_subtitles();
+    gint embedded_subtitle_count();
     void toggle_fullscreen();
+    void toggle_stats_overlay();
+    std::string overlay_text();
+    void write_telemetry();
     void cleanup();
     std::string format_time(gint64 nanoseconds);
 };
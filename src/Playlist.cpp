@@ -0,0 +1,132 @@
+#include "Playlist.hpp"
+#include <glib.h>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+
+namespace fs = std::filesystem;
+
+Playlist::Playlist() : index(0) {
+}
+
+bool Playlist::is_playlist_file(const std::string& path) {
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".m3u" || ext == ".m3u8";
+}
+
+// Network URIs (including HLS .m3u8) are items for playbin, not lists to read
+static bool is_network_uri(const std::string& location) {
+    gchar* scheme = g_uri_parse_scheme(location.c_str());
+    bool network = scheme && g_ascii_strcasecmp(scheme, "file") != 0;
+    g_free(scheme);
+    return network;
+}
+
+void Playlist::add(const std::string& path) {
+    if (is_playlist_file(path) && !is_network_uri(path)) {
+        load_m3u(path);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    items.push_back(path);
+}
+
+void Playlist::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    items.clear();
+    index = 0;
+}
+
+void Playlist::load_m3u(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Warning: Could not read playlist " << path << std::endl;
+        return;
+    }
+
+    fs::path base = fs::path(path).parent_path();
+    std::vector<std::string> entries;
+    std::string line;
+
+    while (std::getline(in, line)) {
+        // Trim whitespace and the CR of DOS line endings
+        size_t start = line.find_first_not_of(" \t\r");
+        size_t end = line.find_last_not_of(" \t\r");
+        if (start == std::string::npos) continue;
+        line = line.substr(start, end - start + 1);
+
+        // #EXTM3U, #EXTINF and other directives
+        if (line[0] == '#') continue;
+
+        if (line.rfind("file://", 0) == 0) {
+            gchar* filename = g_filename_from_uri(line.c_str(), nullptr, nullptr);
+            if (filename) {
+                entries.push_back(filename);
+                g_free(filename);
+            }
+        } else if (is_network_uri(line)) {
+            entries.push_back(line);
+        } else if (fs::path(line).is_relative()) {
+            entries.push_back((base / line).string());
+        } else {
+            entries.push_back(line);
+        }
+    }
+
+    std::cout << "Playlist " << path << ": " << entries.size() << " entries" << std::endl;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    items.insert(items.end(), entries.begin(), entries.end());
+}
+
+bool Playlist::empty() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return items.empty();
+}
+
+size_t Playlist::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return items.size();
+}
+
+size_t Playlist::position() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index;
+}
+
+std::string Playlist::current() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < items.size() ? items[index] : std::string();
+}
+
+std::string Playlist::peek_next() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index + 1 < items.size() ? items[index + 1] : std::string();
+}
+
+std::string Playlist::peek_previous() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index > 0 && index - 1 < items.size() ? items[index - 1] : std::string();
+}
+
+bool Playlist::advance() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index + 1 >= items.size()) {
+        return false;
+    }
+    index++;
+    return true;
+}
+
+bool Playlist::go_back() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index == 0) {
+        return false;
+    }
+    index--;
+    return true;
+}
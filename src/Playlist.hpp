@@ -0,0 +1,43 @@
+#ifndef PLAYLIST_HPP
+#define PLAYLIST_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+// Ordered list of files to play. Entries can come from the command line
+// or from M3U playlists. Reads are thread-safe because playbin asks for
+// the next item from its streaming thread (about-to-finish).
+class Playlist {
+public:
+    Playlist();
+
+    // Add a media file, or every entry of an .m3u / .m3u8 file
+    void add(const std::string& path);
+    void clear();
+
+    bool empty() const;
+    size_t size() const;
+    size_t position() const;
+
+    std::string current() const;
+
+    // Next entry without moving, empty at the end of the list
+    std::string peek_next() const;
+    std::string peek_previous() const;
+
+    // Move forward/back; false at either end
+    bool advance();
+    bool go_back();
+
+    static bool is_playlist_file(const std::string& path);
+
+private:
+    mutable std::mutex mutex;
+    std::vector<std::string> items;
+    size_t index;
+
+    void load_m3u(const std::string& path);
+};
+
+#endif // PLAYLIST_HPP
@@ -0,0 +1,359 @@
+#include "ProgressiveCache.hpp"
+#include "PipelineLoader.hpp"
+#include "Logger.hpp"
+#include <glib/gstdio.h>
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// GstPlayFlags of playbin (not in a public header)
+static const guint PLAY_FLAG_DOWNLOAD = 1 << 7;
+
+// queue2 temp files; queue2 deletes them itself when it stops
+static const char* const PARTIAL_PREFIX = "partial-";
+
+ProgressiveCache::ProgressiveCache(const std::string& dir)
+    : dir(dir), max_bytes(1024ULL * 1024 * 1024), pipeline(nullptr), download_complete(false),
+      finished_id(0) {
+}
+
+ProgressiveCache::~ProgressiveCache() {
+    detach();
+}
+
+std::string ProgressiveCache::default_dir() {
+    return (fs::path(g_get_user_cache_dir()) / "vidc" / "media").string();
+}
+
+std::string ProgressiveCache::cache_path(const std::string& for_uri) const {
+    gchar* hash = g_compute_checksum_for_string(G_CHECKSUM_SHA1, for_uri.c_str(), -1);
+    std::string path = (fs::path(dir) / (std::string(hash) + ".media")).string();
+    g_free(hash);
+    return path;
+}
+
+std::string ProgressiveCache::lookup(const std::string& for_uri) {
+    if (max_bytes == 0 || !PipelineLoader::is_remote(for_uri)) {
+        return "";
+    }
+
+    std::string path = cache_path(for_uri);
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec)) {
+        return "";
+    }
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);  // LRU
+    return path;
+}
+
+// queue2 only appears for network URIs, so the handler is harmless on a
+// pipeline that starts with a local file and may reach a remote one
+void ProgressiveCache::configure(GstElement* new_pipeline) const {
+    if (!g_object_class_find_property(G_OBJECT_GET_CLASS(new_pipeline), "uri")) {
+        return;
+    }
+    g_signal_connect(new_pipeline, "deep-element-added", G_CALLBACK(on_element_added),
+                     const_cast<ProgressiveCache*>(this));
+
+    gchar* pipeline_uri = nullptr;
+    g_object_get(new_pipeline, "uri", &pipeline_uri, nullptr);
+    if (pipeline_uri && PipelineLoader::is_remote(pipeline_uri)) {
+        set_network(new_pipeline);
+    }
+    g_free(pipeline_uri);
+}
+
+// playbin reads its flags when it builds the next item's source, after
+// about-to-finish returns
+void ProgressiveCache::configure_next(GstElement* playbin, const std::string& next_uri) const {
+    if (PipelineLoader::is_remote(next_uri)) {
+        set_network(playbin);
+    }
+}
+
+void ProgressiveCache::set_network(GstElement* playbin) const {
+    if (settings.buffer_size_kb > 0) {
+        g_object_set(playbin, "buffer-size", settings.buffer_size_kb * 1024, nullptr);
+    }
+    if (max_bytes > 0) {
+        g_mkdir_with_parents(dir.c_str(), 0700);
+        guint flags = 0;
+        g_object_get(playbin, "flags", &flags, nullptr);
+        g_object_set(playbin, "flags", flags | PLAY_FLAG_DOWNLOAD,
+                     "ring-buffer-max-size", max_bytes, nullptr);
+    }
+}
+
+void ProgressiveCache::on_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data) {
+    ProgressiveCache* cache = static_cast<ProgressiveCache*>(data);
+    GstElementFactory* factory = gst_element_get_factory(element);
+    if (!factory || strcmp(GST_OBJECT_NAME(factory), "queue2") != 0) {
+        return;
+    }
+
+    g_object_set(element,
+                 "low-watermark", cache->settings.low_watermark,
+                 "high-watermark", cache->settings.high_watermark, nullptr);
+
+    // Download into the cache dir, so commit() can hard-link the file
+    if (cache->max_bytes > 0) {
+        std::string temp_template = (fs::path(cache->dir) / (std::string(PARTIAL_PREFIX) + "XXXXXX")).string();
+        g_object_set(element, "temp-template", temp_template.c_str(), nullptr);
+    }
+}
+
+void ProgressiveCache::attach(GstElement* new_pipeline) {
+    detach();
+    if (!new_pipeline || !g_object_class_find_property(G_OBJECT_GET_CLASS(new_pipeline), "uri")) {
+        return;
+    }
+
+    gchar* pipeline_uri = nullptr;
+    g_object_get(new_pipeline, "uri", &pipeline_uri, nullptr);
+    if (pipeline_uri && PipelineLoader::is_remote(pipeline_uri) && max_bytes > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pipeline = GST_ELEMENT(gst_object_ref(new_pipeline));
+        uri = pipeline_uri;
+        download_complete = false;
+    }
+    g_free(pipeline_uri);
+}
+
+// The query and the copy run outside the lock, so finish() never waits on them
+void ProgressiveCache::detach() {
+    guint id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = finished_id;
+    }
+    if (id) {
+        g_source_remove(id);
+    }
+    commit_finished();
+
+    GstElement* followed;
+    std::string followed_uri;
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        followed = pipeline;
+        followed_uri = uri;
+        done = download_complete;
+        pipeline = nullptr;
+        uri.clear();
+        download_complete = false;
+    }
+    if (!followed) {
+        return;
+    }
+
+    // Finished without a BUFFERING message after the last range arrived
+    GstElement* queue = done ? nullptr : find_queue(followed);
+    if (queue) {
+        if (query_complete(queue)) {
+            commit(followed_uri, temp_location(queue));
+        }
+        gst_object_unref(queue);
+    }
+    gst_object_unref(followed);
+}
+
+void ProgressiveCache::finish() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!pipeline) {
+        return;
+    }
+
+    // Walking the bin touches no disk; the old queue2 keeps its temp file
+    // until the finished item has drained
+    GstElement* queue = download_complete ? nullptr : find_queue(pipeline);
+    if (queue) {
+        finished.push_back({uri, queue});
+        if (!finished_id) {
+            finished_id = g_idle_add(on_finished, this);
+        }
+    }
+
+    gst_object_unref(pipeline);
+    pipeline = nullptr;
+    uri.clear();
+    download_complete = false;
+}
+
+gboolean ProgressiveCache::on_finished(gpointer data) {
+    static_cast<ProgressiveCache*>(data)->commit_finished();
+    return G_SOURCE_REMOVE;
+}
+
+void ProgressiveCache::commit_finished() {
+    std::vector<Finished> items;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.swap(finished);
+        finished_id = 0;
+    }
+    for (Finished& item : items) {
+        if (query_complete(item.queue)) {
+            LOG_INFO(Net, "📦 Download complete: %s", item.uri.c_str());
+            commit(item.uri, temp_location(item.queue));
+        }
+        gst_object_unref(item.queue);
+    }
+}
+
+bool ProgressiveCache::complete() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return download_complete;
+}
+
+// Claims the commit under the lock, then does the query and the copy
+// outside it
+void ProgressiveCache::handle_message(GstMessage* msg) {
+    if (GST_MESSAGE_TYPE(msg) != GST_MESSAGE_BUFFERING) {
+        return;
+    }
+
+    // With ring-buffer-max-size set, queue2 reports TIMESHIFT rather than
+    // DOWNLOAD; query_complete() rules out a ring that has wrapped
+    GstBufferingMode mode;
+    gst_message_parse_buffering_stats(msg, &mode, nullptr, nullptr, nullptr);
+    if (mode != GST_BUFFERING_DOWNLOAD && mode != GST_BUFFERING_TIMESHIFT) {
+        return;
+    }
+
+    GstElement* followed;
+    std::string followed_uri;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!pipeline || download_complete) {
+            return;
+        }
+        followed = GST_ELEMENT(gst_object_ref(pipeline));
+        followed_uri = uri;
+    }
+
+    GstElement* queue = find_queue(followed);
+    if (queue && query_complete(queue)) {
+        bool claimed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            claimed = pipeline == followed && !download_complete;
+            if (claimed) {
+                download_complete = true;
+            }
+        }
+        if (claimed) {
+            LOG_INFO(Net, "📦 Download complete: %s", followed_uri.c_str());
+            commit(followed_uri, temp_location(queue));
+        }
+    }
+    if (queue) {
+        gst_object_unref(queue);
+    }
+    gst_object_unref(followed);
+}
+
+// The queue2 downloading the pipeline's URI, referenced, or nullptr
+GstElement* ProgressiveCache::find_queue(GstElement* bin) {
+    GstElement* queue = nullptr;
+    GstIterator* it = gst_bin_iterate_recurse(GST_BIN(bin));
+    GValue item = G_VALUE_INIT;
+    while (!queue && gst_iterator_next(it, &item) == GST_ITERATOR_OK) {
+        GstElement* element = GST_ELEMENT(g_value_get_object(&item));
+        GstElementFactory* factory = gst_element_get_factory(element);
+        if (factory && strcmp(GST_OBJECT_NAME(factory), "queue2") == 0) {
+            queue = GST_ELEMENT(gst_object_ref(element));
+        }
+        g_value_reset(&item);
+    }
+    g_value_unset(&item);
+    gst_iterator_free(it);
+    return queue;
+}
+
+// The file queue2 is downloading into, if any
+std::string ProgressiveCache::temp_location(GstElement* queue) {
+    std::string location;
+    gchar* temp = nullptr;
+    g_object_get(queue, "temp-location", &temp, nullptr);
+    if (temp) {
+        location = temp;
+        g_free(temp);
+    }
+    return location;
+}
+
+// One downloaded range covering the whole resource, without ring wrap-around
+bool ProgressiveCache::query_complete(GstElement* element) const {
+    GstQuery* query = gst_query_new_buffering(GST_FORMAT_BYTES);
+    bool complete = false;
+    if (gst_element_query(element, query)) {
+        GstFormat format;
+        gint64 start, stop, total;
+        gst_query_parse_buffering_range(query, &format, &start, &stop, &total);
+        gint64 range_start = 0, range_stop = 0;
+        complete = format == GST_FORMAT_BYTES && total > 0 && (guint64)total <= max_bytes &&
+                   gst_query_get_n_buffering_ranges(query) == 1 &&
+                   gst_query_parse_nth_buffering_range(query, 0, &range_start, &range_stop) &&
+                   range_start == 0 && range_stop >= total;
+    }
+    gst_query_unref(query);
+    return complete;
+}
+
+// Link the temp file while queue2 still has it: queue2 unlinks its own
+// name when it stops, and writes still buffered in it land in the same inode
+void ProgressiveCache::commit(const std::string& for_uri, const std::string& temp) {
+    if (temp.empty()) {
+        return;
+    }
+
+    std::string path = cache_path(for_uri);
+    g_remove(path.c_str());
+    if (link(temp.c_str(), path.c_str()) != 0) {
+        // queue2 may have used its own template on another filesystem
+        std::error_code ec;
+        fs::copy_file(temp, path, fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            LOG_WARNING(Net, "Could not cache %s: %s", for_uri.c_str(), ec.message().c_str());
+            return;
+        }
+    }
+
+    std::error_code ec;
+    LOG_INFO(Net, "📦 Cached %s (%" G_GUINT64_FORMAT " MB)", for_uri.c_str(), (guint64)(fs::file_size(path, ec) / (1024 * 1024)));
+    evict();
+}
+
+// Least recently used copies go first
+void ProgressiveCache::evict() {
+    struct Item {
+        fs::path path;
+        guint64 size;
+        fs::file_time_type time;
+    };
+    std::vector<Item> items;
+    guint64 total = 0;
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        if (entry.path().extension() == ".media") {
+            guint64 size = entry.file_size(ec);
+            items.push_back({entry.path(), size, entry.last_write_time(ec)});
+            total += size;
+        }
+    }
+
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.time < b.time; });
+    for (const Item& item : items) {
+        if (total <= max_bytes) {
+            break;
+        }
+        fs::remove(item.path, ec);
+        total -= item.size;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef PROGRESSIVE_CACHE_HPP
+#define PROGRESSIVE_CACHE_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <mutex>
+
+// Buffering of network streams
+struct BufferSettings {
+    int buffer_size_kb = 0;       // playbin buffer-size, 0 = GStreamer default
+    double low_watermark = 0.01;  // queue2 fill level that starts buffering (0..1)
+    double high_watermark = 0.99; // ... and that ends it
+};
+
+// On-disk cache for network media played through playbin's download
+// mode. queue2 writes the stream into a temp file in the cache directory
+// (a ring of at most max_bytes, so memory and disk stay bounded) and
+// serves seeks into ranges it already has from that file. A download
+// that completes is hard-linked as <sha1(uri)>.media; re-opening the URI
+// plays that file instead. Kept copies are evicted least recently used
+// first.
+class ProgressiveCache {
+public:
+    explicit ProgressiveCache(const std::string& dir = default_dir());
+    ~ProgressiveCache();
+
+    // 0 disables download mode (plain in-memory streaming buffer)
+    void set_max_bytes(guint64 bytes) { max_bytes = bytes; }
+    void set_buffering(const BufferSettings& new_settings) { settings = new_settings; }
+    const BufferSettings& buffering() const { return settings; }
+
+    // Complete local copy of uri, or empty; refreshes its LRU time
+    std::string lookup(const std::string& uri);
+
+    // Loader setup hook (worker thread, before PAUSED): download mode,
+    // buffer sizes and watermarks for playbin pipelines of network URIs
+    void configure(GstElement* pipeline) const;
+    // The same for the item a gapless switch queues next (about-to-finish,
+    // streaming thread), when the pipeline was set up for a local file
+    void configure_next(GstElement* playbin, const std::string& next_uri) const;
+
+    // Follow the download of the pipeline's URI (no-op for local files)
+    void attach(GstElement* pipeline);
+    // Main thread: keeps the download if it completed. Call before the
+    // pipeline stops, while it still plays that URI.
+    void detach();
+    // about-to-finish (streaming thread): stop following the download
+    // before the uri changes. Whether it completed is asked, and the copy
+    // kept, on the main loop, so the gapless switch never waits on disk.
+    void finish();
+
+    // BUFFERING messages: notices when the download has everything
+    void handle_message(GstMessage* msg);
+    bool complete() const;
+
+    static std::string default_dir();
+
+private:
+    std::string dir;
+    guint64 max_bytes;
+    BufferSettings settings;
+
+    // A download finish() handed over, checked on the main loop
+    struct Finished {
+        std::string uri;
+        GstElement* queue;  // Its queue2, referenced
+    };
+
+    // Guards the followed download: finish() runs on a streaming thread
+    mutable std::mutex mutex;
+    GstElement* pipeline;
+    std::string uri;
+    bool download_complete;
+    std::vector<Finished> finished;
+    guint finished_id;
+
+    void set_network(GstElement* playbin) const;
+    std::string cache_path(const std::string& uri) const;
+    bool query_complete(GstElement* element) const;
+    void commit(const std::string& for_uri, const std::string& temp);
+    void commit_finished();
+    void evict();
+
+    static GstElement* find_queue(GstElement* pipeline);
+    static std::string temp_location(GstElement* queue);
+    static gboolean on_finished(gpointer data);
+    static void on_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data);
+};
+
+#endif // PROGRESSIVE_CACHE_HPP
@@ -0,0 +1,146 @@
+#include "SeekScheduler.hpp"
+#include "Logger.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// A seek that never reports ASYNC_DONE (e.g. pipeline in READY) must not
+// block the queue forever
+static const gint64 SEEK_TIMEOUT_US = G_USEC_PER_SEC;
+
+// Latency samples kept for percentiles
+static const size_t MAX_LATENCY_SAMPLES = 256;
+
+SeekScheduler::SeekScheduler()
+    : pipeline(nullptr), keyframes(nullptr), loop(nullptr), seek_rate(1.0), in_flight(false),
+      in_flight_seqnum(GST_SEQNUM_INVALID), issued_at(0), batch_start(0),
+      in_flight_mode(Mode::Accurate), has_pending(false), pending_position(0),
+      pending_mode(Mode::Accurate), pending_since(0), last_target(-1),
+      last_latency(0), landed_keyframe(-1), requested(0), issued(0), indexed(0), skipped(0) {
+}
+
+void SeekScheduler::set_pipeline(GstElement* new_pipeline) {
+    pipeline = new_pipeline;
+    reset();
+}
+
+void SeekScheduler::reset() {
+    in_flight = false;
+    has_pending = false;
+    last_target = -1;
+    landed_keyframe = -1;
+}
+
+bool SeekScheduler::busy() const {
+    return in_flight || has_pending;
+}
+
+void SeekScheduler::request(gint64 position, Mode mode) {
+    if (!pipeline) {
+        return;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    requested++;
+    last_target = position;
+
+    if (!has_pending) {
+        pending_since = now;
+    }
+    has_pending = true;
+    pending_position = position;
+    pending_mode = mode;
+
+    if (in_flight && now - issued_at > SEEK_TIMEOUT_US) {
+        in_flight = false;
+    }
+
+    if (!in_flight) {
+        issue();
+    }
+}
+
+void SeekScheduler::issue() {
+    GstSeekFlags flags = GstSeekFlags(GST_SEEK_FLAG_FLUSH | PlaybackRate::flags(seek_rate));
+    if (pending_mode == Mode::Scrub) {
+        flags = GstSeekFlags(flags | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST);
+    } else {
+        flags = GstSeekFlags(flags | GST_SEEK_FLAG_ACCURATE);
+    }
+
+    has_pending = false;
+    bool looping = loop && loop->active();
+    gint64 position = pending_position;
+    KeyframeIndex::Entry entry;
+    // The index only knows keyframes, so accurate seeks never use it
+    bool indexed_seek = pending_mode == Mode::Scrub && seek_rate == 1.0 && !looping && keyframes &&
+                        keyframes->lookup(pending_position, entry);
+    if (indexed_seek) {
+        if (entry.timestamp == landed_keyframe) {
+            skipped++;  // That keyframe is what the last scrub seek shows
+            return;
+        }
+        position = entry.timestamp;
+    }
+
+    guint32 seqnum = GST_SEQNUM_INVALID;
+    bool sent;
+    if (looping) {
+        sent = loop->seek(pipeline, seek_rate, flags, position, &seqnum);
+    } else {
+        GstEvent* event = gst_event_new_seek(seek_rate, GST_FORMAT_TIME, flags, GST_SEEK_TYPE_SET,
+                                             position, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+        seqnum = gst_event_get_seqnum(event);
+        sent = gst_element_send_event(pipeline, event);
+    }
+    if (!sent) {
+        return;
+    }
+
+    landed_keyframe = indexed_seek ? position : -1;
+    if (indexed_seek) {
+        indexed++;
+    }
+
+    in_flight = true;
+    in_flight_seqnum = seqnum;
+    in_flight_mode = pending_mode;
+    issued_at = g_get_monotonic_time();
+    batch_start = pending_since;
+    issued++;
+}
+
+void SeekScheduler::on_async_done(GstMessage* msg) {
+    if (!in_flight || gst_message_get_seqnum(msg) != in_flight_seqnum) {
+        return;
+    }
+
+    in_flight = false;
+    double latency = (g_get_monotonic_time() - batch_start) / 1000.0;
+    record_latency(latency);
+
+    if (has_pending) {
+        // Only the newest target survives; everything in between was skipped
+        issue();
+    } else if (in_flight_mode == Mode::Accurate) {
+        LOG_INFO(Seek, "Seeked to: %" G_GINT64_FORMAT " seconds (%.2f ms, %" G_GUINT64_FORMAT
+                 " requests / %" G_GUINT64_FORMAT " seeks)",
+                 last_target / GST_SECOND, latency, requested, issued);
+    }
+}
+
+void SeekScheduler::record_latency(double ms) {
+    last_latency = ms;
+    latencies.push_back(ms);
+    if (latencies.size() > MAX_LATENCY_SAMPLES) {
+        latencies.pop_front();
+    }
+}
+
+double SeekScheduler::latency_percentile(double p) const {
+    if (latencies.empty()) return 0;
+    std::vector<double> sorted(latencies.begin(), latencies.end());
+    std::sort(sorted.begin(), sorted.end());
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
@@ -0,0 +1,92 @@
+#ifndef SEEK_SCHEDULER_HPP
+#define SEEK_SCHEDULER_HPP
+
+#include <gst/gst.h>
+#include <deque>
+#include "KeyframeIndex.hpp"
+#include "PlaybackRate.hpp"
+#include "LoopController.hpp"
+
+// Keeps at most one flushing seek in flight. Requests that arrive while
+// a seek is running are coalesced into a single pending target, which is
+// issued when the pipeline reports ASYNC_DONE for the running one.
+class SeekScheduler {
+public:
+    enum class Mode {
+        Scrub,     // KEY_UNIT | SNAP_NEAREST, used while dragging or key-repeating
+        Accurate   // ACCURATE, used for the final position
+    };
+
+    SeekScheduler();
+
+    // Pipeline is not owned; switching pipelines drops pending work
+    void set_pipeline(GstElement* pipeline);
+    void reset();
+
+    // With a ready index scrub seeks go to the indexed keyframe at or
+    // before the target, and a scrub whose keyframe is the one the last
+    // scrub seek landed on sends nothing: that frame is already showing.
+    // Accurate seeks stay seeks to the exact position.
+    void set_keyframe_index(const KeyframeIndex* index) { keyframes = index; landed_keyframe = -1; }
+
+    // While it has a loop set, seeks stay segment seeks inside the loop
+    // (and bypass the keyframe index)
+    void set_loop(const LoopController* controller) { loop = controller; }
+
+    // Speed the pipeline plays at after each seek (see PlaybackRate);
+    // seeks at other than 1x bypass the keyframe index
+    void set_rate(double new_rate) { seek_rate = new_rate; }
+    double rate() const { return seek_rate; }
+
+    void request(gint64 position, Mode mode);
+
+    // Forward GST_MESSAGE_ASYNC_DONE from the bus watch. Only the one
+    // carrying the running seek's seqnum completes it; others come from
+    // state changes or seeks made elsewhere.
+    void on_async_done(GstMessage* msg);
+
+    // A seek is in flight or waiting to be issued
+    bool busy() const;
+
+    // Most recently requested position, -1 before the first request
+    gint64 target() const { return last_target; }
+
+    // Seek-to-display latency: first coalesced request -> ASYNC_DONE
+    double last_latency_ms() const { return last_latency; }
+    double latency_percentile(double p) const;
+    guint64 requested_count() const { return requested; }
+    guint64 issued_count() const { return issued; }
+    guint64 indexed_count() const { return indexed; }
+    guint64 skipped_count() const { return skipped; }
+
+private:
+    GstElement* pipeline;
+    const KeyframeIndex* keyframes;
+    const LoopController* loop;
+    double seek_rate;
+
+    bool in_flight;
+    guint32 in_flight_seqnum;
+    gint64 issued_at;        // Monotonic time (us) the running seek was sent
+    gint64 batch_start;      // First request served by the running seek
+    Mode in_flight_mode;
+
+    bool has_pending;
+    gint64 pending_position;
+    Mode pending_mode;
+    gint64 pending_since;    // First request coalesced into the pending seek
+
+    gint64 last_target;
+    double last_latency;
+    gint64 landed_keyframe;  // Keyframe of the last seek if it was an indexed scrub, else -1
+    std::deque<double> latencies;  // Recent samples, ms
+    guint64 requested;
+    guint64 issued;
+    guint64 indexed;         // Seeks resolved through the keyframe index
+    guint64 skipped;         // Scrubs onto the keyframe already shown
+
+    void issue();
+    void record_latency(double ms);
+};
+
+#endif // SEEK_SCHEDULER_HPP
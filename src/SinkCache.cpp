@@ -0,0 +1,87 @@
+#include "SinkCache.hpp"
+#include "AtomicFile.hpp"
+#include <gst/gst.h>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <functional>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+SinkCache::SinkCache(const std::string& path) : path(path) {
+    read();
+}
+
+std::string SinkCache::default_path() {
+    return (fs::path(g_get_user_cache_dir()) / "vidc" / "sink-cache").string();
+}
+
+std::string SinkCache::lookup(const std::string& key) const {
+    auto it = entries.find(key);
+    return it != entries.end() ? it->second : std::string();
+}
+
+void SinkCache::store(const std::string& key, const std::string& config_name) {
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second == config_name) {
+        return;
+    }
+    entries[key] = config_name;
+    write();
+}
+
+void SinkCache::invalidate(const std::string& key) {
+    if (entries.erase(key)) {
+        write();
+    }
+}
+
+std::string SinkCache::make_key(const std::string& display_backend) {
+    // The registry only changes when plugins are installed or removed,
+    // so compute its fingerprint once per process
+    static const std::string fingerprint = registry_fingerprint();
+    return display_backend + "|" + fingerprint;
+}
+
+std::string SinkCache::registry_fingerprint() {
+    std::string plugins;
+    GList* list = gst_registry_get_plugin_list(gst_registry_get());
+    for (GList* l = list; l; l = l->next) {
+        GstPlugin* plugin = GST_PLUGIN(l->data);
+        plugins += gst_plugin_get_name(plugin);
+        plugins += '@';
+        plugins += gst_plugin_get_version(plugin);
+        plugins += ';';
+    }
+    gst_plugin_list_free(list);
+
+    gchar* version = gst_version_string();
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016zx", std::hash<std::string>{}(plugins));
+    std::string fingerprint = std::string(version) + "|" + hash;
+    g_free(version);
+    return fingerprint;
+}
+
+void SinkCache::read() {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t tab = line.find('\t');
+        if (tab != std::string::npos && tab > 0) {
+            entries[line.substr(0, tab)] = line.substr(tab + 1);
+        }
+    }
+}
+
+void SinkCache::write() const {
+    bool written = write_file_atomically(path, [this](std::ostream& out) {
+        for (const auto& entry : entries) {
+            out << entry.first << '\t' << entry.second << '\n';
+        }
+    });
+    if (!written) {
+        std::cerr << "Warning: Could not write sink cache " << path << std::endl;
+    }
+}
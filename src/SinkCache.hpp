@@ -0,0 +1,33 @@
+#ifndef SINK_CACHE_HPP
+#define SINK_CACHE_HPP
+
+#include <string>
+#include <map>
+
+// Remembers which pipeline config last prerolled on this machine, so
+// load_file can try it first instead of re-probing failing sinks.
+// Entries are keyed by display backend and GStreamer registry, and are
+// stored one per line ("key<TAB>config") in the user cache directory.
+class SinkCache {
+public:
+    explicit SinkCache(const std::string& path = default_path());
+
+    // Config name recorded for key, or empty if unknown
+    std::string lookup(const std::string& key) const;
+    void store(const std::string& key, const std::string& config_name);
+    void invalidate(const std::string& key);
+
+    // e.g. "GdkWaylandDisplay|1.22.6|3f09a1c2..."
+    static std::string make_key(const std::string& display_backend);
+    static std::string default_path();
+
+private:
+    std::string path;
+    std::map<std::string, std::string> entries;
+
+    void read();
+    void write() const;
+    static std::string registry_fingerprint();
+};
+
+#endif // SINK_CACHE_HPP
@@ -0,0 +1,367 @@
+#include "Spectrum.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPECTRUM_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SPECTRUM_NEON 1
+#endif
+
+// Scale shown by the bars: this many dB below full scale is empty
+static const float LEVEL_RANGE_DB = 70.0f;
+// Bars fall by at most this much per analysis (one per displayed frame)
+static const float LEVEL_FALL = 0.025f;
+static const float LOWEST_BAND_HZ = 40.0f;
+static const float HIGHEST_BAND_HZ = 16000.0f;
+
+// --- Scalar (reference and fallback) ---
+
+static void mix_stereo_scalar(const float* in, float* mono, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        mono[i] = (in[2 * i] + in[2 * i + 1]) * 0.5f;
+    }
+}
+
+static void apply_window_scalar(const float* in, const float* window, float* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = in[i] * window[i];
+    }
+}
+
+static void butterflies_scalar(float* re, float* im, const float* wr, const float* wi, size_t n, size_t half) {
+    for (size_t k = 0; k < n; k += 2 * half) {
+        for (size_t j = 0; j < half; j++) {
+            size_t a = k + j, b = a + half;
+            float tr = re[b] * wr[j] - im[b] * wi[j];
+            float ti = re[b] * wi[j] + im[b] * wr[j];
+            re[b] = re[a] - tr;
+            im[b] = im[a] - ti;
+            re[a] += tr;
+            im[a] += ti;
+        }
+    }
+}
+
+static void power_scalar(const float* re, const float* im, float* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = re[i] * re[i] + im[i] * im[i];
+    }
+}
+
+static const SpectrumKernels SCALAR_KERNELS = {
+    "scalar", 1, mix_stereo_scalar, apply_window_scalar, butterflies_scalar, power_scalar,
+};
+
+#ifdef SPECTRUM_X86
+
+// --- SSE2 (x86-64 baseline) ---
+
+static void mix_stereo_sse(const float* in, float* mono, size_t frames) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 a = _mm_loadu_ps(in + 2 * i);      // L0 R0 L1 R1
+        __m128 b = _mm_loadu_ps(in + 2 * i + 4);  // L2 R2 L3 R3
+        __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(mono + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    }
+    mix_stereo_scalar(in + 2 * i, mono + i, frames - i);
+}
+
+static void apply_window_sse(const float* in, const float* window, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(window + i)));
+    }
+    apply_window_scalar(in + i, window + i, out + i, n - i);
+}
+
+static void butterflies_sse(float* re, float* im, const float* wr, const float* wi, size_t n, size_t half) {
+    for (size_t k = 0; k < n; k += 2 * half) {
+        float* ra = re + k;
+        float* ia = im + k;
+        float* rb = ra + half;
+        float* ib = ia + half;
+        for (size_t j = 0; j < half; j += 4) {
+            __m128 w_re = _mm_loadu_ps(wr + j), w_im = _mm_loadu_ps(wi + j);
+            __m128 b_re = _mm_loadu_ps(rb + j), b_im = _mm_loadu_ps(ib + j);
+            __m128 a_re = _mm_loadu_ps(ra + j), a_im = _mm_loadu_ps(ia + j);
+            __m128 tr = _mm_sub_ps(_mm_mul_ps(b_re, w_re), _mm_mul_ps(b_im, w_im));
+            __m128 ti = _mm_add_ps(_mm_mul_ps(b_re, w_im), _mm_mul_ps(b_im, w_re));
+            _mm_storeu_ps(rb + j, _mm_sub_ps(a_re, tr));
+            _mm_storeu_ps(ib + j, _mm_sub_ps(a_im, ti));
+            _mm_storeu_ps(ra + j, _mm_add_ps(a_re, tr));
+            _mm_storeu_ps(ia + j, _mm_add_ps(a_im, ti));
+        }
+    }
+}
+
+static void power_sse(const float* re, const float* im, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 r = _mm_loadu_ps(re + i), m = _mm_loadu_ps(im + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m)));
+    }
+    power_scalar(re + i, im + i, out + i, n - i);
+}
+
+static const SpectrumKernels SSE_KERNELS = {
+    "sse2", 4, mix_stereo_sse, apply_window_sse, butterflies_sse, power_sse,
+};
+
+// --- AVX2 + FMA, compiled for it regardless of -march and picked at runtime ---
+// Tails stay inline: a tail call into SSE code would skip the vzeroupper
+// at return, and legacy SSE code (libm included) then pays for the dirty
+// upper register halves.
+
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+AVX2_TARGET static void mix_stereo_avx2(const float* in, float* mono, size_t frames) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        __m256 a = _mm256_loadu_ps(in + 2 * i);      // L0 R0 L1 R1 | L2 R2 L3 R3
+        __m256 b = _mm256_loadu_ps(in + 2 * i + 8);  // L4 R4 L5 R5 | L6 R6 L7 R7
+        // Per 128-bit lane: L0 L1 L4 L5 | L2 L3 L6 L7, then put the pairs in order
+        __m256 sum = _mm256_add_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                                   _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(mono + i, _mm256_mul_ps(sum, half));
+    }
+    for (; i < frames; i++) {
+        mono[i] = (in[2 * i] + in[2 * i + 1]) * 0.5f;
+    }
+}
+
+AVX2_TARGET static void apply_window_avx2(const float* in, const float* window, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(in + i), _mm256_loadu_ps(window + i)));
+    }
+    for (; i < n; i++) {
+        out[i] = in[i] * window[i];
+    }
+}
+
+AVX2_TARGET static void butterflies_avx2(float* re, float* im, const float* wr, const float* wi, size_t n, size_t half) {
+    for (size_t k = 0; k < n; k += 2 * half) {
+        float* ra = re + k;
+        float* ia = im + k;
+        float* rb = ra + half;
+        float* ib = ia + half;
+        for (size_t j = 0; j < half; j += 8) {
+            __m256 w_re = _mm256_loadu_ps(wr + j), w_im = _mm256_loadu_ps(wi + j);
+            __m256 b_re = _mm256_loadu_ps(rb + j), b_im = _mm256_loadu_ps(ib + j);
+            __m256 a_re = _mm256_loadu_ps(ra + j), a_im = _mm256_loadu_ps(ia + j);
+            __m256 tr = _mm256_fmsub_ps(b_re, w_re, _mm256_mul_ps(b_im, w_im));
+            __m256 ti = _mm256_fmadd_ps(b_re, w_im, _mm256_mul_ps(b_im, w_re));
+            _mm256_storeu_ps(rb + j, _mm256_sub_ps(a_re, tr));
+            _mm256_storeu_ps(ib + j, _mm256_sub_ps(a_im, ti));
+            _mm256_storeu_ps(ra + j, _mm256_add_ps(a_re, tr));
+            _mm256_storeu_ps(ia + j, _mm256_add_ps(a_im, ti));
+        }
+    }
+}
+
+AVX2_TARGET static void power_avx2(const float* re, const float* im, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 r = _mm256_loadu_ps(re + i), m = _mm256_loadu_ps(im + i);
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(r, r, _mm256_mul_ps(m, m)));
+    }
+    for (; i < n; i++) {
+        out[i] = re[i] * re[i] + im[i] * im[i];
+    }
+}
+
+static const SpectrumKernels AVX2_KERNELS = {
+    "avx2", 8, mix_stereo_avx2, apply_window_avx2, butterflies_avx2, power_avx2,
+};
+
+#endif // SPECTRUM_X86
+
+#ifdef SPECTRUM_NEON
+
+// --- NEON ---
+
+static void mix_stereo_neon(const float* in, float* mono, size_t frames) {
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t lr = vld2q_f32(in + 2 * i);  // Deinterleaves L and R
+        vst1q_f32(mono + i, vmulq_n_f32(vaddq_f32(lr.val[0], lr.val[1]), 0.5f));
+    }
+    mix_stereo_scalar(in + 2 * i, mono + i, frames - i);
+}
+
+static void apply_window_neon(const float* in, const float* window, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(in + i), vld1q_f32(window + i)));
+    }
+    apply_window_scalar(in + i, window + i, out + i, n - i);
+}
+
+static void butterflies_neon(float* re, float* im, const float* wr, const float* wi, size_t n, size_t half) {
+    for (size_t k = 0; k < n; k += 2 * half) {
+        float* ra = re + k;
+        float* ia = im + k;
+        float* rb = ra + half;
+        float* ib = ia + half;
+        for (size_t j = 0; j < half; j += 4) {
+            float32x4_t w_re = vld1q_f32(wr + j), w_im = vld1q_f32(wi + j);
+            float32x4_t b_re = vld1q_f32(rb + j), b_im = vld1q_f32(ib + j);
+            float32x4_t a_re = vld1q_f32(ra + j), a_im = vld1q_f32(ia + j);
+            float32x4_t tr = vmlsq_f32(vmulq_f32(b_re, w_re), b_im, w_im);
+            float32x4_t ti = vmlaq_f32(vmulq_f32(b_re, w_im), b_im, w_re);
+            vst1q_f32(rb + j, vsubq_f32(a_re, tr));
+            vst1q_f32(ib + j, vsubq_f32(a_im, ti));
+            vst1q_f32(ra + j, vaddq_f32(a_re, tr));
+            vst1q_f32(ia + j, vaddq_f32(a_im, ti));
+        }
+    }
+}
+
+static void power_neon(const float* re, const float* im, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t r = vld1q_f32(re + i), m = vld1q_f32(im + i);
+        vst1q_f32(out + i, vmlaq_f32(vmulq_f32(r, r), m, m));
+    }
+    power_scalar(re + i, im + i, out + i, n - i);
+}
+
+static const SpectrumKernels NEON_KERNELS = {
+    "neon", 4, mix_stereo_neon, apply_window_neon, butterflies_neon, power_neon,
+};
+
+#endif // SPECTRUM_NEON
+
+std::vector<const SpectrumKernels*> SpectrumKernels::available() {
+    std::vector<const SpectrumKernels*> tables = {&SCALAR_KERNELS};
+#ifdef SPECTRUM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        tables.push_back(&SSE_KERNELS);
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        tables.push_back(&AVX2_KERNELS);
+    }
+#endif
+#ifdef SPECTRUM_NEON
+    tables.push_back(&NEON_KERNELS);
+#endif
+    return tables;
+}
+
+const SpectrumKernels& SpectrumKernels::best() {
+    static const SpectrumKernels* chosen = [] {
+        const char* forced = getenv("VIDC_SIMD");
+        if (forced && strcmp(forced, "scalar") == 0) {
+            return &SCALAR_KERNELS;
+        }
+        return available().back();
+    }();
+    return *chosen;
+}
+
+Fft::Fft(size_t size, const SpectrumKernels& kernels)
+    : n(size), kernels(kernels), bit_reversed(size), twiddle_re(size), twiddle_im(size) {
+    size_t bits = 0;
+    while (((size_t)1 << bits) < n) {
+        bits++;
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t reversed = 0;
+        for (size_t b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        bit_reversed[i] = reversed;
+    }
+
+    // Each stage's twiddles are contiguous, so the butterflies load them as vectors
+    for (size_t half = 1; half < n; half *= 2) {
+        for (size_t j = 0; j < half; j++) {
+            double angle = -M_PI * j / half;
+            twiddle_re[half - 1 + j] = (float)cos(angle);
+            twiddle_im[half - 1 + j] = (float)sin(angle);
+        }
+    }
+}
+
+void Fft::transform(float* re, float* im) const {
+    for (size_t i = 0; i < n; i++) {
+        size_t j = bit_reversed[i];
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+
+    for (size_t half = 1; half < n; half *= 2) {
+        const float* wr = twiddle_re.data() + half - 1;
+        const float* wi = twiddle_im.data() + half - 1;
+        if (half < kernels.width) {
+            butterflies_scalar(re, im, wr, wi, n, half);
+        } else {
+            kernels.butterflies(re, im, wr, wi, n, half);
+        }
+    }
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer(size_t band_count, const SpectrumKernels& kernels)
+    : kernels(kernels), fft(FFT_SIZE, kernels), window(FFT_SIZE), re(FFT_SIZE), im(FFT_SIZE),
+      bins(FFT_SIZE / 2), band_levels(band_count, 0.0f), edges_rate(0) {
+    for (size_t i = 0; i < FFT_SIZE; i++) {
+        window[i] = (float)(0.5 - 0.5 * cos(2 * M_PI * i / (FFT_SIZE - 1)));  // Hann
+    }
+}
+
+void SpectrumAnalyzer::reset() {
+    std::fill(band_levels.begin(), band_levels.end(), 0.0f);
+}
+
+void SpectrumAnalyzer::compute_edges(int sample_rate) {
+    edges_rate = sample_rate;
+    size_t bands = band_levels.size();
+    band_edges.assign(bands + 1, 0);
+
+    float bin_hz = (float)sample_rate / FFT_SIZE;
+    float top = std::min(HIGHEST_BAND_HZ, sample_rate / 2.0f);
+    size_t previous = 1;  // Skip DC
+    for (size_t b = 0; b <= bands; b++) {
+        float hz = LOWEST_BAND_HZ * powf(top / LOWEST_BAND_HZ, (float)b / bands);
+        size_t bin = std::min(bins.size(), (size_t)(hz / bin_hz));
+        // Low bands are narrower than a bin; give each at least one
+        previous = b == 0 ? std::max<size_t>(1, bin) : std::max(bin, previous + 1);
+        band_edges[b] = std::min(previous, bins.size());
+    }
+}
+
+void SpectrumAnalyzer::analyze(const float* samples, int sample_rate) {
+    if (sample_rate != edges_rate) {
+        compute_edges(sample_rate);
+    }
+
+    kernels.apply_window(samples, window.data(), re.data(), FFT_SIZE);
+    std::fill(im.begin(), im.end(), 0.0f);
+    fft.transform(re.data(), im.data());
+    kernels.power(re.data(), im.data(), bins.data(), bins.size());
+
+    // A full-scale sine peaks at (N / 4)^2 through a Hann window
+    const float full_scale = (FFT_SIZE / 4.0f) * (FFT_SIZE / 4.0f);
+    for (size_t b = 0; b < band_levels.size(); b++) {
+        float peak = 0.0f;
+        for (size_t i = band_edges[b]; i < band_edges[b + 1]; i++) {
+            peak = std::max(peak, bins[i]);
+        }
+        float db = 10.0f * log10f(peak / full_scale + 1e-12f);
+        float level = std::clamp(1.0f + db / LEVEL_RANGE_DB, 0.0f, 1.0f);
+        band_levels[b] = std::max(level, band_levels[b] - LEVEL_FALL);
+    }
+}
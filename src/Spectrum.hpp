@@ -0,0 +1,71 @@
+#ifndef SPECTRUM_HPP
+#define SPECTRUM_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Inner loops of the audio visualiser, one table per instruction set.
+// All arrays are float and need no particular alignment.
+struct SpectrumKernels {
+    const char* name;
+    size_t width;  // Floats per vector; FFT stages narrower than this run scalar
+
+    // mono[i] = (in[2i] + in[2i+1]) / 2
+    void (*mix_stereo)(const float* in, float* mono, size_t frames);
+    // out[i] = in[i] * window[i]
+    void (*apply_window)(const float* in, const float* window, float* out, size_t n);
+    // One radix-2 stage over every block of 2 * half points (half >= width)
+    void (*butterflies)(float* re, float* im, const float* twiddle_re, const float* twiddle_im,
+                        size_t n, size_t half);
+    // out[i] = re[i]^2 + im[i]^2
+    void (*power)(const float* re, const float* im, float* out, size_t n);
+
+    // Fastest table this CPU supports (VIDC_SIMD=scalar forces the fallback)
+    static const SpectrumKernels& best();
+    // Every table this CPU supports, scalar first
+    static std::vector<const SpectrumKernels*> available();
+};
+
+// In-place radix-2 complex FFT on split real/imaginary arrays
+class Fft {
+public:
+    Fft(size_t size, const SpectrumKernels& kernels);
+
+    void transform(float* re, float* im) const;
+    size_t size() const { return n; }
+
+private:
+    size_t n;
+    const SpectrumKernels& kernels;
+    std::vector<size_t> bit_reversed;
+    std::vector<float> twiddle_re;  // Stage with half h uses [h - 1, 2h - 1)
+    std::vector<float> twiddle_im;
+};
+
+// Log-spaced band levels (0..1) of a mono block: Hann window, FFT, power
+// per bin, loudest bin per band on a 70 dB scale. Levels fall back
+// gradually between calls so the bars do not flicker.
+class SpectrumAnalyzer {
+public:
+    static const size_t FFT_SIZE = 2048;
+
+    explicit SpectrumAnalyzer(size_t band_count = 64, const SpectrumKernels& kernels = SpectrumKernels::best());
+
+    // FFT_SIZE samples
+    void analyze(const float* samples, int sample_rate);
+    const std::vector<float>& levels() const { return band_levels; }
+    void reset();
+
+private:
+    const SpectrumKernels& kernels;
+    Fft fft;
+    std::vector<float> window;
+    std::vector<float> re, im, bins;
+    std::vector<float> band_levels;
+    std::vector<size_t> band_edges;  // First bin of each band, plus the end
+    int edges_rate;                  // Sample rate band_edges were computed for
+
+    void compute_edges(int sample_rate);
+};
+
+#endif // SPECTRUM_HPP
@@ -0,0 +1,94 @@
+#include "StartupTimeline.hpp"
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <ctime>
+#include <unistd.h>
+
+namespace {
+
+struct Milestone {
+    std::string name;
+    gint64 time;  // Monotonic, us
+};
+
+std::mutex mutex;
+std::vector<Milestone> milestones;
+
+// Start time from /proc (clock ticks since boot) mapped onto the monotonic
+// clock; falls back to the first call when /proc is unavailable
+gint64 compute_process_start() {
+    gint64 now = g_get_monotonic_time();
+
+    std::ifstream in("/proc/self/stat");
+    std::string stat;
+    std::getline(in, stat);
+
+    // Fields after the parenthesised command name; starttime is field 22
+    size_t paren = stat.rfind(')');
+    struct timespec boot;
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    if (paren == std::string::npos || ticks_per_second <= 0 ||
+        clock_gettime(CLOCK_BOOTTIME, &boot) != 0) {
+        return now;
+    }
+
+    std::istringstream fields(stat.substr(paren + 2));
+    std::string field;
+    for (int i = 3; i <= 22 && fields >> field; i++) {
+    }
+    gint64 start_ticks = g_ascii_strtoll(field.c_str(), nullptr, 10);
+    gint64 age = (gint64)boot.tv_sec * G_USEC_PER_SEC + boot.tv_nsec / 1000 -
+                 start_ticks * G_USEC_PER_SEC / ticks_per_second;
+    if (age < 0 || age > 60 * G_USEC_PER_SEC) {
+        return now;
+    }
+    return now - age;
+}
+
+} // namespace
+
+gint64 StartupTimeline::process_start() {
+    static const gint64 start = compute_process_start();
+    return start;
+}
+
+void StartupTimeline::mark(const std::string& name) {
+    mark_at(name, g_get_monotonic_time());
+}
+
+void StartupTimeline::mark_at(const std::string& name, gint64 monotonic_us) {
+    process_start();  // Pin the origin before the first mark
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Milestone& milestone : milestones) {
+        if (milestone.name == name) {
+            return;
+        }
+    }
+    milestones.push_back({name, monotonic_us});
+}
+
+bool StartupTimeline::has(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::any_of(milestones.begin(), milestones.end(),
+                       [&name](const Milestone& milestone) { return milestone.name == name; });
+}
+
+std::string StartupTimeline::summary() {
+    std::vector<Milestone> sorted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sorted = milestones;
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Milestone& a, const Milestone& b) { return a.time < b.time; });
+
+    std::string text = "process start";
+    for (const Milestone& milestone : sorted) {
+        text += " → " + milestone.name + " " +
+                std::to_string((milestone.time - process_start()) / 1000) + " ms";
+    }
+    return text;
+}
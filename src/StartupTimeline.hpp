@@ -0,0 +1,24 @@
+#ifndef STARTUP_TIMELINE_HPP
+#define STARTUP_TIMELINE_HPP
+
+#include <glib.h>
+#include <string>
+
+// Process-wide startup milestones, measured from the moment the process
+// was exec'd (not from main), so dynamic loading and static
+// initialisation count too. Marks can come from any thread; the first
+// mark of a name wins.
+class StartupTimeline {
+public:
+    static void mark(const std::string& name);
+    static void mark_at(const std::string& name, gint64 monotonic_us);
+    static bool has(const std::string& name);
+
+    // Milestones in time order: "registry 85 ms → UI shown 140 ms → ..."
+    static std::string summary();
+
+    // g_get_monotonic_time() of process start
+    static gint64 process_start();
+};
+
+#endif // STARTUP_TIMELINE_HPP
@@ -0,0 +1,148 @@
+#include "SubtitleOverlay.hpp"
+#include <pango/pangocairo.h>
+#include <cmath>
+#include <algorithm>
+
+// Text height relative to the video, with a floor for small windows
+static const double FONT_SHARE = 0.05;
+static const double MIN_FONT_PX = 14;
+
+// Lines wrap at this share of the video width; the block sits this far
+// above the bottom edge (share of the video height)
+static const double WRAP_SHARE = 0.9;
+static const double MARGIN_SHARE = 0.05;
+
+// Outline width relative to the font size
+static const double OUTLINE_SHARE = 0.08;
+
+static const char* const FONT_FAMILY = "Sans Bold";
+
+// Files that are not UTF-8 are nearly always Windows-1252
+static const char* const FALLBACK_CHARSET = "WINDOWS-1252";
+
+SubtitleOverlay::SubtitleOverlay() : hits(0), misses(0) {
+}
+
+SubtitleOverlay::~SubtitleOverlay() {
+    flush_cache();
+}
+
+bool SubtitleOverlay::load(const std::string& path) {
+    flush_cache();
+    return subtitles.load(path);
+}
+
+void SubtitleOverlay::clear() {
+    flush_cache();
+    subtitles.clear();
+}
+
+void SubtitleOverlay::flush_cache() {
+    for (Bitmap& bitmap : cache) {
+        cairo_surface_destroy(bitmap.surface);
+    }
+    cache.clear();
+    cache_index.clear();
+}
+
+void SubtitleOverlay::draw(cairo_t* cr, double x, double y, double width, double height, int scale, GstClockTime position) {
+    if (!GST_CLOCK_TIME_IS_VALID(position) || subtitles.empty()) {
+        return;
+    }
+    subtitles.active((int64_t)position, showing);
+    if (showing.empty()) {
+        return;
+    }
+
+    double font_size = std::max(MIN_FONT_PX, std::round(height * FONT_SHARE));
+    const Bitmap& bitmap = lookup(std::floor(width * WRAP_SHARE), font_size, scale);
+
+    cairo_save(cr);
+    cairo_set_source_surface(cr, bitmap.surface,
+                             std::round(x + (width - bitmap.width) / 2),
+                             std::round(y + height * (1 - MARGIN_SHARE) - bitmap.height));
+    cairo_paint(cr);
+    cairo_restore(cr);
+}
+
+// Keyed by the cues on screen and everything that changes their pixels
+const SubtitleOverlay::Bitmap& SubtitleOverlay::lookup(double max_width, double font_size, int scale) {
+    std::string key;
+    for (size_t index : showing) {
+        key += std::to_string(index) + ',';
+    }
+    key += std::to_string((int)max_width) + 'x' + std::to_string((int)font_size) + '@' + std::to_string(scale);
+
+    auto found = cache_index.find(key);
+    if (found != cache_index.end()) {
+        hits++;
+        cache.splice(cache.begin(), cache, found->second);
+        return cache.front();
+    }
+
+    misses++;
+    std::string text;
+    for (size_t index : showing) {
+        text += (text.empty() ? "" : "\n") + subtitles.cue(index).text;
+    }
+    Bitmap bitmap = render(text, max_width, font_size, scale);
+    bitmap.key = key;
+    cache.push_front(bitmap);
+    cache_index[key] = cache.begin();
+
+    if (cache.size() > CACHE_ENTRIES) {
+        cairo_surface_destroy(cache.back().surface);
+        cache_index.erase(cache.back().key);
+        cache.pop_back();
+    }
+    return cache.front();
+}
+
+SubtitleOverlay::Bitmap SubtitleOverlay::render(const std::string& text, double max_width, double font_size, int scale) {
+    gchar* utf8 = g_utf8_validate(text.c_str(), -1, nullptr)
+        ? g_strdup(text.c_str())
+        : g_convert_with_fallback(text.c_str(), -1, "UTF-8", FALLBACK_CHARSET, "?", nullptr, nullptr, nullptr);
+
+    // Lay out on a scratch surface to learn the size
+    cairo_surface_t* scratch = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    cairo_t* measure = cairo_create(scratch);
+    PangoLayout* layout = pango_cairo_create_layout(measure);
+    PangoFontDescription* font = pango_font_description_from_string(FONT_FAMILY);
+    pango_font_description_set_absolute_size(font, font_size * PANGO_SCALE);
+    pango_layout_set_font_description(layout, font);
+    pango_font_description_free(font);
+    pango_layout_set_width(layout, (int)(max_width * PANGO_SCALE));
+    pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
+    pango_layout_set_alignment(layout, PANGO_ALIGN_CENTER);
+    pango_layout_set_text(layout, utf8 ? utf8 : "", -1);
+    g_free(utf8);
+
+    PangoRectangle extents;
+    pango_layout_get_pixel_extents(layout, nullptr, &extents);
+    double outline = std::max(1.0, font_size * OUTLINE_SHARE);
+
+    Bitmap bitmap;
+    bitmap.width = std::ceil(extents.width + 2 * outline);
+    bitmap.height = std::ceil(extents.height + 2 * outline);
+    bitmap.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int)bitmap.width * scale,
+                                                (int)bitmap.height * scale);
+    cairo_surface_set_device_scale(bitmap.surface, scale, scale);
+
+    // White text with a dark outline, readable on any picture
+    cairo_t* cr = cairo_create(bitmap.surface);
+    cairo_move_to(cr, outline - extents.x, outline - extents.y);
+    pango_cairo_update_layout(cr, layout);
+    pango_cairo_layout_path(cr, layout);
+    cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+    cairo_set_line_width(cr, 2 * outline);
+    cairo_set_source_rgba(cr, 0, 0, 0, 0.85);
+    cairo_stroke_preserve(cr);
+    cairo_set_source_rgb(cr, 1, 1, 1);
+    cairo_fill(cr);
+    cairo_destroy(cr);
+
+    g_object_unref(layout);
+    cairo_destroy(measure);
+    cairo_surface_destroy(scratch);
+    return bitmap;
+}
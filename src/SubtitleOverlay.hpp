@@ -0,0 +1,57 @@
+#ifndef SUBTITLE_OVERLAY_HPP
+#define SUBTITLE_OVERLAY_HPP
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include "SubtitleTrack.hpp"
+
+// Draws the cues of an external subtitle file over the in-tree
+// renderer's frames. Each set of cues on screen is laid out with Pango and
+// rasterised once per video size into an outlined ARGB surface. The
+// surfaces are kept in a small LRU, so a line that stays up for seconds
+// costs one blit per frame rather than a layout and a path fill.
+class SubtitleOverlay {
+public:
+    static const size_t CACHE_ENTRIES = 32;
+
+    SubtitleOverlay();
+    ~SubtitleOverlay();
+
+    // Replaces the current file; false (nothing shown) if unreadable
+    bool load(const std::string& path);
+    void clear();
+    bool loaded() const { return !subtitles.empty(); }
+    const SubtitleTrack& track() const { return subtitles; }
+
+    // Paint the cues showing at position (stream time) into the video
+    // rectangle; scale is the widget's device scale factor
+    void draw(cairo_t* cr, double x, double y, double width, double height, int scale, GstClockTime position);
+
+    guint64 cache_hits() const { return hits; }
+    guint64 cache_misses() const { return misses; }
+
+private:
+    struct Bitmap {
+        std::string key;
+        cairo_surface_t* surface;
+        double width, height;  // Logical pixels
+    };
+
+    SubtitleTrack subtitles;
+    std::vector<size_t> showing;
+    std::list<Bitmap> cache;  // Most recently used first
+    std::unordered_map<std::string, std::list<Bitmap>::iterator> cache_index;
+    guint64 hits;
+    guint64 misses;
+
+    const Bitmap& lookup(double max_width, double font_size, int scale);
+    void flush_cache();
+
+    static Bitmap render(const std::string& text, double max_width, double font_size, int scale);
+};
+
+#endif // SUBTITLE_OVERLAY_HPP
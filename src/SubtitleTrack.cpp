@@ -0,0 +1,490 @@
+#include "SubtitleTrack.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <cctype>
+
+namespace fs = std::filesystem;
+
+static const int64_t NS_PER_SECOND = 1000000000;
+
+static const char* const SUBTITLE_EXTENSIONS[] = {".srt", ".vtt", ".ass", ".ssa"};
+
+// ASS "Format:" of [Events] when a file has none
+static const char* const DEFAULT_ASS_FORMAT = "Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text";
+
+namespace {
+
+// Lines of a buffer without copying; strips the '\r' of CRLF files
+struct LineReader {
+    std::string_view data;
+    size_t pos = 0;
+
+    bool next(std::string_view& line) {
+        if (pos >= data.size()) {
+            return false;
+        }
+        size_t end = data.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = data.size();
+        }
+        line = data.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        pos = end + 1;
+        return true;
+    }
+};
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace((unsigned char)text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace((unsigned char)text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool starts_with(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+// [h:]mm:ss[.,]fraction from pos: SRT 00:01:02,500, WebVTT 01:02.500,
+// ASS 0:01:02.50
+bool parse_time(std::string_view text, size_t& pos, int64_t& time) {
+    while (pos < text.size() && text[pos] == ' ') {
+        pos++;
+    }
+
+    int64_t fields[3];
+    int count = 0;
+    while (count < 3) {
+        size_t start = pos;
+        int64_t value = 0;
+        while (pos < text.size() && std::isdigit((unsigned char)text[pos])) {
+            value = value * 10 + (text[pos++] - '0');
+        }
+        if (pos == start) {
+            return false;
+        }
+        fields[count++] = value;
+        if (pos < text.size() && text[pos] == ':') {
+            pos++;
+        } else {
+            break;
+        }
+    }
+    if (count < 2) {
+        return false;
+    }
+
+    int64_t fraction = 0;
+    if (pos < text.size() && (text[pos] == '.' || text[pos] == ',')) {
+        pos++;
+        int64_t scale = NS_PER_SECOND;
+        while (pos < text.size() && std::isdigit((unsigned char)text[pos])) {
+            scale /= 10;
+            fraction += (text[pos++] - '0') * scale;
+        }
+    }
+
+    int64_t hours = count == 3 ? fields[0] : 0;
+    int64_t minutes = fields[count - 2];
+    int64_t seconds = fields[count - 1];
+    time = ((hours * 60 + minutes) * 60 + seconds) * NS_PER_SECOND + fraction;
+    return true;
+}
+
+// "start --> end [settings]"
+bool parse_timing(std::string_view line, int64_t& start, int64_t& end) {
+    size_t arrow = line.find("-->");
+    if (arrow == std::string_view::npos) {
+        return false;
+    }
+    size_t pos = 0;
+    if (!parse_time(line.substr(0, arrow), pos, start)) {
+        return false;
+    }
+    pos = arrow + 3;
+    return parse_time(line, pos, end);
+}
+
+// Drops <i>, <c.yellow>, <v Speaker> and {\an8} style markup and decodes
+// the entities WebVTT requires
+void append_plain(std::string& out, std::string_view line) {
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (c == '<' || (c == '{' && i + 1 < line.size() && line[i + 1] == '\\')) {
+            size_t close = line.find(c == '<' ? '>' : '}', i);
+            if (close != std::string_view::npos) {
+                i = close;
+                continue;
+            }
+        }
+        if (c == '&') {
+            static const std::pair<std::string_view, char> entities[] = {
+                {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&nbsp;", ' '}};
+            bool decoded = false;
+            for (const auto& entity : entities) {
+                if (line.substr(i, entity.first.size()) == entity.first) {
+                    out += entity.second;
+                    i += entity.first.size() - 1;
+                    decoded = true;
+                    break;
+                }
+            }
+            if (decoded) {
+                continue;
+            }
+        }
+        out += c;
+    }
+}
+
+// ASS dialogue text: override blocks {...} dropped, \N and \n are line
+// breaks, \h a hard space
+std::string ass_plain(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c == '{') {
+            size_t close = text.find('}', i);
+            if (close != std::string_view::npos) {
+                i = close;
+                continue;
+            }
+        }
+        if (c == '\\' && i + 1 < text.size()) {
+            char escape = text[i + 1];
+            if (escape == 'N' || escape == 'n') {
+                out += '\n';
+                i++;
+                continue;
+            }
+            if (escape == 'h') {
+                out += ' ';
+                i++;
+                continue;
+            }
+        }
+        out += c;
+    }
+    return out;
+}
+
+std::string lowercase_extension(const std::string& path) {
+    std::string extension = fs::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return extension;
+}
+
+}  // namespace
+
+bool SubtitleTrack::is_subtitle_file(const std::string& path) {
+    std::string extension = lowercase_extension(path);
+    for (const char* candidate : SUBTITLE_EXTENSIONS) {
+        if (extension == candidate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SubtitleTrack::Format SubtitleTrack::detect(const std::string& path, const std::string& data) {
+    std::string extension = lowercase_extension(path);
+    if (extension == ".srt") {
+        return Format::Srt;
+    }
+    if (extension == ".vtt") {
+        return Format::WebVtt;
+    }
+    if (extension == ".ass" || extension == ".ssa") {
+        return Format::Ass;
+    }
+
+    std::string_view head = std::string_view(data).substr(0, 4096);
+    if (starts_with(head, "WEBVTT")) {
+        return Format::WebVtt;
+    }
+    if (head.find("[Script Info]") != std::string_view::npos || head.find("[Events]") != std::string_view::npos) {
+        return Format::Ass;
+    }
+    if (head.find("-->") != std::string_view::npos) {
+        return Format::Srt;
+    }
+    return Format::Unknown;
+}
+
+std::vector<std::string> SubtitleTrack::find_sidecars(const std::string& media_path) {
+    std::vector<std::string> exact, tagged;
+    fs::path media(media_path);
+    std::string stem = media.stem().string() + ".";
+    std::error_code ec;
+    fs::directory_iterator entries(media.parent_path().empty() ? fs::path(".") : media.parent_path(), ec);
+    if (ec) {
+        return {};
+    }
+
+    for (const fs::directory_entry& entry : entries) {
+        std::string name = entry.path().filename().string();
+        if (!starts_with(name, stem) || !is_subtitle_file(name) || !entry.is_regular_file(ec)) {
+            continue;
+        }
+        // movie.srt, or movie.en.srt: one tag without further dots
+        std::string middle = entry.path().stem().string().substr(stem.size() - 1);
+        if (middle.empty()) {
+            exact.push_back(entry.path().string());
+        } else if (middle.find('.', 1) == std::string::npos) {
+            tagged.push_back(entry.path().string());
+        }
+    }
+
+    std::sort(exact.begin(), exact.end());
+    std::sort(tagged.begin(), tagged.end());
+    exact.insert(exact.end(), tagged.begin(), tagged.end());
+    return exact;
+}
+
+bool SubtitleTrack::load(const std::string& path) {
+    clear();
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::string data;
+    in.seekg(0, std::ios::end);
+    data.resize((size_t)std::max<std::streamoff>(0, in.tellg()));
+    in.seekg(0);
+    in.read(&data[0], data.size());
+    data.resize((size_t)in.gcount());
+
+    // UTF-8 byte order mark
+    if (starts_with(data, "\xEF\xBB\xBF")) {
+        data.erase(0, 3);
+    }
+    if (!parse(data, detect(path, data))) {
+        return false;
+    }
+    source_path = path;
+    return true;
+}
+
+bool SubtitleTrack::parse(const std::string& data, Format format) {
+    clear();
+    if (format == Format::Ass) {
+        parse_ass(data);
+    } else if (format != Format::Unknown) {
+        parse_timed_blocks(data);
+    }
+    build_index();
+    return !cues.empty();
+}
+
+void SubtitleTrack::clear() {
+    cues.clear();
+    nodes.clear();
+    by_start.clear();
+    by_end.clear();
+    source_path.clear();
+}
+
+// SRT and WebVTT share the shape: an optional identifier line, a timing
+// line, then text up to a blank line. Header, NOTE and STYLE blocks have
+// no timing line and are skipped with it.
+void SubtitleTrack::parse_timed_blocks(const std::string& data) {
+    // About 60 bytes per cue in typical files
+    cues.reserve(data.size() / 60);
+
+    LineReader lines{data};
+    std::string_view line;
+    SubtitleCue* current = nullptr;
+    while (lines.next(line)) {
+        int64_t start, end;
+        if (trim(line).empty()) {
+            current = nullptr;
+        } else if (line.find("-->") != std::string_view::npos && parse_timing(line, start, end)) {
+            // A missing blank line: the previous cue took the next one's number
+            if (current) {
+                size_t last_line = current->text.rfind('\n');
+                std::string_view tail = std::string_view(current->text).substr(
+                    last_line == std::string::npos ? 0 : last_line + 1);
+                if (!tail.empty() && std::all_of(tail.begin(), tail.end(), [](unsigned char c) { return std::isdigit(c); })) {
+                    current->text.erase(last_line == std::string::npos ? 0 : last_line);
+                }
+            }
+            cues.push_back({start, end, std::string()});
+            current = &cues.back();
+        } else if (current) {
+            if (!current->text.empty()) {
+                current->text += '\n';
+            }
+            append_plain(current->text, line);
+        }
+    }
+}
+
+void SubtitleTrack::parse_ass(const std::string& data) {
+    LineReader lines{data};
+    std::string_view line;
+    bool in_events = false;
+    int start_field = -1, end_field = -1, text_field = -1, field_count = 0;
+
+    auto set_format = [&](std::string_view spec) {
+        start_field = end_field = text_field = -1;
+        field_count = 0;
+        size_t pos = 0;
+        while (pos <= spec.size()) {
+            size_t comma = spec.find(',', pos);
+            std::string_view name = trim(spec.substr(pos, comma == std::string_view::npos ? std::string_view::npos
+                                                                                         : comma - pos));
+            if (name == "Start") {
+                start_field = field_count;
+            } else if (name == "End") {
+                end_field = field_count;
+            } else if (name == "Text") {
+                text_field = field_count;
+            }
+            field_count++;
+            if (comma == std::string_view::npos) {
+                break;
+            }
+            pos = comma + 1;
+        }
+    };
+    set_format(DEFAULT_ASS_FORMAT);
+
+    while (lines.next(line)) {
+        std::string_view trimmed = trim(line);
+        if (!trimmed.empty() && trimmed.front() == '[') {
+            in_events = trimmed == "[Events]";
+            continue;
+        }
+        if (!in_events) {
+            continue;
+        }
+        if (starts_with(trimmed, "Format:")) {
+            set_format(trimmed.substr(7));
+            continue;
+        }
+        // Text is the last field and may itself contain commas
+        if (!starts_with(trimmed, "Dialogue:") || text_field != field_count - 1 || start_field < 0 || end_field < 0) {
+            continue;
+        }
+
+        std::string_view fields = trimmed.substr(9);
+        int64_t start = -1, end = -1;
+        size_t pos = 0;
+        for (int field = 0; field < field_count - 1; field++) {
+            size_t comma = fields.find(',', pos);
+            if (comma == std::string_view::npos) {
+                pos = std::string_view::npos;
+                break;
+            }
+            std::string_view value = fields.substr(pos, comma - pos);
+            size_t time_pos = 0;
+            if (field == start_field) {
+                parse_time(value, time_pos, start);
+            } else if (field == end_field) {
+                parse_time(value, time_pos, end);
+            }
+            pos = comma + 1;
+        }
+        if (pos == std::string_view::npos || start < 0 || end < 0) {
+            continue;
+        }
+        cues.push_back({start, end, ass_plain(fields.substr(pos))});
+    }
+}
+
+void SubtitleTrack::build_index() {
+    // Zero-length and empty cues never show
+    cues.erase(std::remove_if(cues.begin(), cues.end(), [](const SubtitleCue& cue) {
+        return cue.end <= cue.start || trim(cue.text).empty();
+    }), cues.end());
+
+    // Most files are in order already; ASS files are often sorted by layer or style
+    auto starts_first = [](const SubtitleCue& a, const SubtitleCue& b) { return a.start < b.start; };
+    if (!std::is_sorted(cues.begin(), cues.end(), starts_first)) {
+        std::stable_sort(cues.begin(), cues.end(), starts_first);
+    }
+
+    nodes.clear();
+    by_start.clear();
+    by_end.clear();
+    by_start.reserve(cues.size());
+    by_end.reserve(cues.size());
+    std::vector<uint32_t> indices(cues.size());
+    for (size_t i = 0; i < cues.size(); i++) {
+        indices[i] = (uint32_t)i;
+    }
+    std::vector<uint32_t> scratch(cues.size());
+    build_node(indices.data(), indices.data() + indices.size(), scratch.data());
+}
+
+// [first, last) are cue indices in start order. The center is the median
+// cue's start, so that cue stays in the node and each child gets at most
+// half the rest. The range is reordered into the left child's cues, then
+// the right child's; scratch holds the right ones meanwhile.
+int32_t SubtitleTrack::build_node(uint32_t* first, uint32_t* last, uint32_t* scratch) {
+    if (first == last) {
+        return -1;
+    }
+
+    int64_t center = cues[first[(last - first) / 2]].start;
+    uint32_t* before_end = first;
+    uint32_t* after_end = scratch;
+    size_t spanning = by_start.size();
+    for (uint32_t* it = first; it != last; ++it) {
+        if (cues[*it].end <= center) {
+            *before_end++ = *it;
+        } else if (cues[*it].start > center) {
+            *after_end++ = *it;
+        } else {
+            by_start.push_back(*it);
+        }
+    }
+    uint32_t* after_begin = before_end;
+    uint32_t* after_last = std::copy(scratch, after_end, after_begin);
+
+    by_end.insert(by_end.end(), by_start.begin() + spanning, by_start.end());
+    std::stable_sort(by_end.begin() + spanning, by_end.end(),
+                     [this](uint32_t a, uint32_t b) { return cues[a].end > cues[b].end; });
+
+    int32_t id = (int32_t)nodes.size();
+    nodes.push_back({center, -1, -1, (uint32_t)spanning, (uint32_t)(by_start.size() - spanning)});
+    int32_t left = build_node(first, before_end, scratch);
+    int32_t right = build_node(after_begin, after_last, scratch);
+    nodes[id].left = left;
+    nodes[id].right = right;
+    return id;
+}
+
+void SubtitleTrack::active(int64_t time, std::vector<size_t>& out) const {
+    out.clear();
+    int32_t id = nodes.empty() ? -1 : 0;
+    while (id >= 0) {
+        const Node& node = nodes[id];
+        const uint32_t* first_start = &by_start[node.first];
+        const uint32_t* first_end = &by_end[node.first];
+
+        // Every cue here runs past center: before it, the ones already
+        // started are showing; from it on, the ones not yet ended are
+        if (time < node.center) {
+            for (uint32_t i = 0; i < node.count && cues[first_start[i]].start <= time; i++) {
+                out.push_back(first_start[i]);
+            }
+            id = node.left;
+        } else {
+            for (uint32_t i = 0; i < node.count && cues[first_end[i]].end > time; i++) {
+                out.push_back(first_end[i]);
+            }
+            id = node.right;
+        }
+    }
+    std::sort(out.begin(), out.end());
+}
@@ -0,0 +1,70 @@
+#ifndef SUBTITLE_TRACK_HPP
+#define SUBTITLE_TRACK_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One timed line of text; times in nanoseconds, end exclusive
+struct SubtitleCue {
+    int64_t start;
+    int64_t end;
+    std::string text;  // Plain text, lines separated by '\n'
+};
+
+// External subtitle file (SRT, WebVTT, ASS/SSA) parsed once into a cue
+// table sorted by start time, indexed by a centered interval tree. Each
+// node holds the cues spanning its center time, sorted by start and by
+// end; cues entirely before or after it go to its children. A lookup
+// walks one root-to-leaf path and reads only cues that are showing, so it
+// costs O(log n + k) for k cues on screen, however long some cues run
+// (a sign language track, a logo, a cue left open to the end).
+class SubtitleTrack {
+public:
+    enum class Format { Unknown, Srt, WebVtt, Ass };
+
+    // Replaces the current cues; false (and empty) if the file cannot be
+    // read or has no cues
+    bool load(const std::string& path);
+    bool parse(const std::string& data, Format format);
+    void clear();
+
+    // By extension, then by content for files named otherwise
+    static Format detect(const std::string& path, const std::string& data);
+    static bool is_subtitle_file(const std::string& path);
+
+    // Sidecars of a media file: same stem plus a subtitle extension,
+    // optionally with a language tag between (movie.en.srt). Exact
+    // matches first.
+    static std::vector<std::string> find_sidecars(const std::string& media_path);
+
+    bool empty() const { return cues.empty(); }
+    size_t size() const { return cues.size(); }
+    const SubtitleCue& cue(size_t index) const { return cues[index]; }
+    const std::string& path() const { return source_path; }
+
+    // Indices of the cues showing at time, in start order
+    void active(int64_t time, std::vector<size_t>& out) const;
+
+private:
+    // Cues spanning center are by_start[first, first + count) and
+    // by_end[first, first + count); children are node indices or -1
+    struct Node {
+        int64_t center;
+        int32_t left, right;
+        uint32_t first, count;
+    };
+
+    std::vector<SubtitleCue> cues;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> by_start;  // Cue indices, ascending start per node
+    std::vector<uint32_t> by_end;    // Cue indices, descending end per node
+    std::string source_path;
+
+    void parse_timed_blocks(const std::string& data);  // SRT and WebVTT
+    void parse_ass(const std::string& data);
+    void build_index();
+    int32_t build_node(uint32_t* first, uint32_t* last, uint32_t* scratch);
+};
+
+#endif // SUBTITLE_TRACK_HPP
@@ -0,0 +1,365 @@
+#include "Telemetry.hpp"
+#include "MemoryBudget.hpp"
+#include "Logger.hpp"
+#include "JsonEscape.hpp"
+#include <gst/base/gstbasesink.h>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Decoders that lose buffers (e.g. on flush) must not grow the table
+static const size_t MAX_PENDING_FRAMES = 512;
+
+static double to_ms(GstClockTime time) {
+    return GST_CLOCK_TIME_IS_VALID(time) ? (double)time / GST_MSECOND : -1;
+}
+
+const std::vector<double>& Telemetry::Histogram::bounds() {
+    // Roughly doubling, with the 60/30/15 fps frame durations as edges
+    static const std::vector<double> edges = {1, 2, 4, 8, 16.7, 33.3, 66.7, 133, 266, 533};
+    return edges;
+}
+
+void Telemetry::Histogram::add(double ms) {
+    const auto& edges = bounds();
+    size_t bucket = std::lower_bound(edges.begin(), edges.end(), ms) - edges.begin();
+    counts[bucket]++;
+    total++;
+}
+
+double Telemetry::Histogram::percentile(double p) const {
+    if (total == 0) return 0;
+    guint64 rank = (guint64)std::ceil(p * total);
+    guint64 seen = 0;
+    const auto& edges = bounds();
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // Overflow bucket has no upper bound; report the last edge
+            return i < edges.size() ? edges[i] : edges.back();
+        }
+    }
+    return edges.back();
+}
+
+std::string Telemetry::Histogram::to_json() const {
+    std::ostringstream out;
+    out << "{\"count\": " << total << ", \"p50\": " << percentile(0.5)
+        << ", \"p99\": " << percentile(0.99) << ", \"buckets\": [";
+    for (size_t i = 0; i < counts.size(); i++) {
+        out << (i ? ", " : "") << counts[i];
+    }
+    out << "]}";
+    return out.str();
+}
+
+Telemetry::Telemetry()
+    : pipeline(nullptr), video_sink(nullptr), element_added_id(0), attach_time(0),
+      latency_min(GST_CLOCK_TIME_NONE), latency_max(GST_CLOCK_TIME_NONE),
+      buffering(100), buffering_min(100), buffering_events(0), warnings(0) {
+}
+
+Telemetry::~Telemetry() {
+    detach();
+}
+
+void Telemetry::attach(GstElement* new_pipeline, GstElement* new_video_sink) {
+    detach();
+    if (!new_pipeline) {
+        return;
+    }
+
+    pipeline = GST_ELEMENT(gst_object_ref(new_pipeline));
+    video_sink = find_base_sink(new_video_sink);
+    attach_time = g_get_monotonic_time();
+
+    qos.clear();
+    latency_min = latency_max = GST_CLOCK_TIME_NONE;
+    buffering = buffering_min = 100;
+    buffering_events = 0;
+    warnings = 0;
+    last_warning.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decoder_entry.clear();
+        decoder_latency = Histogram();
+    }
+
+    // Decoders of a prerolled pipeline already exist; later ones (gapless
+    // items, renegotiation) are picked up as they are added
+    element_added_id = g_signal_connect(pipeline, "deep-element-added", G_CALLBACK(on_element_added), this);
+
+    GstIterator* it = gst_bin_iterate_recurse(GST_BIN(pipeline));
+    GValue item = G_VALUE_INIT;
+    while (gst_iterator_next(it, &item) == GST_ITERATOR_OK) {
+        hook_decoder(GST_ELEMENT(g_value_get_object(&item)));
+        g_value_reset(&item);
+    }
+    g_value_unset(&item);
+    gst_iterator_free(it);
+}
+
+void Telemetry::detach() {
+    if (pipeline && element_added_id) {
+        g_signal_handler_disconnect(pipeline, element_added_id);
+        element_added_id = 0;
+    }
+
+    std::vector<Probe> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        removed.swap(probes);
+        decoder_entry.clear();
+    }
+    for (const Probe& probe : removed) {
+        gst_pad_remove_probe(probe.pad, probe.id);
+        gst_object_unref(probe.pad);
+    }
+
+    if (video_sink) {
+        gst_object_unref(video_sink);
+        video_sink = nullptr;
+    }
+    if (pipeline) {
+        gst_object_unref(pipeline);
+        pipeline = nullptr;
+    }
+}
+
+GstElement* Telemetry::find_base_sink(GstElement* sink) {
+    if (!sink) {
+        return nullptr;
+    }
+    if (GST_IS_BASE_SINK(sink)) {
+        return GST_ELEMENT(gst_object_ref(sink));
+    }
+    if (!GST_IS_BIN(sink)) {
+        return nullptr;
+    }
+
+    // playbin hands out sink bins (e.g. convert ! appsink)
+    GstElement* found = nullptr;
+    GstIterator* it = gst_bin_iterate_recurse(GST_BIN(sink));
+    GValue item = G_VALUE_INIT;
+    while (!found && gst_iterator_next(it, &item) == GST_ITERATOR_OK) {
+        GstElement* element = GST_ELEMENT(g_value_get_object(&item));
+        if (GST_IS_BASE_SINK(element)) {
+            found = GST_ELEMENT(gst_object_ref(element));
+        }
+        g_value_reset(&item);
+    }
+    g_value_unset(&item);
+    gst_iterator_free(it);
+    return found;
+}
+
+void Telemetry::hook_decoder(GstElement* element) {
+    GstElementFactory* factory = gst_element_get_factory(element);
+    if (!factory) {
+        return;
+    }
+    const gchar* klass = gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS);
+    if (!klass || !strstr(klass, "Decoder") || !strstr(klass, "Video")) {
+        return;
+    }
+
+    GstPad* sink_pad = gst_element_get_static_pad(element, "sink");
+    GstPad* src_pad = gst_element_get_static_pad(element, "src");
+    if (!sink_pad || !src_pad) {
+        if (sink_pad) gst_object_unref(sink_pad);
+        if (src_pad) gst_object_unref(src_pad);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    probes.push_back({sink_pad, gst_pad_add_probe(sink_pad, GST_PAD_PROBE_TYPE_BUFFER,
+                                                  on_decoder_input, this, nullptr)});
+    probes.push_back({src_pad, gst_pad_add_probe(src_pad, GST_PAD_PROBE_TYPE_BUFFER,
+                                                 on_decoder_output, this, nullptr)});
+}
+
+void Telemetry::on_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data) {
+    static_cast<Telemetry*>(data)->hook_decoder(element);
+}
+
+// Decoder latency: compressed buffer in -> decoded frame with the same PTS
+// out. This includes the time a frame waits in the decoder's reorder and
+// thread queues, not just the work spent on it.
+GstPadProbeReturn Telemetry::on_decoder_input(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    Telemetry* telemetry = static_cast<Telemetry*>(data);
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!GST_BUFFER_PTS_IS_VALID(buffer)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    std::lock_guard<std::mutex> lock(telemetry->mutex);
+    if (telemetry->decoder_entry.size() >= MAX_PENDING_FRAMES) {
+        telemetry->decoder_entry.clear();
+    }
+    telemetry->decoder_entry[GST_BUFFER_PTS(buffer)] = g_get_monotonic_time();
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn Telemetry::on_decoder_output(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    Telemetry* telemetry = static_cast<Telemetry*>(data);
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!GST_BUFFER_PTS_IS_VALID(buffer)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    std::lock_guard<std::mutex> lock(telemetry->mutex);
+    auto it = telemetry->decoder_entry.find(GST_BUFFER_PTS(buffer));
+    if (it != telemetry->decoder_entry.end()) {
+        telemetry->decoder_latency.add((g_get_monotonic_time() - it->second) / 1000.0);
+        telemetry->decoder_entry.erase(it);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+void Telemetry::handle_message(GstMessage* msg) {
+    switch (GST_MESSAGE_TYPE(msg)) {
+        case GST_MESSAGE_QOS: {
+            ElementQos& element = qos[GST_OBJECT_NAME(GST_MESSAGE_SRC(msg))];
+            element.messages++;
+
+            gint64 jitter = 0;
+            gdouble proportion = 1.0;
+            gst_message_parse_qos_values(msg, &jitter, &proportion, nullptr);
+            element.jitter.add(std::abs((double)jitter) / GST_MSECOND);
+            element.proportion = proportion;
+
+            GstFormat format;
+            guint64 processed = 0, dropped = 0;
+            gst_message_parse_qos_stats(msg, &format, &processed, &dropped);
+            if (processed != (guint64)-1) element.processed = processed;
+            if (dropped != (guint64)-1) element.dropped = dropped;
+            break;
+        }
+        case GST_MESSAGE_LATENCY: {
+            // Live sources changed their latency; redistribute it and record the result
+            if (!pipeline) break;
+            gst_bin_recalculate_latency(GST_BIN(pipeline));
+            GstQuery* query = gst_query_new_latency();
+            if (gst_element_query(pipeline, query)) {
+                gboolean live;
+                gst_query_parse_latency(query, &live, &latency_min, &latency_max);
+            }
+            gst_query_unref(query);
+            break;
+        }
+        case GST_MESSAGE_BUFFERING: {
+            gint percent = 100;
+            gst_message_parse_buffering(msg, &percent);
+            if (percent < 100 && buffering == 100) {
+                buffering_events++;
+            }
+            buffering = percent;
+            buffering_min = std::min(buffering_min, percent);
+            break;
+        }
+        case GST_MESSAGE_WARNING: {
+            GError* err = nullptr;
+            gst_message_parse_warning(msg, &err, nullptr);
+            warnings++;
+            last_warning = std::string(GST_OBJECT_NAME(GST_MESSAGE_SRC(msg))) + ": " + err->message;
+            LOG_WARNING(Playback, "%s", last_warning.c_str());
+            g_error_free(err);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool Telemetry::sink_stats(guint64& rendered, guint64& dropped) const {
+    // GstBaseSink "stats" (GStreamer >= 1.18)
+    if (!video_sink || !g_object_class_find_property(G_OBJECT_GET_CLASS(video_sink), "stats")) {
+        return false;
+    }
+
+    GstStructure* stats = nullptr;
+    g_object_get(video_sink, "stats", &stats, nullptr);
+    if (!stats) {
+        return false;
+    }
+    bool ok = gst_structure_get_uint64(stats, "rendered", &rendered) &&
+              gst_structure_get_uint64(stats, "dropped", &dropped);
+    gst_structure_free(stats);
+    return ok;
+}
+
+std::string Telemetry::summary() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+
+    guint64 rendered = 0, dropped = 0;
+    if (sink_stats(rendered, dropped)) {
+        guint64 total = rendered + dropped;
+        out << "Frames: " << rendered << " rendered, " << dropped << " dropped ("
+            << (total ? 100.0 * dropped / total : 0.0) << "%)\n";
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        out << "Decoder latency: p50 " << decoder_latency.percentile(0.5) << " ms, p99 "
+            << decoder_latency.percentile(0.99) << " ms (" << decoder_latency.count() << " frames)\n";
+    }
+    if (GST_CLOCK_TIME_IS_VALID(latency_min)) {
+        out << "Latency: " << to_ms(latency_min) << " ms\n";
+    }
+    out << "Buffering: " << buffering << "% (min " << buffering_min << "%, "
+        << buffering_events << " stalls)\n";
+    out << "Warnings: " << warnings;
+
+    for (const auto& entry : qos) {
+        const ElementQos& element = entry.second;
+        out << "\nQoS " << entry.first << ": " << element.dropped << " dropped, jitter p99 "
+            << element.jitter.percentile(0.99) << " ms, proportion " << element.proportion;
+    }
+    return out.str();
+}
+
+std::string Telemetry::to_json() const {
+    std::ostringstream out;
+    out << "{\"time\": " << g_get_real_time() / G_USEC_PER_SEC;
+    out << ", \"uptime_s\": " << (attach_time ? (g_get_monotonic_time() - attach_time) / G_USEC_PER_SEC : 0);
+
+    guint64 rendered = 0, dropped = 0;
+    if (sink_stats(rendered, dropped)) {
+        out << ", \"frames\": {\"rendered\": " << rendered << ", \"dropped\": " << dropped << "}";
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        out << ", \"decoder_latency_ms\": " << decoder_latency.to_json();
+    }
+
+    out << ", \"histogram_bounds_ms\": [";
+    const auto& edges = Histogram::bounds();
+    for (size_t i = 0; i < edges.size(); i++) {
+        out << (i ? ", " : "") << edges[i];
+    }
+    out << "]";
+
+    out << ", \"qos\": {";
+    bool first = true;
+    for (const auto& entry : qos) {
+        const ElementQos& element = entry.second;
+        out << (first ? "" : ", ") << "\"" << json_escape(entry.first) << "\": {"
+            << "\"messages\": " << element.messages
+            << ", \"processed\": " << element.processed
+            << ", \"dropped\": " << element.dropped
+            << ", \"proportion\": " << element.proportion
+            << ", \"jitter_ms\": " << element.jitter.to_json() << "}";
+        first = false;
+    }
+    out << "}";
+
+    out << ", \"latency_ms\": {\"min\": " << to_ms(latency_min) << ", \"max\": " << to_ms(latency_max) << "}";
+    out << ", \"buffering\": {\"percent\": " << buffering << ", \"min_percent\": " << buffering_min
+        << ", \"stalls\": " << buffering_events << "}";
+    out << ", \"memory\": {\"rss_bytes\": " << MemoryBudget::rss_bytes()
+        << ", \"peak_rss_bytes\": " << MemoryBudget::peak_rss_bytes() << "}";
+    out << ", \"warnings\": " << warnings << ", \"last_warning\": \"" << json_escape(last_warning) << "\"}";
+    return out.str();
+}
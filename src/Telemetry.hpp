@@ -0,0 +1,91 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+
+// Playback-health counters for one pipeline: QoS per element (dropped /
+// processed, jitter, proportion), rendered and dropped frames of the
+// video sink, video decoder latency, pipeline latency, buffering and
+// warnings. Bus messages are fed in from the main loop; decoder latency
+// is taken by pad probes on the video decoders.
+class Telemetry {
+public:
+    // Log-spaced millisecond buckets; the last one catches everything above
+    class Histogram {
+    public:
+        static const std::vector<double>& bounds();
+
+        void add(double ms);
+        guint64 count() const { return total; }
+        double percentile(double p) const;  // Upper bound of the matching bucket
+        std::string to_json() const;
+
+    private:
+        std::vector<guint64> counts = std::vector<guint64>(bounds().size() + 1, 0);
+        guint64 total = 0;
+    };
+
+    Telemetry();
+    ~Telemetry();
+
+    // Start over for a new pipeline and hook its video decoders
+    void attach(GstElement* pipeline, GstElement* video_sink);
+    void detach();
+
+    // Consumes QOS, LATENCY, BUFFERING and WARNING; ignores anything else
+    void handle_message(GstMessage* msg);
+
+    int buffering_percent() const { return buffering; }
+
+    std::string summary() const;  // A few lines for the on-screen overlay
+    std::string to_json() const;  // One object per snapshot, for monitoring
+
+private:
+    struct ElementQos {
+        guint64 messages = 0;
+        guint64 processed = 0;  // Cumulative, as last reported by the element
+        guint64 dropped = 0;
+        double proportion = 1.0;
+        Histogram jitter;
+    };
+
+    struct Probe {
+        GstPad* pad;
+        gulong id;
+    };
+
+    GstElement* pipeline;
+    GstElement* video_sink;  // The GstBaseSink doing the rendering
+    gulong element_added_id;
+    gint64 attach_time;
+
+    std::map<std::string, ElementQos> qos;
+    GstClockTime latency_min;
+    GstClockTime latency_max;
+    int buffering;
+    int buffering_min;
+    guint64 buffering_events;
+    guint64 warnings;
+    std::string last_warning;
+
+    // Shared with streaming threads
+    mutable std::mutex mutex;
+    std::vector<Probe> probes;
+    std::unordered_map<GstClockTime, gint64> decoder_entry;  // PTS -> monotonic time (us)
+    Histogram decoder_latency;
+
+    void hook_decoder(GstElement* element);
+    bool sink_stats(guint64& rendered, guint64& dropped) const;
+
+    static GstElement* find_base_sink(GstElement* sink);
+    static void on_element_added(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data);
+    static GstPadProbeReturn on_decoder_input(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+    static GstPadProbeReturn on_decoder_output(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+};
+
+#endif // TELEMETRY_HPP
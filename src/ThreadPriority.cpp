@@ -0,0 +1,8 @@
+#include "ThreadPriority.hpp"
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+void lower_thread_priority(int nice) {
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice);
+}
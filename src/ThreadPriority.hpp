@@ -0,0 +1,11 @@
+#ifndef THREAD_PRIORITY_HPP
+#define THREAD_PRIORITY_HPP
+
+// Nice value for background work that must not compete with playback:
+// keyframe indexing, thumbnail decoding
+static const int BACKGROUND_NICE = 10;
+
+// Renice the calling thread only (Linux threads have their own nice value)
+void lower_thread_priority(int nice = BACKGROUND_NICE);
+
+#endif // THREAD_PRIORITY_HPP
@@ -0,0 +1,348 @@
+#include "ThumbnailEngine.hpp"
+#include "ThreadPriority.hpp"
+#include <gst/app/gstappsink.h>
+#include <gst/video/video.h>
+#include <iostream>
+#include <cstring>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Bounds for a single preroll / decode on the worker
+static const GstClockTime PREROLL_TIMEOUT = 5 * GST_SECOND;
+static const GstClockTime DECODE_TIMEOUT = 2 * GST_SECOND;
+
+struct ThumbnailEngine::State {
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool quit = false;
+    std::string uri;
+    bool has_hover = false;
+    gint64 hover_position = 0;
+    std::deque<gint64> prefetch;
+
+    Callback callback;  // Main thread only
+
+    // LRU, most recent at the front
+    size_t cache_limit = 0;
+    size_t cache_bytes = 0;
+    std::list<std::pair<std::string, ThumbnailPtr>> lru;
+    std::unordered_map<std::string, std::list<std::pair<std::string, ThumbnailPtr>>::iterator> index;
+
+    // Worker thread only
+    GstElement* pipeline = nullptr;
+    GstElement* appsink = nullptr;
+    std::string pipeline_uri;
+    std::string failed_uri;
+
+    // Callers hold mutex
+    ThumbnailPtr lookup(const std::string& key);
+    void insert(const std::string& key, ThumbnailPtr thumbnail);
+};
+
+struct ThumbnailEngine::Delivery {
+    std::shared_ptr<State> state;
+    gint64 position;
+    ThumbnailPtr thumbnail;
+};
+
+static std::string make_key(const std::string& uri, gint64 position) {
+    return uri + "#" + std::to_string(position / ThumbnailEngine::BUCKET);
+}
+
+static size_t thumbnail_bytes(const ThumbnailPtr& thumbnail) {
+    return sizeof(Thumbnail) + thumbnail->pixels.size();
+}
+
+ThumbnailPtr ThumbnailEngine::State::lookup(const std::string& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return nullptr;
+    }
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->second;
+}
+
+void ThumbnailEngine::State::insert(const std::string& key, ThumbnailPtr thumbnail) {
+    if (index.count(key)) {
+        return;
+    }
+
+    lru.emplace_front(key, thumbnail);
+    index[key] = lru.begin();
+    cache_bytes += thumbnail_bytes(thumbnail);
+
+    // Evict least recently used until we are back under budget
+    while (cache_bytes > cache_limit && lru.size() > 1) {
+        auto& oldest = lru.back();
+        cache_bytes -= thumbnail_bytes(oldest.second);
+        index.erase(oldest.first);
+        lru.pop_back();
+    }
+}
+
+ThumbnailEngine::ThumbnailEngine(size_t cache_bytes) : state(std::make_shared<State>()) {
+    state->cache_limit = cache_bytes;
+    std::thread(worker, state).detach();
+}
+
+ThumbnailEngine::~ThumbnailEngine() {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->quit = true;
+    state->wake.notify_one();
+}
+
+void ThumbnailEngine::set_callback(Callback callback) {
+    state->callback = std::move(callback);
+}
+
+void ThumbnailEngine::open(const std::string& uri) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->uri = uri;
+    state->has_hover = false;
+    state->prefetch.clear();
+    state->wake.notify_one();
+}
+
+void ThumbnailEngine::close() {
+    open("");
+}
+
+ThumbnailPtr ThumbnailEngine::request(gint64 position) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->uri.empty()) {
+        return nullptr;
+    }
+
+    ThumbnailPtr thumbnail = state->lookup(make_key(state->uri, position));
+    if (!thumbnail) {
+        // Hover requests replace each other; only the latest is decoded
+        state->has_hover = true;
+        state->hover_position = position;
+        state->wake.notify_one();
+    }
+    return thumbnail;
+}
+
+void ThumbnailEngine::precompute(gint64 duration, int count) {
+    if (duration <= 0 || count <= 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    gint64 last_bucket = -1;
+    for (int i = 0; i < count; i++) {
+        gint64 position = duration * i / count;
+        if (position / BUCKET != last_bucket) {
+            state->prefetch.push_back(position);
+            last_bucket = position / BUCKET;
+        }
+    }
+    state->wake.notify_one();
+}
+
+size_t ThumbnailEngine::cache_size_bytes() const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->cache_bytes;
+}
+
+void ThumbnailEngine::worker(std::shared_ptr<State> state) {
+    lower_thread_priority();
+
+    while (true) {
+        gint64 position = 0;
+        bool is_hover = false;
+        std::string uri;
+
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->wake.wait(lock, [&] {
+                return state->quit || state->has_hover || !state->prefetch.empty();
+            });
+            if (state->quit) {
+                break;
+            }
+
+            if (state->has_hover) {
+                position = state->hover_position;
+                state->has_hover = false;
+                is_hover = true;
+            } else {
+                position = state->prefetch.front();
+                state->prefetch.pop_front();
+            }
+            uri = state->uri;
+
+            if (uri.empty() || (!is_hover && state->index.count(make_key(uri, position)))) {
+                continue;
+            }
+        }
+
+        if (!ensure_pipeline(*state, uri)) {
+            continue;
+        }
+
+        // Decode the start of the bucket so every hover inside it shares one frame
+        ThumbnailPtr thumbnail = decode(*state, position - position % BUCKET);
+        if (!thumbnail) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->uri == uri) {
+                state->insert(make_key(uri, position), thumbnail);
+            }
+        }
+
+        if (is_hover) {
+            g_idle_add(deliver, new Delivery{state, position, thumbnail});
+        }
+    }
+
+    destroy_pipeline(*state);
+}
+
+GstBusSyncReply ThumbnailEngine::on_sync_message(GstBus* bus, GstMessage* msg, gpointer data) {
+    if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_STREAM_STATUS) {
+        // ENTER is posted from inside the new streaming thread
+        GstStreamStatusType type;
+        gst_message_parse_stream_status(msg, &type, nullptr);
+        if (type == GST_STREAM_STATUS_TYPE_ENTER) {
+            lower_thread_priority();
+        }
+    } else if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+        GError* err = nullptr;
+        gst_message_parse_error(msg, &err, nullptr);
+        std::cerr << "Thumbnail pipeline error: " << err->message << std::endl;
+        g_error_free(err);
+    }
+
+    // Nobody reads this bus; don't let messages pile up
+    return GST_BUS_DROP;
+}
+
+bool ThumbnailEngine::ensure_pipeline(State& state, const std::string& uri) {
+    if (state.pipeline && state.pipeline_uri == uri) {
+        return true;
+    }
+    if (uri == state.failed_uri) {
+        return false;
+    }
+
+    destroy_pipeline(state);
+
+    // Scale while still in the decoder's format, convert only the small frame
+    std::string description =
+        "uridecodebin uri=" + uri + " caps=video/x-raw expose-all-streams=false"
+        " ! videoscale ! video/x-raw,width=" + std::to_string(WIDTH) + ",pixel-aspect-ratio=1/1"
+        " ! videoconvert ! video/x-raw,format=RGB"
+        " ! appsink name=thumbsink sync=false max-buffers=1 drop=true";
+
+    GError* error = nullptr;
+    GstElement* pipeline = gst_parse_launch(description.c_str(), &error);
+    if (error) {
+        std::cerr << "Thumbnail pipeline: " << error->message << std::endl;
+        g_error_free(error);
+        if (pipeline) {
+            gst_object_unref(pipeline);
+        }
+        state.failed_uri = uri;
+        return false;
+    }
+
+    GstBus* bus = gst_element_get_bus(pipeline);
+    gst_bus_set_sync_handler(bus, on_sync_message, nullptr, nullptr);
+    gst_object_unref(bus);
+
+    gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    GstStateChangeReturn ret = gst_element_get_state(pipeline, nullptr, nullptr, PREROLL_TIMEOUT);
+    if (ret != GST_STATE_CHANGE_SUCCESS) {
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+        state.failed_uri = uri;
+        return false;
+    }
+
+    state.pipeline = pipeline;
+    state.appsink = gst_bin_get_by_name(GST_BIN(pipeline), "thumbsink");
+    state.pipeline_uri = uri;
+    state.failed_uri.clear();
+    return true;
+}
+
+void ThumbnailEngine::destroy_pipeline(State& state) {
+    if (state.appsink) {
+        gst_object_unref(state.appsink);
+        state.appsink = nullptr;
+    }
+    if (state.pipeline) {
+        gst_element_set_state(state.pipeline, GST_STATE_NULL);
+        gst_object_unref(state.pipeline);
+        state.pipeline = nullptr;
+    }
+    state.pipeline_uri.clear();
+}
+
+ThumbnailPtr ThumbnailEngine::decode(State& state, gint64 position) {
+    // Land on the keyframe before the target and skip everything else
+    GstSeekFlags flags = GstSeekFlags(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT |
+                                      GST_SEEK_FLAG_SNAP_BEFORE | GST_SEEK_FLAG_TRICKMODE |
+                                      GST_SEEK_FLAG_TRICKMODE_KEY_UNITS);
+    if (!gst_element_seek_simple(state.pipeline, GST_FORMAT_TIME, flags, position)) {
+        return nullptr;
+    }
+
+    GstSample* sample = gst_app_sink_try_pull_preroll(GST_APP_SINK(state.appsink), DECODE_TIMEOUT);
+    if (!sample) {
+        return nullptr;
+    }
+
+    GstVideoInfo info;
+    GstVideoFrame frame;
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    if (!gst_video_info_from_caps(&info, gst_sample_get_caps(sample)) ||
+        !gst_video_frame_map(&frame, &info, buffer, GST_MAP_READ)) {
+        gst_sample_unref(sample);
+        return nullptr;
+    }
+
+    auto thumbnail = std::make_shared<Thumbnail>();
+    thumbnail->width = GST_VIDEO_FRAME_WIDTH(&frame);
+    thumbnail->height = GST_VIDEO_FRAME_HEIGHT(&frame);
+    thumbnail->stride = thumbnail->width * 3;
+    thumbnail->timestamp = GST_BUFFER_PTS(buffer);
+    thumbnail->pixels.resize((size_t)thumbnail->stride * thumbnail->height);
+
+    // Repack rows; the decoder's stride may be padded
+    const guint8* src = static_cast<const guint8*>(GST_VIDEO_FRAME_PLANE_DATA(&frame, 0));
+    int src_stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0);
+    for (int y = 0; y < thumbnail->height; y++) {
+        memcpy(&thumbnail->pixels[(size_t)y * thumbnail->stride], src + (size_t)y * src_stride,
+               thumbnail->stride);
+    }
+
+    gst_video_frame_unmap(&frame);
+    gst_sample_unref(sample);
+    return thumbnail;
+}
+
+gboolean ThumbnailEngine::deliver(gpointer data) {
+    Delivery* delivery = static_cast<Delivery*>(data);
+    State& state = *delivery->state;
+
+    bool alive;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        alive = !state.quit;
+    }
+    if (alive && state.callback) {
+        state.callback(delivery->position, delivery->thumbnail);
+    }
+
+    delete delivery;
+    return G_SOURCE_REMOVE;
+}
@@ -0,0 +1,65 @@
+#ifndef THUMBNAIL_ENGINE_HPP
+#define THUMBNAIL_ENGINE_HPP
+
+#include <gst/gst.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+// Decoded preview frame (packed RGB)
+struct Thumbnail {
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    gint64 timestamp = 0;  // PTS of the keyframe actually decoded
+    std::vector<guint8> pixels;
+};
+
+using ThumbnailPtr = std::shared_ptr<const Thumbnail>;
+
+// Seek-bar preview frames from a second, low-priority pipeline
+// (uridecodebin -> videoscale -> appsink) that only decodes keyframes.
+// All decoding happens on a worker thread; results land in a
+// memory-bounded LRU keyed by URI and timestamp bucket.
+class ThumbnailEngine {
+public:
+    // Runs on the main loop when a hover request has been decoded
+    using Callback = std::function<void(gint64 position, ThumbnailPtr thumbnail)>;
+
+    static constexpr int WIDTH = 160;
+    static constexpr gint64 BUCKET = 2 * GST_SECOND;
+
+    explicit ThumbnailEngine(size_t cache_bytes = 16 * 1024 * 1024);
+    ~ThumbnailEngine();
+
+    void set_callback(Callback callback);
+
+    // Switch to a new file; cached thumbnails of other files stay in the LRU
+    void open(const std::string& uri);
+    void close();
+
+    // Cached thumbnail, or nullptr and a background decode (newest wins)
+    ThumbnailPtr request(gint64 position);
+
+    // Queue evenly spaced thumbnails (sprite sheet) behind hover requests
+    void precompute(gint64 duration, int count);
+
+    size_t cache_size_bytes() const;
+
+private:
+    // Shared with the worker, which is detached so that shutting the
+    // engine down never waits for a decode in progress
+    struct State;
+    struct Delivery;
+    std::shared_ptr<State> state;
+
+    static void worker(std::shared_ptr<State> state);
+    static bool ensure_pipeline(State& state, const std::string& uri);
+    static void destroy_pipeline(State& state);
+    static ThumbnailPtr decode(State& state, gint64 position);
+    static gboolean deliver(gpointer data);
+    static GstBusSyncReply on_sync_message(GstBus* bus, GstMessage* msg, gpointer data);
+};
+
+#endif // THUMBNAIL_ENGINE_HPP
@@ -0,0 +1,197 @@
+#include "VideoFrameSink.hpp"
+#include <gst/video/video.h>
+#include <iostream>
+
+// cairo's RGB24 is a native-endian 32-bit xRGB word
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define CAIRO_VIDEO_FORMAT "BGRx"
+#else
+#define CAIRO_VIDEO_FORMAT "xRGB"
+#endif
+
+// Scaling runs first, in the decoder's (usually planar 4:2:0) format, so
+// the colour conversion only sees display-sized frames; both pass buffers
+// through untouched when there is nothing to do. Multithreaded conversion
+// straight into the cairo layout. No last-sample, so the sink does not
+// pin an extra pool buffer.
+const char* const VideoFrameSink::SINK_DESCRIPTION =
+    "videoscale ! capsfilter name=appvideoscale ! videoconvert n-threads=0 "
+    "! appsink name=appvideosink caps=video/x-raw,format=" CAIRO_VIDEO_FORMAT
+    " max-buffers=1 drop=true enable-last-sample=false";
+
+VideoFrameSink::VideoFrameSink()
+    : appsink(nullptr), scaler(nullptr), sink_pad(nullptr), probe_id(0), latest(nullptr),
+      frames_received(0), frames_dropped(0) {
+}
+
+VideoFrameSink::~VideoFrameSink() {
+    detach();
+}
+
+void VideoFrameSink::set_callback(Callback new_callback) {
+    callback = std::move(new_callback);
+}
+
+bool VideoFrameSink::attach(GstElement* pipeline) {
+    detach();
+    if (!pipeline) {
+        return false;
+    }
+
+    // Searches nested bins, so this works for playbin's video-sink too
+    appsink = gst_bin_get_by_name(GST_BIN(pipeline), SINK_NAME);
+    if (!appsink) {
+        return false;
+    }
+
+    scaler = gst_bin_get_by_name(GST_BIN(pipeline), SCALER_NAME);
+
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = on_new_sample;
+    callbacks.new_preroll = on_new_preroll;
+    gst_app_sink_set_callbacks(GST_APP_SINK(appsink), &callbacks, this, nullptr);
+
+    // Already-negotiated pipelines re-query allocation on the next reconfigure
+    sink_pad = gst_element_get_static_pad(appsink, "sink");
+    probe_id = gst_pad_add_probe(sink_pad, GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM,
+                                 on_query, this, nullptr);
+    gst_pad_push_event(sink_pad, gst_event_new_reconfigure());
+
+    frames_received = 0;
+    frames_dropped = 0;
+
+    // The preroll frame arrived before the callbacks were installed
+    GstSample* preroll = gst_app_sink_try_pull_preroll(GST_APP_SINK(appsink), 0);
+    if (preroll) {
+        store(preroll);
+    }
+    return true;
+}
+
+void VideoFrameSink::detach() {
+    if (sink_pad) {
+        if (probe_id) {
+            gst_pad_remove_probe(sink_pad, probe_id);
+            probe_id = 0;
+        }
+        gst_object_unref(sink_pad);
+        sink_pad = nullptr;
+    }
+    if (scaler) {
+        gst_object_unref(scaler);
+        scaler = nullptr;
+    }
+    if (appsink) {
+        GstAppSinkCallbacks callbacks = {};
+        gst_app_sink_set_callbacks(GST_APP_SINK(appsink), &callbacks, nullptr, nullptr);
+        gst_object_unref(appsink);
+        appsink = nullptr;
+    }
+
+    // Give the pool buffer back before the pipeline goes away
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latest) {
+        gst_sample_unref(latest);
+        latest = nullptr;
+    }
+}
+
+void VideoFrameSink::set_max_size(int width, int height) {
+    if (!scaler) {
+        return;
+    }
+
+    // Ranges rather than a fixed size: videoscale picks the largest size
+    // inside them with the source's display aspect ratio, and passes
+    // smaller sources through
+    GstCaps* caps = width > 0 && height > 0
+        ? gst_caps_new_simple("video/x-raw",
+                              "width", GST_TYPE_INT_RANGE, 1, width,
+                              "height", GST_TYPE_INT_RANGE, 1, height, nullptr)
+        : gst_caps_new_any();
+    // capsfilter sends the reconfigure upstream itself
+    g_object_set(scaler, "caps", caps, nullptr);
+    gst_caps_unref(caps);
+}
+
+GstSample* VideoFrameSink::take_latest() {
+    std::lock_guard<std::mutex> lock(mutex);
+    GstSample* sample = latest;
+    latest = nullptr;
+    return sample;
+}
+
+void VideoFrameSink::store(GstSample* sample) {
+    GstSample* replaced;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        replaced = latest;
+        latest = sample;
+    }
+
+    frames_received++;
+    if (replaced) {
+        frames_dropped++;
+        gst_sample_unref(replaced);
+    }
+    if (callback) {
+        callback();
+    }
+}
+
+GstFlowReturn VideoFrameSink::on_new_sample(GstAppSink* sink, gpointer data) {
+    VideoFrameSink* frames = static_cast<VideoFrameSink*>(data);
+    GstSample* sample = gst_app_sink_pull_sample(sink);
+    if (!sample) {
+        return GST_FLOW_EOS;
+    }
+    frames->store(sample);
+    return GST_FLOW_OK;
+}
+
+GstFlowReturn VideoFrameSink::on_new_preroll(GstAppSink* sink, gpointer data) {
+    // Paused seeks only produce a preroll frame; it has to be shown too
+    VideoFrameSink* frames = static_cast<VideoFrameSink*>(data);
+    GstSample* sample = gst_app_sink_pull_preroll(sink);
+    if (!sample) {
+        return GST_FLOW_EOS;
+    }
+    frames->store(sample);
+    return GST_FLOW_OK;
+}
+
+GstPadProbeReturn VideoFrameSink::on_query(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    GstQuery* query = GST_PAD_PROBE_INFO_QUERY(info);
+    if (GST_QUERY_TYPE(query) != GST_QUERY_ALLOCATION) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstCaps* caps = nullptr;
+    gboolean need_pool = FALSE;
+    gst_query_parse_allocation(query, &caps, &need_pool);
+
+    GstVideoInfo video_info;
+    if (!caps || !gst_video_info_from_caps(&video_info, caps)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBufferPool* pool = gst_video_buffer_pool_new();
+    GstStructure* config = gst_buffer_pool_get_config(pool);
+    gst_buffer_pool_config_set_params(config, caps, GST_VIDEO_INFO_SIZE(&video_info),
+                                      POOL_MIN_BUFFERS, POOL_MAX_BUFFERS);
+    gst_buffer_pool_config_add_option(config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+    if (!gst_buffer_pool_set_config(pool, config)) {
+        std::cerr << "Warning: Could not configure video buffer pool" << std::endl;
+        gst_object_unref(pool);
+        return GST_PAD_PROBE_OK;
+    }
+
+    // Video meta lets upstream keep its own strides instead of copying
+    gst_query_add_allocation_pool(query, pool, GST_VIDEO_INFO_SIZE(&video_info),
+                                  POOL_MIN_BUFFERS, POOL_MAX_BUFFERS);
+    gst_query_add_allocation_meta(query, GST_VIDEO_META_API_TYPE, nullptr);
+    gst_object_unref(pool);
+
+    // Answered here; appsink itself proposes nothing
+    return GST_PAD_PROBE_HANDLED;
+}
@@ -0,0 +1,76 @@
+#ifndef VIDEO_FRAME_SINK_HPP
+#define VIDEO_FRAME_SINK_HPP
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <functional>
+#include <mutex>
+#include <atomic>
+
+// Receiving end of the in-tree video output: an appsink negotiating
+// cairo's RGB24 layout (BGRx on little-endian) that keeps only the newest
+// sample in a one-slot mailbox. A scaler in front of the colour
+// conversion can shrink frames to the display size, so large sources are
+// converted and painted at the size they are shown. Upstream allocates from a bounded
+// GstVideoBufferPool proposed in the ALLOCATION query, so frames are
+// recycled instead of allocated per buffer and a slow consumer causes
+// back-pressure rather than memory growth.
+class VideoFrameSink {
+public:
+    // Runs on a streaming thread whenever the mailbox receives a sample
+    using Callback = std::function<void()>;
+
+    // Name of the appsink inside SINK_DESCRIPTION
+    static constexpr const char* SINK_NAME = "appvideosink";
+    // ... and of the capsfilter bounding the scaler's output
+    static constexpr const char* SCALER_NAME = "appvideoscale";
+
+    // playbin video-sink description for this output
+    static const char* const SINK_DESCRIPTION;
+
+    // Pool bounds: upstream + appsink queue + mailbox + displayed frame + slack
+    static constexpr guint POOL_MIN_BUFFERS = 3;
+    static constexpr guint POOL_MAX_BUFFERS = 6;
+
+    VideoFrameSink();
+    ~VideoFrameSink();
+
+    void set_callback(Callback callback);
+
+    // Find SINK_NAME in pipeline and start receiving; false if absent
+    bool attach(GstElement* pipeline);
+    void detach();
+    bool attached() const { return appsink != nullptr; }
+
+    // Frames larger than width x height (device pixels) are scaled down
+    // to fit, keeping their display aspect ratio; 0 x 0 lifts the bound.
+    // A change renegotiates the running pipeline.
+    void set_max_size(int width, int height);
+
+    // Newest sample not taken yet (caller unrefs), or nullptr
+    GstSample* take_latest();
+
+    guint64 received_count() const { return frames_received; }
+    guint64 dropped_count() const { return frames_dropped; }  // Replaced before anyone took them
+
+private:
+    GstElement* appsink;
+    GstElement* scaler;  // The capsfilter, absent in pipelines built before it existed
+    GstPad* sink_pad;
+    gulong probe_id;
+    Callback callback;
+
+    std::mutex mutex;
+    GstSample* latest;
+
+    std::atomic<guint64> frames_received;
+    std::atomic<guint64> frames_dropped;
+
+    void store(GstSample* sample);
+
+    static GstFlowReturn on_new_sample(GstAppSink* sink, gpointer data);
+    static GstFlowReturn on_new_preroll(GstAppSink* sink, gpointer data);
+    static GstPadProbeReturn on_query(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+};
+
+#endif // VIDEO_FRAME_SINK_HPP
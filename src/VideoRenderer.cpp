@@ -0,0 +1,310 @@
+#include "VideoRenderer.hpp"
+#include "Logger.hpp"
+#include <iostream>
+#include <algorithm>
+
+// The scaler's bound is the widget size rounded up to a multiple of this
+// (device pixels); frames are at most one step larger than shown
+static const int SIZE_CLASS_STEP = 128;
+
+// A window drag renegotiates once it has paused for this long
+static const guint RESIZE_SETTLE_MS = 150;
+
+VideoRenderer::VideoRenderer()
+    : widget(nullptr), draw_handler(0), size_handler(0), scale_handler(0), resize_timer_id(0),
+      downscale(true), max_width(-1), max_height(-1), pipeline(nullptr), current_sample(nullptr),
+      surface(nullptr), par_n(1), par_d(1), redraw_pending(false),
+      frames_painted(0), frames_late(0) {
+    // Coalesce frame notifications into one queued redraw
+    frames.set_callback([this]() {
+        if (!redraw_pending.exchange(true)) {
+            g_idle_add_full(G_PRIORITY_HIGH_IDLE, on_frame_available, this, nullptr);
+        }
+    });
+}
+
+VideoRenderer::~VideoRenderer() {
+    detach();
+    if (resize_timer_id) {
+        g_source_remove(resize_timer_id);
+    }
+    if (widget) {
+        g_signal_handler_disconnect(widget, draw_handler);
+        g_signal_handler_disconnect(widget, size_handler);
+        g_signal_handler_disconnect(widget, scale_handler);
+        g_object_remove_weak_pointer(G_OBJECT(widget), (gpointer*)&widget);
+    }
+    // A notification may still be queued
+    while (g_idle_remove_by_data(this)) {
+    }
+}
+
+void VideoRenderer::set_widget(GtkWidget* new_widget) {
+    widget = new_widget;
+    g_object_add_weak_pointer(G_OBJECT(widget), (gpointer*)&widget);
+    draw_handler = g_signal_connect(widget, "draw", G_CALLBACK(on_draw), this);
+    size_handler = g_signal_connect(widget, "size-allocate", G_CALLBACK(on_size_allocate), this);
+    scale_handler = g_signal_connect(widget, "notify::scale-factor", G_CALLBACK(on_scale_factor), this);
+}
+
+void VideoRenderer::set_overlay(Overlay callback) {
+    overlay = std::move(callback);
+}
+
+void VideoRenderer::set_downscale(bool enabled) {
+    downscale = enabled;
+    update_max_size();
+}
+
+int VideoRenderer::size_class(int pixels) {
+    return (pixels + SIZE_CLASS_STEP - 1) / SIZE_CLASS_STEP * SIZE_CLASS_STEP;
+}
+
+// Renegotiates only when the size class changes
+void VideoRenderer::update_max_size() {
+    if (!active()) {
+        return;
+    }
+
+    // Unallocated widgets report 1x1
+    int width = 0, height = 0;
+    if (downscale && widget && gtk_widget_get_allocated_width(widget) > 1) {
+        int scale = gtk_widget_get_scale_factor(widget);
+        width = size_class(gtk_widget_get_allocated_width(widget) * scale);
+        height = size_class(gtk_widget_get_allocated_height(widget) * scale);
+    }
+    if (width == max_width && height == max_height) {
+        return;
+    }
+
+    max_width = width;
+    max_height = height;
+    frames.set_max_size(width, height);
+    LOG_DEBUG(Video, "Frames scaled to fit %dx%d", width, height);
+}
+
+void VideoRenderer::schedule_resize() {
+    if (resize_timer_id) {
+        g_source_remove(resize_timer_id);
+    }
+    resize_timer_id = g_timeout_add(RESIZE_SETTLE_MS, on_resize_settled, this);
+}
+
+void VideoRenderer::on_size_allocate(GtkWidget* widget, GdkRectangle* allocation, gpointer data) {
+    static_cast<VideoRenderer*>(data)->schedule_resize();
+}
+
+void VideoRenderer::on_scale_factor(GObject* object, GParamSpec* pspec, gpointer data) {
+    static_cast<VideoRenderer*>(data)->schedule_resize();
+}
+
+gboolean VideoRenderer::on_resize_settled(gpointer data) {
+    VideoRenderer* renderer = static_cast<VideoRenderer*>(data);
+    renderer->resize_timer_id = 0;
+    renderer->update_max_size();
+    return G_SOURCE_REMOVE;
+}
+
+bool VideoRenderer::attach(GstElement* new_pipeline) {
+    detach();
+    if (!frames.attach(new_pipeline)) {
+        return false;
+    }
+
+    pipeline = GST_ELEMENT(gst_object_ref(new_pipeline));
+    frames_painted = 0;
+    frames_late = 0;
+
+    // Bound this pipeline's scaler even if the size class is unchanged
+    max_width = -1;
+    max_height = -1;
+    update_max_size();
+    std::cout << "Rendering video through appsink (" << VideoFrameSink::POOL_MAX_BUFFERS
+              << " pooled buffers)" << std::endl;
+    return true;
+}
+
+void VideoRenderer::detach() {
+    frames.detach();
+    release_current();
+
+    if (pipeline) {
+        gst_object_unref(pipeline);
+        pipeline = nullptr;
+    }
+    if (widget) {
+        gtk_widget_queue_draw(widget);
+    }
+}
+
+void VideoRenderer::release_current() {
+    if (surface) {
+        cairo_surface_destroy(surface);
+        surface = nullptr;
+    }
+    if (current_sample) {
+        gst_video_frame_unmap(&current_frame);
+        gst_sample_unref(current_sample);
+        current_sample = nullptr;
+    }
+}
+
+// Would this frame's display interval be over before the next vblank?
+bool VideoRenderer::is_late(GstSample* sample) {
+    if (!pipeline || GST_STATE(pipeline) != GST_STATE_PLAYING) {
+        return false;
+    }
+
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    const GstSegment* segment = gst_sample_get_segment(sample);
+    if (!buffer || !segment || !GST_BUFFER_PTS_IS_VALID(buffer) ||
+        !GST_BUFFER_DURATION_IS_VALID(buffer)) {
+        return false;
+    }
+
+    GstClockTime running = gst_segment_to_running_time(segment, GST_FORMAT_TIME,
+                                                       GST_BUFFER_PTS(buffer));
+    GstClock* clock = gst_element_get_clock(pipeline);
+    if (!GST_CLOCK_TIME_IS_VALID(running) || !clock) {
+        if (clock) gst_object_unref(clock);
+        return false;
+    }
+
+    GstClockTime frame_end = gst_element_get_base_time(pipeline) + running + GST_BUFFER_DURATION(buffer);
+    GstClockTime now = gst_clock_get_time(clock);
+    gst_object_unref(clock);
+
+    // How far ahead of now the frame being drawn will actually be presented
+    gint64 lead_us = 0;
+    GdkFrameClock* frame_clock = widget ? gtk_widget_get_frame_clock(widget) : nullptr;
+    if (frame_clock) {
+        gint64 frame_time = gdk_frame_clock_get_frame_time(frame_clock);
+        gint64 refresh_interval = 0, presentation_time = 0;
+        gdk_frame_clock_get_refresh_info(frame_clock, frame_time, &refresh_interval, &presentation_time);
+        if (presentation_time == 0) {
+            presentation_time = frame_time + refresh_interval;
+        }
+        lead_us = std::max<gint64>(0, presentation_time - g_get_monotonic_time());
+    }
+
+    return frame_end < now + lead_us * GST_USECOND;
+}
+
+// Map the frame and wrap its pixels in a cairo surface (no copy)
+bool VideoRenderer::show(GstSample* sample) {
+    GstVideoInfo info;
+    GstCaps* caps = gst_sample_get_caps(sample);
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    if (!caps || !buffer || !gst_video_info_from_caps(&info, caps)) {
+        gst_sample_unref(sample);
+        return false;
+    }
+
+    GstVideoFrame frame;
+    if (!gst_video_frame_map(&frame, &info, buffer, GST_MAP_READ)) {
+        gst_sample_unref(sample);
+        return false;
+    }
+
+    int width = GST_VIDEO_FRAME_WIDTH(&frame);
+    int height = GST_VIDEO_FRAME_HEIGHT(&frame);
+    int stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0);
+    if (stride % 4 != 0 || stride < cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, width)) {
+        std::cerr << "Warning: Frame stride " << stride << " not usable by cairo" << std::endl;
+        gst_video_frame_unmap(&frame);
+        gst_sample_unref(sample);
+        return false;
+    }
+
+    release_current();
+    current_sample = sample;
+    current_frame = frame;
+    surface = cairo_image_surface_create_for_data((unsigned char*)GST_VIDEO_FRAME_PLANE_DATA(&frame, 0),
+                                                  CAIRO_FORMAT_RGB24, width, height, stride);
+    par_n = std::max(1, GST_VIDEO_INFO_PAR_N(&info));
+    par_d = std::max(1, GST_VIDEO_INFO_PAR_D(&info));
+    return true;
+}
+
+bool VideoRenderer::present(GstSample* sample) {
+    if (!active()) {
+        gst_sample_unref(sample);
+        return false;
+    }
+    if (!show(sample)) {
+        return false;
+    }
+    if (widget) {
+        gtk_widget_queue_draw(widget);
+    }
+    return true;
+}
+
+gboolean VideoRenderer::on_frame_available(gpointer data) {
+    VideoRenderer* renderer = static_cast<VideoRenderer*>(data);
+    renderer->redraw_pending = false;
+    if (renderer->widget) {
+        gtk_widget_queue_draw(renderer->widget);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// Stream time of the frame on screen, which is what subtitle files count
+GstClockTime VideoRenderer::frame_position() const {
+    GstBuffer* buffer = current_sample ? gst_sample_get_buffer(current_sample) : nullptr;
+    const GstSegment* segment = current_sample ? gst_sample_get_segment(current_sample) : nullptr;
+    if (!buffer || !segment || !GST_BUFFER_PTS_IS_VALID(buffer)) {
+        return GST_CLOCK_TIME_NONE;
+    }
+    return gst_segment_to_stream_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+}
+
+gboolean VideoRenderer::on_draw(GtkWidget* widget, cairo_t* cr, gpointer data) {
+    VideoRenderer* renderer = static_cast<VideoRenderer*>(data);
+    if (!renderer->active()) {
+        return FALSE;  // Let the sink or the CSS background draw
+    }
+
+    GstSample* sample = renderer->frames.take_latest();
+    if (sample) {
+        // Keep a late frame only if there is nothing else to show
+        if (renderer->surface && renderer->is_late(sample)) {
+            renderer->frames_late++;
+            gst_sample_unref(sample);
+        } else {
+            renderer->show(sample);
+        }
+    }
+
+    double area_width = gtk_widget_get_allocated_width(widget);
+    double area_height = gtk_widget_get_allocated_height(widget);
+
+    cairo_set_source_rgb(cr, 0, 0, 0);
+    cairo_paint(cr);
+
+    if (!renderer->surface) {
+        return TRUE;
+    }
+
+    // Letterbox, honouring the pixel aspect ratio
+    double frame_width = cairo_image_surface_get_width(renderer->surface) * (double)renderer->par_n / renderer->par_d;
+    double frame_height = cairo_image_surface_get_height(renderer->surface);
+    double scale = std::min(area_width / frame_width, area_height / frame_height);
+
+    double x = (area_width - frame_width * scale) / 2;
+    double y = (area_height - frame_height * scale) / 2;
+    cairo_save(cr);
+    cairo_translate(cr, x, y);
+    cairo_scale(cr, scale * renderer->par_n / renderer->par_d, scale);
+    cairo_set_source_surface(cr, renderer->surface, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_BILINEAR);
+    cairo_paint(cr);
+    cairo_restore(cr);
+
+    if (renderer->overlay) {
+        renderer->overlay(cr, x, y, frame_width * scale, frame_height * scale, renderer->frame_position());
+    }
+
+    renderer->frames_painted++;
+    return TRUE;
+}
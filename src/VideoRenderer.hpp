@@ -0,0 +1,90 @@
+#ifndef VIDEO_RENDERER_HPP
+#define VIDEO_RENDERER_HPP
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <atomic>
+#include <functional>
+#include "VideoFrameSink.hpp"
+
+// Paints frames from a VideoFrameSink into a GtkWidget's "draw" handler.
+// The mapped GstVideoFrame is wrapped in a cairo image surface as-is (no
+// intermediate copy) and stays mapped until the next frame replaces it,
+// so the pool buffer is held exactly as long as it is on screen. Frames
+// whose display time has passed by the next frame-clock presentation
+// are dropped instead of painted. Frames are scaled down in the pipeline
+// to the widget's size in device pixels, rounded up to a size class so a
+// window drag renegotiates only now and then.
+class VideoRenderer {
+public:
+    VideoRenderer();
+    ~VideoRenderer();
+
+    // Connect to widget's "draw" and size signals; call once after creating it
+    void set_widget(GtkWidget* widget);
+
+    // Drawn over each painted frame, given the video rectangle in widget
+    // coordinates and the frame's stream time (GST_CLOCK_TIME_NONE if
+    // unknown)
+    using Overlay = std::function<void(cairo_t* cr, double x, double y, double width, double height,
+                                       GstClockTime position)>;
+    void set_overlay(Overlay callback);
+
+    // Scale frames down to the widget size (the default) or take them at
+    // source resolution
+    void set_downscale(bool enabled);
+
+    // Start painting frames of the appsink output in pipeline.
+    // False if the pipeline does not use VideoFrameSink::SINK_DESCRIPTION.
+    bool attach(GstElement* pipeline);
+    void detach();
+    bool active() const { return frames.attached(); }
+
+    // Show a frame that did not come through the sink (e.g. from a
+    // FrameCache) until the sink delivers the next one; takes ownership
+    bool present(GstSample* sample);
+
+    guint64 painted_count() const { return frames_painted; }
+    guint64 late_count() const { return frames_late; }
+    guint64 dropped_count() const { return frames.dropped_count(); }
+
+private:
+    GtkWidget* widget;
+    gulong draw_handler;
+    gulong size_handler;
+    gulong scale_handler;
+    guint resize_timer_id;
+    bool downscale;
+    int max_width, max_height;  // Size class handed to the sink, 0 = unbounded, -1 = none yet
+    VideoFrameSink frames;
+    GstElement* pipeline;
+    Overlay overlay;
+
+    // Frame currently on screen, mapped for the surface's lifetime
+    GstSample* current_sample;
+    GstVideoFrame current_frame;
+    cairo_surface_t* surface;
+    int par_n, par_d;
+
+    std::atomic<bool> redraw_pending;  // Idle queued, not run yet
+    guint64 frames_painted;
+    guint64 frames_late;
+
+    bool is_late(GstSample* sample);
+    GstClockTime frame_position() const;
+    bool show(GstSample* sample);
+    void release_current();
+    void update_max_size();
+    void schedule_resize();
+
+    static int size_class(int pixels);
+
+    static gboolean on_draw(GtkWidget* widget, cairo_t* cr, gpointer data);
+    static gboolean on_frame_available(gpointer data);
+    static void on_size_allocate(GtkWidget* widget, GdkRectangle* allocation, gpointer data);
+    static void on_scale_factor(GObject* object, GParamSpec* pspec, gpointer data);
+    static gboolean on_resize_settled(gpointer data);
+};
+
+#endif // VIDEO_RENDERER_HPP
@@ -0,0 +1,122 @@
+#include "Visualizer.hpp"
+#include <algorithm>
+
+// Waveform points drawn across the width, at most
+static const size_t WAVEFORM_POINTS = 512;
+
+Visualizer::Visualizer()
+    : widget(nullptr), draw_handler(0), tick_id(0), pipeline(nullptr),
+      samples(SpectrumAnalyzer::FFT_SIZE, 0.0f), has_samples(false) {
+}
+
+Visualizer::~Visualizer() {
+    hide();
+    if (widget) {
+        g_signal_handler_disconnect(widget, draw_handler);
+        g_object_remove_weak_pointer(G_OBJECT(widget), (gpointer*)&widget);
+    }
+}
+
+void Visualizer::set_widget(GtkWidget* new_widget) {
+    widget = new_widget;
+    g_object_add_weak_pointer(G_OBJECT(widget), (gpointer*)&widget);
+    draw_handler = g_signal_connect(widget, "draw", G_CALLBACK(on_draw), this);
+}
+
+bool Visualizer::show(GstElement* new_pipeline) {
+    hide();
+    if (!tap.attach(new_pipeline)) {
+        return false;
+    }
+    pipeline = GST_ELEMENT(gst_object_ref(new_pipeline));
+    analyzer.reset();
+    has_samples = false;
+    if (widget) {
+        gtk_widget_queue_draw(widget);
+    }
+    return true;
+}
+
+void Visualizer::hide() {
+    set_running(false);
+    tap.detach();
+    if (pipeline) {
+        gst_object_unref(pipeline);
+        pipeline = nullptr;
+        if (widget) {
+            gtk_widget_queue_draw(widget);
+        }
+    }
+}
+
+void Visualizer::set_running(bool running) {
+    running = running && pipeline && widget;
+    if (running && !tick_id) {
+        tick_id = gtk_widget_add_tick_callback(widget, on_tick, this, nullptr);
+    } else if (!running && tick_id) {
+        if (widget) {
+            gtk_widget_remove_tick_callback(widget, tick_id);
+        }
+        tick_id = 0;
+    }
+}
+
+// Analyse the block the audio sink is playing now
+void Visualizer::update() {
+    gint64 position = -1;
+    gst_element_query_position(pipeline, GST_FORMAT_TIME, &position);
+    int sample_rate = 0;
+    if (tap.read(position, samples.data(), samples.size(), sample_rate)) {
+        analyzer.analyze(samples.data(), sample_rate);
+        has_samples = true;
+        gtk_widget_queue_draw(widget);
+    }
+}
+
+gboolean Visualizer::on_tick(GtkWidget* widget, GdkFrameClock* clock, gpointer data) {
+    Visualizer* visualizer = static_cast<Visualizer*>(data);
+    visualizer->update();
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean Visualizer::on_draw(GtkWidget* widget, cairo_t* cr, gpointer data) {
+    Visualizer* visualizer = static_cast<Visualizer*>(data);
+    if (!visualizer->visible()) {
+        return FALSE;  // Video: the renderer or the sink draws
+    }
+
+    double width = gtk_widget_get_allocated_width(widget);
+    double height = gtk_widget_get_allocated_height(widget);
+    cairo_set_source_rgb(cr, 0, 0, 0);
+    cairo_paint(cr);
+    if (!visualizer->has_samples) {
+        return TRUE;
+    }
+
+    // Spectrum: bars rising from the bottom, blue (bass) to pink (treble)
+    const std::vector<float>& levels = visualizer->analyzer.levels();
+    double bar_width = width / levels.size();
+    double bar_area = height * 0.6;
+    for (size_t b = 0; b < levels.size(); b++) {
+        double hue = (double)b / levels.size();
+        double bar_height = levels[b] * bar_area;
+        cairo_set_source_rgb(cr, 0.2 + 0.8 * hue, 0.4 + 0.4 * levels[b], 1.0 - 0.4 * hue);
+        cairo_rectangle(cr, b * bar_width + 1, height - bar_height, std::max(1.0, bar_width - 2), bar_height);
+        cairo_fill(cr);
+    }
+
+    // Waveform across the top third
+    const std::vector<float>& samples = visualizer->samples;
+    size_t points = std::min<size_t>(WAVEFORM_POINTS, std::max(2.0, width / 2));
+    size_t step = samples.size() / points;
+    double middle = height * 0.2;
+    double scale = height * 0.18;
+    cairo_set_source_rgb(cr, 0.85, 0.85, 0.9);
+    cairo_set_line_width(cr, 1.5);
+    cairo_move_to(cr, 0, middle - samples[0] * scale);
+    for (size_t i = 1; i < points; i++) {
+        cairo_line_to(cr, i * width / (points - 1), middle - samples[i * step] * scale);
+    }
+    cairo_stroke(cr);
+    return TRUE;
+}
@@ -0,0 +1,48 @@
+#ifndef VISUALIZER_HPP
+#define VISUALIZER_HPP
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <vector>
+#include "AudioTap.hpp"
+#include "Spectrum.hpp"
+
+// Spectrum bars and waveform painted into the video area for files
+// without video. Samples come from an AudioTap on the audio sink. Each
+// frame-clock tick reads the block playing at that moment, analyses it
+// and queues one redraw, so the picture follows the display refresh rate
+// and stops with playback.
+class Visualizer {
+public:
+    Visualizer();
+    ~Visualizer();
+
+    // Connect to widget's "draw" signal; call before VideoRenderer::set_widget
+    // so the visualiser paints first (and alone) while shown
+    void set_widget(GtkWidget* widget);
+
+    // Start drawing for pipeline's audio; false if its sink cannot be tapped
+    bool show(GstElement* pipeline);
+    void hide();
+    bool visible() const { return pipeline != nullptr; }
+
+    // Follow the frame clock while playing; the last picture stays when paused
+    void set_running(bool running);
+
+private:
+    GtkWidget* widget;
+    gulong draw_handler;
+    guint tick_id;
+    GstElement* pipeline;
+    AudioTap tap;
+    SpectrumAnalyzer analyzer;
+    std::vector<float> samples;  // Block last analysed
+    bool has_samples;
+
+    void update();
+
+    static gboolean on_draw(GtkWidget* widget, cairo_t* cr, gpointer data);
+    static gboolean on_tick(GtkWidget* widget, GdkFrameClock* clock, gpointer data);
+};
+
+#endif // VISUALIZER_HPP
@@ -0,0 +1,113 @@
+#include "Benchmark.hpp"
+#include "Logger.hpp"
+#include <gtk/gtk.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+static void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] <media-file>\n"
+              << "  --output <file>         Write JSON results to file (default: stdout)\n"
+              << "  --open-runs <n>         Cold + warm opens to time (default: 5)\n"
+              << "  --seeks <n>             Random seeks per seek mode (default: 50)\n"
+              << "  --decode-seconds <s>    Cap for the sustained decode run (default: 10)\n"
+              << "  --render-seconds <s>    On-screen playback per video output, 0 to skip (default: 10)\n"
+              << "  --rate-seconds <s>      Real-time playback at 1x, 2x and 8x, 0 to skip (default: 10)\n"
+              << "  --switch-runs <n>       File switches timed per mode (rebuild, reuse), 0 to skip (default: 10)\n"
+              << "  --switch-to <file>      Second file of the switch loop (default: the media file)\n"
+              << "  --soak-seconds <s>      Budgeted playback of a synthetic 4K MJPEG stream; fails if\n"
+              << "                          peak RSS goes over the budget (default: 0 = skip)\n"
+              << "  --memory-budget-mb <n>  Memory budget of the soak (default: 512)\n"
+              << "  --loop-runs <n>         Loops per loop mode over a generated clip; fails if a\n"
+              << "                          segment loop leaves a gap (default: 5, 0 to skip)\n"
+              << "  --thread-settings <list> Decoder threads per decode run, e.g. 1,2,4,all,policy\n"
+              << "                          (default: 1,2,4,all,policy; \"none\" to skip)\n";
+}
+
+int main(int argc, char* argv[]) {
+    gst_init(&argc, &argv);
+
+    // Optional: only the render scenarios need a display
+    bool has_display = gtk_init_check(&argc, &argv);
+
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--output" && has_value) {
+            options.output = argv[++i];
+        } else if (arg == "--open-runs" && has_value) {
+            options.open_runs = std::atoi(argv[++i]);
+        } else if (arg == "--seeks" && has_value) {
+            options.seeks = std::atoi(argv[++i]);
+        } else if (arg == "--decode-seconds" && has_value) {
+            options.decode_seconds = std::atof(argv[++i]);
+        } else if (arg == "--render-seconds" && has_value) {
+            options.render_seconds = std::atof(argv[++i]);
+        } else if (arg == "--rate-seconds" && has_value) {
+            options.rate_seconds = std::atof(argv[++i]);
+        } else if (arg == "--switch-runs" && has_value) {
+            options.switch_runs = std::atoi(argv[++i]);
+        } else if (arg == "--switch-to" && has_value) {
+            options.switch_file = argv[++i];
+        } else if (arg == "--soak-seconds" && has_value) {
+            options.soak_seconds = std::atof(argv[++i]);
+        } else if (arg == "--memory-budget-mb" && has_value) {
+            options.memory_budget_mb = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--loop-runs" && has_value) {
+            options.loop_runs = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--thread-settings" && has_value) {
+            options.thread_settings.clear();
+            gchar** items = g_strsplit(argv[++i], ",", -1);
+            for (gchar** item = items; *item; item++) {
+                std::string value = *item;
+                if (value == "all") {
+                    options.thread_settings.push_back(-1);
+                } else if (value == "policy") {
+                    options.thread_settings.push_back(0);
+                } else if (value != "none" && !value.empty()) {
+                    options.thread_settings.push_back(std::max(1, std::atoi(value.c_str())));
+                }
+            }
+            g_strfreev(items);
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.file = arg;
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    options.has_display = has_display;
+
+    if (options.file.empty()) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Pipeline code logs to std::cout; keep stdout clean for the JSON
+    std::ostream json_out(std::cout.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+    Logger::set_output(stderr);
+
+    Benchmark bench(options);
+    bool success = bench.run();
+    std::string json = bench.to_json();
+
+    if (options.output.empty()) {
+        json_out << json << std::flush;
+    } else {
+        std::ofstream out(options.output);
+        out << json;
+        std::cerr << "Results written to " << options.output << std::endl;
+    }
+
+    Logger::shutdown();
+    return success ? 0 : EXIT_FAILURE;
+}
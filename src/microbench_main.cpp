@@ -0,0 +1,213 @@
+#include "Spectrum.hpp"
+#include "Logger.hpp"
+#include "SubtitleTrack.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <functional>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+// Visualiser workload per second of 48 kHz stereo at 60 fps
+static const size_t SAMPLE_RATE = 48000;
+static const size_t ANALYSES_PER_SECOND = 60;
+
+// Mean time of one call in microseconds, repeated for at least min_seconds
+static double time_us(const std::function<void()>& call, double min_seconds) {
+    using clock = std::chrono::steady_clock;
+    call();  // Warm up caches
+    size_t iterations = 0;
+    auto start = clock::now();
+    double elapsed = 0;
+    do {
+        for (int i = 0; i < 16; i++) {
+            call();
+        }
+        iterations += 16;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < min_seconds);
+    return elapsed * 1e6 / iterations;
+}
+
+// Mean cost of one call in nanoseconds, in bursts of burst calls; after
+// each burst (untimed) the logger writes everything out, so every timed
+// call finds room in the ring
+static double time_burst_ns(const std::function<void(int)>& call, int burst, double min_seconds) {
+    using clock = std::chrono::steady_clock;
+    double timed = 0;
+    size_t calls = 0;
+    auto start = clock::now();
+    do {
+        auto burst_start = clock::now();
+        for (int i = 0; i < burst; i++) {
+            call(i);
+        }
+        timed += std::chrono::duration<double>(clock::now() - burst_start).count();
+        calls += burst;
+        Logger::flush();
+    } while (std::chrono::duration<double>(clock::now() - start).count() < min_seconds);
+    return timed * 1e9 / calls;
+}
+
+// Far more than any real file: a line every 2.5 s for almost a day and a
+// half, so a linear scan's cost shows
+static const size_t SUBTITLE_CUES = 50000;
+
+static std::string srt_time(int64_t ms) {
+    char text[16];
+    snprintf(text, sizeof(text), "%02d:%02d:%02d,%03d", (int)(ms / 3600000), (int)(ms / 60000 % 60),
+             (int)(ms / 1000 % 60), (int)(ms % 1000));
+    return text;
+}
+
+// Parsing once on load, then the cue lookup done for every painted frame:
+// stepping through in order as playback does, at random positions as
+// seeks do, with one cue spanning the whole file on top, and against the
+// linear scan the index replaces
+static void bench_subtitles(double min_seconds) {
+    std::ostringstream srt;
+    for (size_t i = 0; i < SUBTITLE_CUES; i++) {
+        int64_t start = i * 2500;
+        srt << i + 1 << "\n" << srt_time(start) << " --> " << srt_time(start + 2000) << "\n"
+            << "<i>Line " << i << "</i> of the dialogue\nand its second line\n\n";
+    }
+    std::string data = srt.str();
+
+    SubtitleTrack track;
+    double parse = time_us([&] { track.parse(data, SubtitleTrack::Format::Srt); }, min_seconds);
+    int64_t span = (int64_t)SUBTITLE_CUES * 2500 * 1000000;
+
+    std::vector<size_t> showing;
+    int64_t step = 0;
+    double sequential = time_us([&] {
+        step = (step + 16666667) % span;  // One 60 fps frame
+        track.active(step, showing);
+    }, min_seconds);
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int64_t> position(0, span);
+    double random = time_us([&] { track.active(position(rng), showing); }, min_seconds);
+    double linear = time_us([&] {
+        int64_t t = position(rng);
+        showing.clear();
+        for (size_t i = 0; i < track.size(); i++) {
+            if (track.cue(i).start <= t && t < track.cue(i).end) {
+                showing.push_back(i);
+            }
+        }
+    }, min_seconds);
+
+    // A logo or sign language cue that runs as long as the file
+    srt << SUBTITLE_CUES + 1 << "\n" << srt_time(0) << " --> " << srt_time(span / 1000000) << "\nLogo\n\n";
+    SubtitleTrack long_track;
+    long_track.parse(srt.str(), SubtitleTrack::Format::Srt);
+    double long_cue = time_us([&] { long_track.active(position(rng), showing); }, min_seconds);
+
+    std::cout << "\nsubtitles (" << track.size() << " cues, " << data.size() / 1024 << " KB)\n"
+              << "  parse (ms)         " << std::setw(10) << parse / 1000 << "\n"
+              << "  lookup, playing (us)" << std::setw(9) << sequential << "\n"
+              << "  lookup, seeking (us)" << std::setw(9) << random << "\n"
+              << "  lookup, long cue (us)" << std::setw(8) << long_cue << "\n"
+              << "  linear scan (us)   " << std::setw(10) << linear << "\n";
+}
+
+// Per-call cost of logging from a hot path, against the flushed std::cout
+// writes it replaces. Output goes to /dev/null, so the synchronous case
+// is a lower bound (a pipe to a busy reader blocks far longer).
+static void bench_logger(double min_seconds) {
+    FILE* null_file = fopen("/dev/null", "w");
+    std::ofstream null_stream("/dev/null");
+    if (!null_file || !null_stream) {
+        std::cerr << "Warning: Could not open /dev/null, skipping logger benchmark" << std::endl;
+        return;
+    }
+    Logger::set_output(null_file);
+    Logger::configure("info");
+    const int burst = Logger::RING_SIZE / 2;
+
+    double sync_ns = time_burst_ns([&](int i) {
+        null_stream << "Volume set to: " << i * 0.5 << "%" << std::endl;
+    }, burst, min_seconds);
+    double disabled_ns = time_burst_ns([](int i) {
+        LOG_DEBUG(Audio, "Volume set to: %g%%", i * 0.5);
+    }, burst, min_seconds);
+    double enabled_ns = time_burst_ns([](int i) {
+        LOG_INFO(Audio, "Volume set to: %g%%", i * 0.5);
+    }, burst, min_seconds);
+    double throttled_ns = time_burst_ns([](int i) {
+        LOG_THROTTLED(Info, Audio, 100, "Volume set to: %g%%", i * 0.5);
+    }, burst, min_seconds);
+
+    std::cout << "\nlogger (ns per call)\n"
+              << "  std::cout + endl   " << std::setw(8) << sync_ns << "\n"
+              << "  LOG disabled       " << std::setw(8) << disabled_ns << "\n"
+              << "  LOG enabled        " << std::setw(8) << enabled_ns << "\n"
+              << "  LOG throttled      " << std::setw(8) << throttled_ns << "\n"
+              << "  dropped records    " << std::setw(8) << Logger::dropped() << "\n";
+
+    Logger::shutdown();
+    Logger::set_output(nullptr);
+    fclose(null_file);
+}
+
+static void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --seconds <s>           Minimum run time per kernel (default: 0.5)\n";
+}
+
+int main(int argc, char* argv[]) {
+    double min_seconds = 0.5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            min_seconds = std::atof(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : EXIT_FAILURE;
+        }
+    }
+
+    // Fixed seed so runs are comparable between releases
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    const size_t n = SpectrumAnalyzer::FFT_SIZE;
+    std::vector<float> stereo(2 * SAMPLE_RATE), mono(SAMPLE_RATE);
+    std::vector<float> block(n), window(n, 0.5f), re(n), im(n), power(n);
+    for (float& sample : stereo) {
+        sample = noise(rng);
+    }
+    for (float& sample : block) {
+        sample = noise(rng);
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "kernels  mix 1s (us)  window (us)  fft " << n << " (us)  power (us)  analyze (us)  core %\n";
+    for (const SpectrumKernels* kernels : SpectrumKernels::available()) {
+        Fft fft(n, *kernels);
+        SpectrumAnalyzer analyzer(64, *kernels);
+
+        double mix = time_us([&] { kernels->mix_stereo(stereo.data(), mono.data(), SAMPLE_RATE); }, min_seconds);
+        double apply = time_us([&] { kernels->apply_window(block.data(), window.data(), re.data(), n); }, min_seconds);
+        double transform = time_us([&] {
+            std::copy(block.begin(), block.end(), re.begin());
+            std::fill(im.begin(), im.end(), 0.0f);
+            fft.transform(re.data(), im.data());
+        }, min_seconds);
+        double squares = time_us([&] { kernels->power(re.data(), im.data(), power.data(), n / 2); }, min_seconds);
+        double analyze = time_us([&] { analyzer.analyze(block.data(), SAMPLE_RATE); }, min_seconds);
+
+        // Share of one core the visualiser's DSP takes during playback
+        double core_percent = (mix + ANALYSES_PER_SECOND * analyze) / 1e6 * 100;
+        std::cout << std::left << std::setw(9) << kernels->name << std::right
+                  << std::setw(12) << mix << std::setw(13) << apply << std::setw(15) << transform
+                  << std::setw(12) << squares << std::setw(14) << analyze << std::setw(8) << core_percent << "\n";
+    }
+
+    bench_logger(min_seconds);
+    bench_subtitles(min_seconds);
+    return 0;
+}